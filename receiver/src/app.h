@@ -3,16 +3,22 @@
 #include <stdint.h>
 #include <memory>
 #include <vector>
+#include <thread>
+#include <atomic>
 
 // Connect all our code together
 #include "demodulator/qam_sync.h"
+#include "demodulator/qam_sync_telemetry.h"
 #include "decoder/frame_decoder.h"
-#include "dsp/iir_filter.h"
+#include "io/raw_iq_reader.h"
+#include "dsp/biquad_filter.h"
 #include "dsp/filter_designer.h"
 #include "audio/frame.h"
 #include "utility/span.h"
 #include "utility/reconstruction_buffer.h"
 #include "utility/observable.h"
+#include "utility/spsc_queue.h"
+#include "utility/profiler.h"
 
 #define PRINT_LOG 1
 #if PRINT_LOG 
@@ -29,8 +35,9 @@ class AudioFilter {
 private:
     const float Fs;
     std::vector<Frame<float>> tmp_buffer;
-    std::unique_ptr<IIR_Filter<Frame<float>>> ac_filter;
-    std::unique_ptr<IIR_Filter<Frame<float>>> notch_filter;
+    // each channel of the frame is filtered in its own simd lane
+    Biquad_Filter_Bank ac_filter;
+    Biquad_Filter_Bank notch_filter;
     std::vector<Frame<float>> output_buffer;
     tcb::span<Frame<float>> output_span;
     ReconstructionBuffer<Frame<float>> output_builder;
@@ -38,22 +45,26 @@ private:
 public:
     AudioFilter(const int _output_length, const float _Fs)
     :   Fs(_Fs),
+        ac_filter(TOTAL_AUDIO_CHANNELS, 1),
+        notch_filter(TOTAL_AUDIO_CHANNELS, 1),
         output_buffer(_output_length),
         output_span(output_buffer),
         output_builder(output_span)
     {
         {
             const int N_ac = TOTAL_TAPS_IIR_AC_COUPLE;
-            ac_filter = std::make_unique<IIR_Filter<Frame<float>>>(N_ac);
-            create_iir_ac_filter(ac_filter->get_b(), ac_filter->get_a(), 0.9999f);
+            float b[N_ac], a[N_ac];
+            create_iir_ac_filter(b, a, 0.9999f);
+            ac_filter.set_section(0, create_biquad_section(b, a, N_ac));
         }
 
         {
             const float k = 50.0f/(Fs/2.0f);
             const float r = 0.9999f;
             const int N_notch = TOTAL_TAPS_IIR_SECOND_ORDER_NOTCH_FILTER;
-            notch_filter = std::make_unique<IIR_Filter<Frame<float>>>(N_notch);
-            create_iir_notch_filter(notch_filter->get_b(), notch_filter->get_a(), k, r);
+            float b[N_notch], a[N_notch];
+            create_iir_notch_filter(b, a, k, r);
+            notch_filter.set_section(0, create_biquad_section(b, a, N_notch));
         }
     }
 
@@ -65,8 +76,9 @@ public:
             tmp_buffer[i] = v;
         }
 
-        ac_filter->process(tmp_buffer.data(), tmp_buffer.data(), N);
-        // notch_filter->process(tmp_buffer.data(), tmp_buffer.data(), N);
+        auto* samples = reinterpret_cast<float*>(tmp_buffer.data());
+        ac_filter.process(samples, samples, N);
+        // notch_filter.process(samples, samples, N);
 
         auto rd_buffer = tcb::span(tmp_buffer);
         while (!rd_buffer.empty()) {
@@ -79,6 +91,16 @@ public:
         }
     }
 
+    // Send out the partially filled block, e.g. when the input has finished
+    void Flush() {
+        if (output_builder.IsEmpty()) {
+            return;
+        }
+        const auto block = tcb::span<const Frame<float>>(output_buffer).first(output_builder.Length());
+        obs_on_output_block.Notify(block);
+        output_builder.Reset();
+    }
+
     int GetOutputBufferSize() { return (int)output_buffer.size(); }
     auto GetOutputBuffer() { return tcb::span(output_buffer); }
     auto& OnOutputBlock() { return obs_on_output_block; }
@@ -112,6 +134,7 @@ public:
     bool is_output_data = false;
 private:
     AudioFilter& audio;
+    Observable<tcb::span<const uint8_t>> obs_on_payload;
 public: 
     FrameHandler(AudioFilter& _audio)
     : audio(_audio) {}
@@ -142,6 +165,7 @@ public:
             if (payload.decoded_error > 0) {
                 stats.repaired++;
             }
+            obs_on_payload.Notify({payload.buf, payload.length});
             if (payload.length == AUDIO_PACKET_BLOCK_SIZE) {
                 if (is_output_audio) {
                     audio.ProcessFrame(payload.buf, payload.length);
@@ -159,6 +183,17 @@ public:
             break;
         }
     }
+
+    // Called with the data of every correctly decoded payload
+    auto& OnPayload() { return obs_on_payload; }
+};
+
+// Block of demodulated symbols passed from the demodulator to the decoder
+struct SymbolBlock {
+    std::vector<std::complex<float>> symbols;
+    int length = 0;
+    SymbolBlock(const int capacity): symbols(capacity) {}
+    auto GetSymbols() { return tcb::span(symbols).first(length); }
 };
 
 // Connect our code together into a cohesive 16QAM receiver
@@ -168,15 +203,23 @@ public:
     QAM_Synchroniser_Specification qam_sync_spec;
     struct {
         bool rebuild = false;
-        bool snapshot = false;
     } controls;
     bool is_read_loop = false;
-    bool is_running = true;
+    std::atomic<bool> is_running = true;
+    // Run the reader, demodulator and decoder on separate threads
+    bool is_pipelined = false;
+    int nb_pipeline_blocks = 4;
 private:
-    FILE* rx_fp;
+    std::unique_ptr<RawIQ_Reader> rx_reader;
+    int rd_total_blocks = 0;
+    const int demod_block_size;
+    const int ds_factor;
+    const int us_factor;
+    const bool is_telemetry;
     std::unique_ptr<ConstellationSpecification> constellation;
     std::unique_ptr<QAM_Synchroniser_Buffer> active_buffer;
-    std::unique_ptr<QAM_Synchroniser_Buffer> snapshot_buffer;
+    // reduced telemetry for the gui which is only created if the buffers have telemetry
+    std::unique_ptr<QAM_Synchroniser_Telemetry> telemetry;
 
     std::unique_ptr<QAM_Synchroniser> qam_sync;
     std::unique_ptr<FrameDecoder> frame_decoder;
@@ -184,14 +227,20 @@ private:
     std::unique_ptr<AudioFilter> audio_filter;
 public:
     App(
-        FILE* _rx_fp, const int demod_block_size,
-        const int decoder_block_size, const int ds_factor, const int us_factor,
-        const int audio_block_size, const float F_audio) 
-    : rx_fp(_rx_fp)
+        std::unique_ptr<RawIQ_Reader> _rx_reader, const int _demod_block_size,
+        const int decoder_block_size, const int _ds_factor, const int _us_factor,
+        const int audio_block_size, const float F_audio,
+        const bool _is_telemetry=true) 
+    : rx_reader(std::move(_rx_reader)), 
+      demod_block_size(_demod_block_size), 
+      ds_factor(_ds_factor), us_factor(_us_factor),
+      is_telemetry(_is_telemetry)
     {
         constellation = std::make_unique<SquareConstellation>(4);
-        active_buffer = std::make_unique<QAM_Synchroniser_Buffer>(demod_block_size, ds_factor, us_factor);
-        snapshot_buffer = std::make_unique<QAM_Synchroniser_Buffer>(demod_block_size, ds_factor, us_factor);
+        active_buffer = std::make_unique<QAM_Synchroniser_Buffer>(demod_block_size, ds_factor, us_factor, is_telemetry);
+        if (is_telemetry) {
+            telemetry = std::make_unique<QAM_Synchroniser_Telemetry>();
+        }
 
         {
             const uint32_t preamble_code = 0b11111001101011111100110101101101;
@@ -213,42 +262,118 @@ public:
         // NOTE: Demodulator has to be built by user
     }
     void Run() {
+        if (is_pipelined) {
+            RunPipelined();
+            return;
+        }
+
         is_running = true;
-        int rd_total_blocks = 0;
+        rd_total_blocks = 0;
         while (is_running) {
             // read baseband
-            auto rx_buffer = active_buffer->x_raw;
-            auto rx_length = active_buffer->GetInputSize();
-            size_t rd_block_size = fread(rx_buffer.data(), sizeof(std::complex<uint8_t>), rx_length, rx_fp);
-            if (rd_block_size != rx_length) {
-                LOG_MESSAGE("Got mismatched block size after %d blocks\n", rd_total_blocks);
-                if (is_read_loop) {
-                    fseek(rx_fp, 0, 0);
-                    continue;
+            {
+                PROFILE_BEGIN(read);
+                if (!ReadBlock(*(active_buffer.get()))) {
+                    break;
                 }
-                break;
             }
-            rd_total_blocks++; 
 
             // Run decoder chain
+            int nb_symbols = 0;
             if (qam_sync) {
-                const int nb_symbols = qam_sync->ProcessBlock(*(active_buffer.get()));
+                PROFILE_BEGIN(demodulate);
+                nb_symbols = qam_sync->ProcessBlock(*(active_buffer.get()));
+                PROFILE_END(demodulate);
+                PROFILE_BEGIN(decode);
                 auto syms = active_buffer->y_out.first(nb_symbols);
-                for (auto& sym: syms) {
-                    auto res = frame_decoder->process(sym);
-                    auto payload = frame_decoder->GetPayload();
-                    audio_frame_handler->OnFrameResult(res, payload);
+                DecodeSymbols(syms);
+                PROFILE_END(decode);
+            }
+
+            PublishTelemetry(*(active_buffer.get()), nb_symbols);
+            UpdateControls();
+        }
+    }
+    // Pipeline our receiver so that each stage runs on its own core
+    // Reader --> [raw IQ buffers] --> Demodulator --> [symbol blocks] --> Decoder
+    // Stages are joined by lock free queues of preallocated blocks
+    // This way a slow read or a burst of Viterbi decoding doesn't stall the demodulator
+    void RunPipelined() {
+        is_running = true;
+        rd_total_blocks = 0;
+
+        const int nb_blocks = nb_pipeline_blocks;
+        auto raw_queue = std::make_unique<SPSC_Queue<QAM_Synchroniser_Buffer>>(
+            nb_blocks, demod_block_size, ds_factor, us_factor, is_telemetry);
+        const int max_symbols = (int)active_buffer->y_out.size();
+        auto symbol_queue = std::make_unique<SPSC_Queue<SymbolBlock>>(
+            nb_blocks, max_symbols);
+
+        auto reader_thread = std::thread([this, &raw_queue]() {
+            PROFILE_TAG_THREAD("reader");
+            while (is_running) {
+                auto* buffer = raw_queue->AcquireWrite();
+                if (buffer == NULL) {
+                    break;
+                }
+                PROFILE_BEGIN(read);
+                if (!ReadBlock(*buffer)) {
+                    break;
                 }
+                PROFILE_END(read);
+                raw_queue->ReleaseWrite();
             }
+            raw_queue->Close();
+        });
+
+        auto demod_thread = std::thread([this, &raw_queue, &symbol_queue]() {
+            PROFILE_TAG_THREAD("demodulator");
+            while (true) {
+                auto* buffer = raw_queue->AcquireRead();
+                if (buffer == NULL) {
+                    break;
+                }
+                auto* block = symbol_queue->AcquireWrite();
+                if (block == NULL) {
+                    break;
+                }
+
+                block->length = 0;
+                if (qam_sync) {
+                    PROFILE_BEGIN(demodulate);
+                    const int nb_symbols = qam_sync->ProcessBlock(*buffer);
+                    auto syms = buffer->y_out.first(nb_symbols);
+                    std::copy_n(syms.begin(), nb_symbols, block->symbols.begin());
+                    block->length = nb_symbols;
+                }
 
-            if (ReadFlag(controls.snapshot)) {
-                snapshot_buffer->CopyFrom(*(active_buffer.get()));
+                // Demodulator is owned by this thread so we handle controls here
+                PublishTelemetry(*buffer, block->length);
+                UpdateControls();
+
+                raw_queue->ReleaseRead();
+                symbol_queue->ReleaseWrite();
             }
+            symbol_queue->Close();
+        });
 
-            if (ReadFlag(controls.rebuild)) {
-                BuildDemodulator();
+        // Decoder and audio output run on the calling thread
+        while (true) {
+            auto* block = symbol_queue->AcquireRead();
+            if (block == NULL) {
+                break;
             }
+            PROFILE_BEGIN(decode);
+            DecodeSymbols(block->GetSymbols());
+            PROFILE_END(decode);
+            symbol_queue->ReleaseRead();
         }
+
+        // Unblock the upstream stages if we exited early
+        raw_queue->Close();
+        symbol_queue->Close();
+        reader_thread.join();
+        demod_thread.join();
     }
     void Stop() {
         is_running = false;
@@ -258,10 +383,58 @@ public:
     }
 public:
     auto& GetActiveBuffer() { return *(active_buffer.get()); }
-    auto& GetSnapshotBuffer() { return *(snapshot_buffer.get()); }
+    // NOTE: Only valid if the app was created with telemetry
+    auto& GetTelemetry() { return *(telemetry.get()); }
+    bool HasTelemetry() const { return telemetry != NULL; }
     auto& GetAudioFilter() { return *(audio_filter.get()); }
     auto& GetFrameHandler() { return *(audio_frame_handler.get()); }
+    // Number of raw IQ samples demodulated in the last call to Run
+    int64_t GetTotalSamplesRead() { return (int64_t)rd_total_blocks * (int64_t)active_buffer->GetInputSize(); }
 private:
+    // Return false if we couldn't read a full block
+    // NOTE: The reader can point x_raw into its own memory instead of copying into the buffer
+    bool ReadBlock(QAM_Synchroniser_Buffer& buffer) {
+        auto rx_buffer = buffer.GetInputBuffer();
+        auto rx_length = buffer.GetInputSize();
+        while (is_running) {
+            auto rx_block = rx_reader->Read(rx_buffer);
+            if (rx_block.size() == rx_length) {
+                buffer.x_raw = rx_block;
+                rd_total_blocks++; 
+                return true;
+            }
+
+            LOG_MESSAGE("Got mismatched block size after %d blocks\n", rd_total_blocks);
+            if (!is_read_loop) {
+                break;
+            }
+            if (!rx_reader->Rewind()) {
+                LOG_MESSAGE("Input can't be rewound for looped reading\n");
+                break;
+            }
+        }
+        return false;
+    }
+
+    void DecodeSymbols(tcb::span<const std::complex<float>> syms) {
+        const auto events = frame_decoder->ProcessBlock(syms);
+        for (auto& ev: events) {
+            audio_frame_handler->OnFrameResult(ev.result, ev.payload);
+        }
+    }
+
+    void PublishTelemetry(const QAM_Synchroniser_Buffer& buffer, const int nb_symbols) {
+        if (telemetry) {
+            telemetry->Publish(buffer, nb_symbols);
+        }
+    }
+
+    void UpdateControls() {
+        if (ReadFlag(controls.rebuild)) {
+            BuildDemodulator();
+        }
+    }
+
     bool ReadFlag(bool& flag) {
         const bool rv = flag;
         flag = false;
@@ -7,17 +7,41 @@ AudioMixer::AudioMixer(const int _block_size)
 : block_size(_block_size)
 {
     output_gain = 1.0f;
+    total_input_buffers = 0;
     mixer_buf.resize(block_size);
 }
 
 std::shared_ptr<RingBuffer<Frame<float>>> AudioMixer::CreateManagedBuffer(const int nb_blocks) 
 {
+    auto lock = std::scoped_lock(mutex_create_buffer);
+    const int i = total_input_buffers.load(std::memory_order_relaxed);
+    if (i >= MAX_INPUT_BUFFERS) {
+        return nullptr;
+    }
     auto buf = std::make_shared<RingBuffer<Frame<float>>>(block_size, nb_blocks);
-    auto lock = std::scoped_lock(mutex_buffers);
-    input_buffers.push_back(buf);
+    input_buffers[i] = buf;
+    total_input_buffers.store(i+1, std::memory_order_release);
     return buf;
 }
 
+uint64_t AudioMixer::GetTotalUnderruns() const {
+    const int M = total_input_buffers.load(std::memory_order_acquire);
+    uint64_t total = 0;
+    for (int i = 0; i < M; i++) {
+        total += input_buffers[i]->GetTotalUnderruns();
+    }
+    return total;
+}
+
+uint64_t AudioMixer::GetTotalOverruns() const {
+    const int M = total_input_buffers.load(std::memory_order_acquire);
+    uint64_t total = 0;
+    for (int i = 0; i < M; i++) {
+        total += input_buffers[i]->GetTotalOverruns();
+    }
+    return total;
+}
+
 template <typename T>
 inline Frame<T> clamp(const Frame<T> X, const T min, const T max) {
     Frame<T> Y;
@@ -31,42 +55,36 @@ inline Frame<T> clamp(const Frame<T> X, const T min, const T max) {
 }
 
 tcb::span<Frame<float>> AudioMixer::UpdateMixer() {
-
-    auto lock = std::scoped_lock(mutex_buffers);
-    for (auto& input_buffer: input_buffers) {
-        // Early exit check so we don't incur overhead acquire mutex for each buffer
-        if (input_buffer->GetTotalBlocks() == 0) {
+    const int M = total_input_buffers.load(std::memory_order_acquire);
+    int total_sources = 0;
+    for (int i = 0; i < M; i++) {
+        auto& input_buffer = input_buffers[i];
+        auto rd_buf = input_buffer->PeekBlock();
+        if (rd_buf.empty()) {
             continue;
         }
-
-        auto scoped_buf = input_buffer->PopBlock();
-        if (scoped_buf.buf.empty()) {
-            continue;
-        }
-
-        pending_buffers.push_back(std::move(scoped_buf));
+        pending_blocks[total_sources++] = { input_buffer.get(), rd_buf };
     }
 
-    const int total_sources = (int)pending_buffers.size();
-
+    std::memset(mixer_buf.data(), 0, mixer_buf.size()*sizeof(Frame<float>));
     if (total_sources == 0) {
-        std::memset(mixer_buf.data(), 0, mixer_buf.size() * sizeof(Frame<float>));
         return mixer_buf;
     }
 
-    std::memset(mixer_buf.data(), 0, mixer_buf.size()*sizeof(Frame<float>));
     const int N = (int)mixer_buf.size();
 
-    float scale = output_gain; 
+    float scale = output_gain.load(std::memory_order_relaxed); 
     // TODO: I'm not an audio engineer I have no idea how to mix audio properly
     //       Replace with existing audio DSP libraries
     scale /= std::log10((float)(total_sources * 10.0f));
 
-    for (auto& pending_buffer: pending_buffers) {
-        auto rd_buf = pending_buffer.buf;
+    // Release each block once mixed so the producer can reuse it
+    for (int j = 0; j < total_sources; j++) {
+        auto& pending = pending_blocks[j];
         for (int i = 0; i < N; i++) {
-            mixer_buf[i] += rd_buf[i] * scale;
+            mixer_buf[i] += pending.buf[i] * scale;
         }
+        pending.source->ReleaseBlock();
     }
 
     // Clamp audio to prevent clipping
@@ -75,6 +93,5 @@ tcb::span<Frame<float>> AudioMixer::UpdateMixer() {
         mixer_buf[i] = clamp(mixer_buf[i], -max_amplitude, max_amplitude);
     }
 
-    pending_buffers.clear();
     return mixer_buf;
 }
\ No newline at end of file
@@ -4,22 +4,39 @@
 #include "ring_buffer.h"
 #include "utility/span.h"
 #include <stdint.h>
+#include <array>
+#include <atomic>
 #include <vector>
 #include <memory>
 #include <mutex>
 
+// Mixes blocks from each managed ring buffer into one output block
+// UpdateMixer() is called from the audio callback and never blocks
+// Buffers are appended to a fixed size list and published by an atomic count
 class AudioMixer 
 {
+public:
+    static constexpr int MAX_INPUT_BUFFERS = 8;
 private:
-    float output_gain;
-    std::vector<std::shared_ptr<RingBuffer<Frame<float>>>> input_buffers;
+    std::atomic<float> output_gain;
+    std::array<std::shared_ptr<RingBuffer<Frame<float>>>, MAX_INPUT_BUFFERS> input_buffers;
+    std::atomic<int> total_input_buffers;
+    struct PendingBlock {
+        RingBuffer<Frame<float>>* source = nullptr;
+        tcb::span<const Frame<float>> buf;
+    };
+    std::array<PendingBlock, MAX_INPUT_BUFFERS> pending_blocks;
     std::vector<Frame<float>> mixer_buf;
-    std::vector<RingBuffer<Frame<float>>::scoped_buffer_t> pending_buffers;
     const int block_size;
-    std::mutex mutex_buffers;
+    // only taken when adding buffers
+    std::mutex mutex_create_buffer;
 public:
     AudioMixer(const int _block_size=2);
+    // return nullptr if there are already MAX_INPUT_BUFFERS buffers
     std::shared_ptr<RingBuffer<Frame<float>>> CreateManagedBuffer(const int nb_blocks);
     tcb::span<Frame<float>> UpdateMixer();
-    float& GetOutputGain() { return output_gain; };
-};
\ No newline at end of file
+    std::atomic<float>& GetOutputGain() { return output_gain; };
+    // sum of the counters of each managed buffer
+    uint64_t GetTotalUnderruns() const;
+    uint64_t GetTotalOverruns() const;
+};
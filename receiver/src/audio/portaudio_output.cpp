@@ -80,7 +80,8 @@ int PortAudio_Output::paCallbackMethod(
         return paAbort;
     }
 
-    auto pa_lock = std::scoped_lock(mutex_pa_stream);
+    // NOTE: The stream is only opened or closed by Pa_*Stream() which wait for the callback to return
+    //       So we don't lock here since blocking the audio thread causes dropouts
     auto rd_buf = mixer.UpdateMixer();
 
     if (frames_per_block != rd_buf.size()) {
@@ -2,6 +2,7 @@
 
 #include "utility/span.h"
 #include "audio_mixer.h"
+#include <atomic>
 #include <mutex>
 #include <portaudio.h>
 
@@ -13,7 +14,8 @@ public:
     PaStream* pa_stream;
     PaDeviceIndex pa_selected_device;
 
-    bool is_running;
+    // read by the callback which never takes mutex_pa_stream
+    std::atomic<bool> is_running;
     std::mutex mutex_pa_stream;
 
     const int frames_per_block;
@@ -1,149 +1,137 @@
 #pragma once
 
 #include <stdint.h>
-#include <mutex>
-#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <vector>
 #include <algorithm>
 #include "utility/span.h"
 
+// Wait free single producer single consumer ring of fixed size blocks
+// The producer writes samples into the block at the write index and publishes it once full
+// The consumer reads the block at the read index and releases it once it is done with it
+// Each side only stores to its own index so neither side ever takes a lock
+// NOTE: Only one thread can be the producer and only one thread can be the consumer
 template <typename T>
 class RingBuffer
 {
-public:
-    struct scoped_buffer_t {
-        std::unique_lock<std::mutex> lock;
-        tcb::span<const T> buf;
-        scoped_buffer_t(std::mutex& _mutex, tcb::span<const T> _buf) 
-        : lock(_mutex), buf(_buf) {}
-    };
 private:
+    const int block_size;
+    const int nb_max_blocks;
     std::vector<T> blocks_buf;
-    // fill write block
-    int curr_wr_block_index;
-
-    int curr_rd_block;
-    int curr_wr_block;
-    int nb_blocks;
-    int block_size;
-    int nb_max_blocks;
-
-    std::mutex mutex_rw;
-    std::condition_variable cv_nb_total_blocks;
+    // monotonic block counters where index % nb_max_blocks is the slot
+    alignas(64) std::atomic<uint32_t> rd_index;
+    alignas(64) std::atomic<uint32_t> wr_index;
+    // owned by the producer
+    alignas(64) int curr_wr_block_offset;
+    // owned by the consumer so that a run of empty peeks is counted as one underrun
+    alignas(64) bool is_rd_empty;
+    // counters are read by any thread
+    alignas(64) std::atomic<uint64_t> total_underruns;
+    std::atomic<uint64_t> total_overruns;
+    std::atomic<bool> is_primed;
 public:
-    RingBuffer(const int _block_size, const int _nb_max_blocks) {
-        block_size = _block_size;
-        nb_max_blocks = _nb_max_blocks;
-
-        curr_wr_block_index = 0;
-        curr_rd_block = 0;
-        curr_wr_block = 0;
-        nb_blocks = 0;
-
-        blocks_buf.resize(block_size*nb_max_blocks);
-    }
-
-    void SetMaxBlocks(const int _nb_max_blocks) {
-        auto lock = std::scoped_lock(mutex_rw);
-        if (nb_max_blocks == _nb_max_blocks) {
-            return;
-        }
-        nb_max_blocks = _nb_max_blocks;
-
-        blocks_buf.resize(block_size*nb_max_blocks);
-        curr_wr_block_index = 0;
-        curr_rd_block = 0;
-        curr_wr_block = 0;
-        nb_blocks = 0;
+    RingBuffer(const int _block_size, const int _nb_max_blocks)
+    : block_size(_block_size), nb_max_blocks(_nb_max_blocks),
+      blocks_buf(_block_size*_nb_max_blocks)
+    {
+        rd_index = 0;
+        wr_index = 0;
+        curr_wr_block_offset = 0;
+        is_rd_empty = false;
+        total_underruns = 0;
+        total_overruns = 0;
+        is_primed = false;
     }
-
-    void SetBlockSize(const int _block_size) {
-        auto lock = std::scoped_lock(mutex_rw);
-        if (block_size == _block_size) {
-            return;
-        }
-        block_size = _block_size;
-
-        blocks_buf.resize(block_size*nb_max_blocks);
-        curr_wr_block_index = 0;
-        curr_rd_block = 0;
-        curr_wr_block = 0;
-        nb_blocks = 0;
-
+    RingBuffer(RingBuffer&) = delete;
+    RingBuffer(RingBuffer&&) = delete;
+    RingBuffer& operator=(RingBuffer&) = delete;
+    RingBuffer& operator=(RingBuffer&&) = delete;
+
+    int GetBlockSize() const { return block_size; }
+    int GetMaxBlocks() const { return nb_max_blocks; }
+    int GetTotalBlocks() const {
+        return (int)(wr_index.load(std::memory_order_acquire) - rd_index.load(std::memory_order_acquire));
     }
-
-    int GetTotalBlocks() const { return nb_blocks; }
-
+    size_t GetTotalBlockBytes() const { return block_size * sizeof(T); }
+    // number of times the consumer ran out of blocks after the first block was written
+    // Consecutive empty peeks are counted once until a block arrives again
+    uint64_t GetTotalUnderruns() const { return total_underruns.load(std::memory_order_relaxed); }
+    // number of times input samples were dropped since the ring was full
+    uint64_t GetTotalOverruns() const { return total_overruns.load(std::memory_order_relaxed); }
+
+    // Producer: copy samples into the ring
+    // If blocking we wait for the consumer to free a block up to a timeout, which paces the producer
+    // Otherwise or if the timeout expires the remaining samples are dropped and counted as an overrun
     void ConsumeBuffer(tcb::span<const T> buf, const bool is_blocking=true) {
-        auto lock = std::unique_lock(mutex_rw);
         const int N = (int)buf.size();
-
-        int curr_byte = 0;
-        while (curr_byte < N) {
-            if (is_blocking && (nb_blocks >= nb_max_blocks)) {
-                const auto max_delay = std::chrono::duration<float>(1.0f);
-                cv_nb_total_blocks.wait_for(lock, max_delay, [this]() {
-                    return (nb_blocks < nb_max_blocks);
-                });
+        int curr_sample = 0;
+        while (curr_sample < N) {
+            const uint32_t wr = wr_index.load(std::memory_order_relaxed);
+            if ((curr_wr_block_offset == 0) && !WaitForFreeBlock(wr, is_blocking)) {
+                total_overruns.fetch_add(1, std::memory_order_relaxed);
+                return;
             }
 
-            const int nb_remain = (N-curr_byte);
-
-            tcb::span<const T> rd_buf = { 
-                &buf[curr_byte], 
-                (size_t)nb_remain 
-            };        
-
-            const int nb_required = block_size-curr_wr_block_index;
-            tcb::span<T> wr_buf = { 
-                &blocks_buf[curr_wr_block*block_size + curr_wr_block_index], 
-                (size_t)nb_required
-            };
-
-            const int nb_copy = (nb_required > nb_remain) ? nb_remain : nb_required;
-            std::copy_n(rd_buf.begin(), nb_copy, wr_buf.begin());
-            curr_wr_block_index += nb_copy;
-            curr_byte += nb_copy;
-
-            if (curr_wr_block_index >= block_size) {
-                curr_wr_block_index = 0;
-                curr_wr_block = (curr_wr_block+1)%nb_max_blocks;
-                nb_blocks++;
-                if (nb_blocks > nb_max_blocks) {
-                    nb_blocks = nb_max_blocks;
-                }
+            const int nb_remain = N-curr_sample;
+            const int nb_required = block_size-curr_wr_block_offset;
+            const int nb_copy = std::min(nb_required, nb_remain);
+            T* wr_buf = &blocks_buf[(wr % nb_max_blocks)*block_size + curr_wr_block_offset];
+            std::copy_n(&buf[curr_sample], nb_copy, wr_buf);
+            curr_wr_block_offset += nb_copy;
+            curr_sample += nb_copy;
+
+            if (curr_wr_block_offset >= block_size) {
+                curr_wr_block_offset = 0;
+                wr_index.store(wr+1, std::memory_order_release);
+                is_primed.store(true, std::memory_order_relaxed);
             }
         }
     }
 
-    scoped_buffer_t PopBlock() {
-        auto scoped_buf = scoped_buffer_t(mutex_rw, {});
-        if (nb_blocks == 0) {
-            return scoped_buf;
+    // Consumer: oldest full block or empty if there are none
+    // The block belongs to the consumer until it is released
+    tcb::span<const T> PeekBlock() {
+        const uint32_t rd = rd_index.load(std::memory_order_relaxed);
+        const uint32_t wr = wr_index.load(std::memory_order_acquire);
+        if (rd == wr) {
+            if (!is_rd_empty && is_primed.load(std::memory_order_relaxed)) {
+                is_rd_empty = true;
+                total_underruns.fetch_add(1, std::memory_order_relaxed);
+            }
+            return {};
         }
-
-        tcb::span<const T> rd_buf = {  
-            &blocks_buf[curr_rd_block*block_size],
-            (size_t)block_size
-        };
-        curr_rd_block = (curr_rd_block+1)%nb_max_blocks;
-        nb_blocks--;
-        cv_nb_total_blocks.notify_one();
-
-        scoped_buf.buf = rd_buf; 
-        return scoped_buf;
+        is_rd_empty = false;
+        return { &blocks_buf[(rd % nb_max_blocks)*block_size], (size_t)block_size };
     }
 
-    void Reset() {
-        auto lock = std::scoped_lock(mutex_rw);
-        curr_wr_block_index = 0;
-        curr_rd_block = 0;
-        curr_wr_block = 0;
-        nb_blocks = 0;
-        cv_nb_total_blocks.notify_one();
+    // Consumer: return the block acquired by PeekBlock() to the producer
+    void ReleaseBlock() {
+        const uint32_t rd = rd_index.load(std::memory_order_relaxed);
+        rd_index.store(rd+1, std::memory_order_release);
     }
-
-    size_t GetTotalBlockBytes() {
-        return block_size * sizeof(T);
+private:
+    bool WaitForFreeBlock(const uint32_t wr, const bool is_blocking) {
+        auto is_free = [this, wr]() {
+            return (wr - rd_index.load(std::memory_order_acquire)) < (uint32_t)nb_max_blocks;
+        };
+        if (is_free()) {
+            return true;
+        }
+        if (!is_blocking) {
+            return false;
+        }
+        // poll since the consumer is not allowed to signal us
+        const auto max_delay = std::chrono::duration<float>(1.0f);
+        const auto poll_delay = std::chrono::milliseconds(1);
+        const auto start = std::chrono::steady_clock::now();
+        while ((std::chrono::steady_clock::now() - start) < max_delay) {
+            std::this_thread::sleep_for(poll_delay);
+            if (is_free()) {
+                return true;
+            }
+        }
+        return false;
     }
-};
\ No newline at end of file
+};
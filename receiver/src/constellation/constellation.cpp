@@ -1,7 +1,9 @@
 #include "constellation.h"
+#include "dsp/simd/c32_slice_square.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <assert.h>
 constexpr float PI = (float)M_PI;
 
 SquareConstellation::SquareConstellation(const int _L)
@@ -10,10 +12,20 @@ SquareConstellation::SquareConstellation(const int _L)
     constellation.resize(N);
     phase_lookup.resize(N);
     gray_code.resize(N);
+    axis_levels.resize(L);
+    axis_gray_code.resize(L);
 
     const float offset = (L-1)/2.0f;
     const float scale = 1.0f/std::sqrt(2.0f) * 1.0f/offset * 0.5f;
 
+    for (int i = 0; i < L; i++) {
+        axis_levels[i] = 2.0f * ((float)i - offset) * scale;
+    }
+    // Normalise llr so that a bit on an ideal symbol is at least 1
+    // Adjacent levels are 2*scale apart
+    axis_llr_norm = 1.0f / (4.0f*scale*scale);
+    axis_step_inv = 1.0f / (2.0f*scale);
+
     for (int i = 0; i < L; i++) {
         const float I = 2.0f * ((float)i - offset);
         for (int j = 0; j < L; j++) {
@@ -36,31 +48,73 @@ SquareConstellation::SquareConstellation(const int _L)
         for (uint8_t q = 0; q < L; q++) {
             uint8_t I = _gray_code[i];
             uint8_t Q = _gray_code[q];
-            uint8_t idx = (i<<2) | q;
+            uint8_t idx = i*L + q;
             uint8_t sym = (I<<2) | Q;
             gray_code[idx] = sym;
         }
     }
+    for (int i = 0; i < L; i++) {
+        axis_gray_code[i] = _gray_code[i];
+    }
 
     m_avg_power = CalculateAveragePower(constellation.data(), N);
 }
 
 SquareConstellation::~SquareConstellation() = default;
 
+// For a square constellation the nearest symbol is the nearest level on each axis
 uint8_t SquareConstellation::GetNearestSymbol(const std::complex<float> x) {
-    float min_err = INFINITY;
-    uint8_t best_match = 0;
-
-    for (uint8_t i = 0; i < N; i++) {
-        auto err_vec = constellation[i]-x;
-        auto err = std::abs(err_vec);
-        if (err < min_err) {
-            best_match = i;
-            min_err = err;
-        }
+    uint8_t y = 0;
+    c32_slice_square_scalar(&x, &y, 1, axis_step_inv, L, gray_code.data());
+    return y;
+}
+
+void SquareConstellation::GetNearestSymbols(tcb::span<const std::complex<float>> x, tcb::span<uint8_t> y) {
+    const int N = (int)x.size();
+    assert((int)y.size() >= N);
+    c32_slice_square_auto(x.data(), y.data(), N, axis_step_inv, L, gray_code.data());
+}
+
+// Symbol is given as [I gray code | Q gray code]
+void SquareConstellation::GetSoftBits(const std::complex<float> x, float* llr) {
+    const int nb_axis_bits = GetBitsPerSymbol()/2;
+    GetAxisSoftBits(x.real(), &llr[0]);
+    GetAxisSoftBits(x.imag(), &llr[nb_axis_bits]);
+}
+
+void SquareConstellation::GetSoftBits(tcb::span<const std::complex<float>> x, tcb::span<float> llr) {
+    const int N = (int)x.size();
+    const int nb_bits = GetBitsPerSymbol();
+    assert((int)llr.size() >= N*nb_bits);
+    const int nb_axis_bits = nb_bits/2;
+    for (int i = 0; i < N; i++) {
+        float* y = &llr[i*nb_bits];
+        GetAxisSoftBits(x[i].real(), &y[0]);
+        GetAxisSoftBits(x[i].imag(), &y[nb_axis_bits]);
     }
+}
 
-    return gray_code[best_match];
+// Max-log approximation of the log likelihood ratio
+// llr = min(|x-c0|^2) - min(|x-c1|^2)
+// Where c0 and c1 are the closest levels whose gray code has a 0 or 1 in that bit
+void SquareConstellation::GetAxisSoftBits(const float x, float* llr) {
+    const int nb_axis_bits = GetBitsPerSymbol()/2;
+    for (int i = 0; i < nb_axis_bits; i++) {
+        const int shift = nb_axis_bits-1-i;
+        float min_dist_0 = INFINITY;
+        float min_dist_1 = INFINITY;
+        for (int j = 0; j < L; j++) {
+            const float e = x - axis_levels[j];
+            const float dist = e*e;
+            const bool bit = ((axis_gray_code[j] >> shift) & 0b1) != 0;
+            if (bit) {
+                min_dist_1 = (dist < min_dist_1) ? dist : min_dist_1;
+            } else {
+                min_dist_0 = (dist < min_dist_0) ? dist : min_dist_0;
+            }
+        }
+        llr[i] = (min_dist_0 - min_dist_1) * axis_llr_norm;
+    }
 }
 
 float SquareConstellation::CalculateAveragePower(const std::complex<float>* C, const int N) {
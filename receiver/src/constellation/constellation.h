@@ -3,6 +3,7 @@
 #include <complex>
 #include <vector>
 #include <stdint.h>
+#include "utility/span.h"
 
 class ConstellationSpecification {
 public:
@@ -14,6 +15,14 @@ public:
     virtual int GetSize() = 0;
     virtual int GetBitsPerSymbol() = 0;
     virtual uint8_t GetNearestSymbol(const std::complex<float> x) = 0;
+    // Slice a block of symbols, y must hold x.size() values
+    virtual void GetNearestSymbols(tcb::span<const std::complex<float>> x, tcb::span<uint8_t> y) = 0;
+    // Soft decision of each bit of the gray coded symbol in msb first order
+    // llr must hold GetBitsPerSymbol() values 
+    // Positive means the bit is more likely to be 1, negative means 0
+    virtual void GetSoftBits(const std::complex<float> x, float* llr) = 0;
+    // Soft decision bits of a block of symbols, llr must hold x.size()*GetBitsPerSymbol() values
+    virtual void GetSoftBits(tcb::span<const std::complex<float>> x, tcb::span<float> llr) = 0;
     virtual float GetAveragePower() = 0; 
 };
 
@@ -24,6 +33,11 @@ private:
     std::vector<std::complex<float>> constellation;
     std::vector<float> phase_lookup;
     std::vector<uint8_t> gray_code;
+    // each axis is independently gray coded so we can demap them separately
+    std::vector<float> axis_levels;
+    std::vector<uint8_t> axis_gray_code;
+    float axis_step_inv;
+    float axis_llr_norm;
     float m_avg_power;
 public:
     // L = number of symbols along one axis
@@ -36,8 +50,12 @@ public:
     virtual int GetBitsPerSymbol() { return L; };
     virtual float GetAveragePower() { return m_avg_power; }; 
     virtual uint8_t GetNearestSymbol(const std::complex<float> x);
+    virtual void GetNearestSymbols(tcb::span<const std::complex<float>> x, tcb::span<uint8_t> y);
+    virtual void GetSoftBits(const std::complex<float> x, float* llr);
+    virtual void GetSoftBits(tcb::span<const std::complex<float>> x, tcb::span<float> llr);
 private:
     float CalculateAveragePower(const std::complex<float>* C, const int N);
+    void GetAxisSoftBits(const float x, float* llr);
 };
 
 // return the errors of the best match in constellation
@@ -1,5 +1,7 @@
 #include "frame_decoder.h"
 #include <assert.h>
+#include <cmath>
+#include <algorithm>
 
 #include "preamble_detector.h"
 #include "additive_scrambler.h"
@@ -12,21 +14,23 @@ FrameDecoder::FrameDecoder(
     const uint32_t preamble_word,
     const uint16_t scrambler_syncword, 
     const uint8_t conv_poly[2],
-    const uint8_t crc8_poly)
+    const uint8_t crc8_poly,
+    const int preamble_max_bit_errors)
 : buffer_size(_buffer_size),
   constellation(_constellation)
 {
     state = State::WAIT_BLOCK_SIZE;
 
     constexpr int TOTAL_PHASES = 4;
-    preamble_detector = std::make_unique<PreambleDetector>(preamble_word, TOTAL_PHASES);
+    preamble_detector = std::make_unique<PreambleDetector>(
+        preamble_word, constellation, TOTAL_PHASES, preamble_max_bit_errors);
     descrambler = std::make_unique<AdditiveScrambler>(scrambler_syncword);
 
     vitdec = std::make_unique<ViterbiDecoder>(conv_poly, buffer_size*8);
     crc8_calc = std::make_unique<CRC8_Calculator>(crc8_poly);
 
-    descramble_buffer.resize(buffer_size);
-    encoded_buffer.resize(buffer_size);
+    symbol_llr.resize(constellation.GetBitsPerSymbol());
+    encoded_buffer.resize(buffer_size*8);
     decoded_buffer.resize(buffer_size);
 }
 
@@ -38,22 +42,136 @@ FrameDecoder::ProcessResult FrameDecoder::process(const std::complex<float> IQ)
     }
 
     const auto phase_shift = preamble_detector->GetPhase();
-    const uint8_t x = constellation.GetNearestSymbol(IQ * phase_shift);
-    const int nb_bits = constellation.GetBitsPerSymbol();
+    constellation.GetSoftBits(IQ * phase_shift, symbol_llr.data());
 
     auto res = ProcessResult::NONE;
     switch (state) {
     case State::WAIT_BLOCK_SIZE:
-        return process_await_block_size(x, nb_bits);
+        return process_await_block_size(symbol_llr);
         break;
     case State::WAIT_PAYLOAD:
-        return process_await_payload(x, nb_bits);
+        return process_await_payload(symbol_llr);
         break;
     default:
         return ProcessResult::NONE;
     }
 }
 
+tcb::span<const FrameDecoder::Event> FrameDecoder::ProcessBlock(tcb::span<const std::complex<float>> x) {
+    nb_events = 0;
+
+    const int N = (int)x.size();
+    int i = 0;
+    while (i < N) {
+        if (state == State::WAIT_PREAMBLE) {
+            auto res = ProcessResult::NONE;
+            i += process_preamble_block(x.subspan(i), res);
+            if (res != ProcessResult::NONE) {
+                push_event(res, i-1);
+            }
+            continue;
+        }
+
+        // We know exactly how many symbols we need before the next state change
+        const int nb_symbols = std::min(get_remaining_symbols(), N-i);
+        const auto res = process_symbols(x.subspan(i, nb_symbols));
+        i += nb_symbols;
+        if (res != ProcessResult::NONE) {
+            push_event(res, i-1);
+        }
+    }
+
+    return { events.data(), (size_t)nb_events };
+}
+
+int FrameDecoder::process_preamble_block(tcb::span<const std::complex<float>> x, ProcessResult& res) {
+    // Don't slice too far ahead since the preamble could be found early in the block
+    const int N = std::min((int)x.size(), max_preamble_block);
+    if (N > (int)block_sliced.size()) {
+        block_sliced.resize(N);
+    }
+
+    // The preamble detector checks all phases so we only slice once
+    auto sliced = tcb::span(block_sliced).first(N);
+    constellation.GetNearestSymbols(x.first(N), sliced);
+
+    res = ProcessResult::NONE;
+    for (int i = 0; i < N; i++) {
+        const bool is_found = preamble_detector->Process(sliced[i]);
+        if (is_found) {
+            state = State::WAIT_BLOCK_SIZE;
+            payload.reset();
+            res = ProcessResult::PREAMBLE_FOUND;
+            return i+1;
+        }
+    }
+    return N;
+}
+
+FrameDecoder::ProcessResult FrameDecoder::process_symbols(tcb::span<const std::complex<float>> x) {
+    const int N = (int)x.size();
+    const int nb_bits = constellation.GetBitsPerSymbol();
+    if (N > (int)block_symbols.size()) {
+        block_symbols.resize(N);
+        block_llr.resize(N*nb_bits);
+    }
+
+    const auto phase_shift = preamble_detector->GetPhase();
+    for (int i = 0; i < N; i++) {
+        block_symbols[i] = x[i] * phase_shift;
+    }
+
+    auto llr = tcb::span(block_llr).first(N*nb_bits);
+    constellation.GetSoftBits(tcb::span(block_symbols).first(N), llr);
+
+    switch (state) {
+    case State::WAIT_BLOCK_SIZE:
+        return process_await_block_size(llr);
+    case State::WAIT_PAYLOAD:
+        return process_await_payload(llr);
+    default:
+        return ProcessResult::NONE;
+    }
+}
+
+int FrameDecoder::get_remaining_symbols() {
+    int total_bytes = 0;
+    switch (state) {
+    case State::WAIT_BLOCK_SIZE:
+        total_bytes = nb_bytes_for_block_size;
+        break;
+    case State::WAIT_PAYLOAD:
+        total_bytes = encoded_block_size;
+        break;
+    default:
+        return 1;
+    }
+
+    const int nb_bits = constellation.GetBitsPerSymbol();
+    const int remaining_bits = total_bytes*8 - (encoded_bytes*8 + encoded_bits);
+    const int remaining_symbols = (remaining_bits + nb_bits - 1) / nb_bits;
+    return std::max(remaining_symbols, 1);
+}
+
+void FrameDecoder::push_event(const ProcessResult res, const int symbol_index) {
+    if (nb_events >= (int)events.size()) {
+        events.resize(nb_events+1);
+    }
+
+    auto& ev = events[nb_events++];
+    ev.result = res;
+    ev.payload = payload;
+    ev.symbol_index = symbol_index;
+    // decoded buffer is reused by the next frame in the block so we keep a copy
+    if ((payload.buf != NULL) && (payload.length > 0)) {
+        ev.payload_data.assign(payload.buf, payload.buf + payload.length);
+        ev.payload.buf = ev.payload_data.data();
+    } else {
+        ev.payload_data.clear();
+        ev.payload.buf = NULL;
+    }
+}
+
 FrameDecoder::ProcessResult FrameDecoder::process_await_preamble(const std::complex<float> IQ) {
     auto res = preamble_detector->Process(IQ, constellation);
     if (!res) {
@@ -65,8 +183,8 @@ FrameDecoder::ProcessResult FrameDecoder::process_await_preamble(const std::comp
     return ProcessResult::PREAMBLE_FOUND;
 }
 
-FrameDecoder::ProcessResult FrameDecoder::process_await_block_size(const uint8_t x, const int nb_bits) {
-    process_decoder_bits(x, nb_bits);
+FrameDecoder::ProcessResult FrameDecoder::process_await_block_size(tcb::span<const float> llr) {
+    process_decoder_bits(llr);
 
     // Get block size once we have enough bytes decoded
     bool is_done = 
@@ -81,7 +199,7 @@ FrameDecoder::ProcessResult FrameDecoder::process_await_block_size(const uint8_t
     assert(nb_bytes_for_block_size <= buffer_size);
     assert(nb_decoded_bytes <= buffer_size );
 
-    vitdec->Update({ &encoded_buffer[0], (size_t)nb_bytes_for_block_size });
+    vitdec->Update({ &encoded_buffer[0], (size_t)(nb_bytes_for_block_size*8) });
     vitdec->GetTraceback({ &decoded_buffer[0], (size_t)nb_decoded_bytes });
     decoded_bytes += nb_decoded_bytes;
 
@@ -108,8 +226,8 @@ FrameDecoder::ProcessResult FrameDecoder::process_await_block_size(const uint8_t
     }
 }
 
-FrameDecoder::ProcessResult FrameDecoder::process_await_payload(const uint8_t x, const int nb_bits) {
-    process_decoder_bits(x, nb_bits);
+FrameDecoder::ProcessResult FrameDecoder::process_await_payload(tcb::span<const float> llr) {
+    process_decoder_bits(llr);
     bool is_done = 
         (encoded_bytes >= encoded_block_size) &&
         (encoded_bits == 0);
@@ -127,7 +245,7 @@ FrameDecoder::ProcessResult FrameDecoder::process_await_payload(const uint8_t x,
     assert(nb_encoded_bytes <= buffer_size);
     assert((encoded_block_size/CODE_RATE) <= buffer_size);
 
-    vitdec->Update({ &encoded_buffer[nb_bytes_for_block_size], (size_t)nb_encoded_bytes });
+    vitdec->Update({ &encoded_buffer[nb_bytes_for_block_size*8], (size_t)(nb_encoded_bytes*8) });
     vitdec->GetTraceback({ &decoded_buffer[0], (size_t)(encoded_block_size/CODE_RATE) });
     decoded_bytes += nb_decoded_bytes;
 
@@ -166,23 +284,32 @@ FrameDecoder::ProcessResult FrameDecoder::process_await_payload(const uint8_t x,
     }
 }
 
-void FrameDecoder::process_decoder_bits(const uint8_t x, const int nb_bits) {
-    if (encoded_bits == 0) {
-        descramble_buffer[encoded_bytes] = 0;
+void FrameDecoder::process_decoder_bits(tcb::span<const float> llr) {
+    const int nb_bits = (int)llr.size();
+    assert((encoded_bytes*8 + encoded_bits + nb_bits) <= buffer_size*8);
+
+    for (int i = 0; i < nb_bits; i++) {
+        // The scrambler XORs each byte with a mask
+        // For soft decision bits this is the same as flipping the sign
+        if (encoded_bits == 0) {
+            descramble_mask = descrambler->process(0x00);
+        }
+
+        const int shift = 7-encoded_bits;
+        const bool is_flip = ((descramble_mask >> shift) & 0b1) != 0;
+        float v = llr[i] * llr_scale;
+        v = is_flip ? -v : v;
+        v = (v > (float)SOFT_DECISION_VITERBI_HIGH) ? (float)SOFT_DECISION_VITERBI_HIGH : v;
+        v = (v < (float)SOFT_DECISION_VITERBI_LOW)  ? (float)SOFT_DECISION_VITERBI_LOW  : v;
+        encoded_buffer[encoded_bytes*8 + encoded_bits] = (viterbi_bit_t)std::round(v);
+        encoded_bits++;
+
+        // move onto next byte
+        if (encoded_bits == 8) {
+            encoded_bits = 0;
+            encoded_bytes += 1;
+        }
     }
-
-    const int shift = 8-encoded_bits-nb_bits;
-    descramble_buffer[encoded_bytes] |= (x << shift);
-    encoded_bits += nb_bits;
-    
-    // if a byte has been processed, then unscramble and move onto next byte
-    if (encoded_bits == 8) {
-        encoded_bits = 0;
-        encoded_buffer[encoded_bytes] = descrambler->process(descramble_buffer[encoded_bytes]);
-        encoded_bytes += 1;
-    }
-
-    assert(encoded_bytes <= buffer_size);
 }
 
 void FrameDecoder::reset() {
@@ -4,6 +4,8 @@
 #include <complex>
 #include <memory>
 #include <vector>
+#include "utility/span.h"
+#include "viterbi_config.h"
 
 class ConstellationSpecification;
 class PreambleDetector;
@@ -13,7 +15,7 @@ class CRC8_Calculator;
 
 // Decodes a encoded payload 
 // payload --> FEC --> Scrambler --> Preamble --> TX
-// TX --> Preamble detector -> Descrambler --> Viterbi decoder --> payload
+// TX --> Preamble detector -> Soft demapper --> Descrambler --> Viterbi decoder --> payload
 // Where payload has the format
 // int16_t: length N
 // uint8_t[N]: payload data
@@ -51,6 +53,14 @@ public:
             decoded_error = -1;
         }
     };
+    // Result from processing a block of symbols
+    // The payload buffer is owned by the event so it is valid until the next block
+    struct Event {
+        ProcessResult result;
+        Payload payload;
+        int symbol_index;  // symbol in the block which produced this result
+        std::vector<uint8_t> payload_data;
+    };
 private:
     ConstellationSpecification& constellation;
     std::unique_ptr<PreambleDetector> preamble_detector;
@@ -59,9 +69,12 @@ private:
     std::unique_ptr<CRC8_Calculator> crc8_calc;
     // internal buffers for decoding
     const int buffer_size;
-    std::vector<uint8_t> descramble_buffer;
-    std::vector<uint8_t> encoded_buffer;
+    std::vector<float> symbol_llr;
+    std::vector<viterbi_bit_t> encoded_buffer; // soft decision bits
     std::vector<uint8_t> decoded_buffer;
+    uint8_t descramble_mask = 0;
+    // scale llr so that the most confident bits of a 16QAM symbol saturate
+    const float llr_scale = (float)SOFT_DECISION_VITERBI_HIGH / 4.0f;
     // keep track of position in buffers
     int encoded_bits = 0;
     int encoded_bytes = 0;
@@ -72,6 +85,13 @@ private:
     int encoded_block_size = 0; 
     State state;
     Payload payload;
+    // block processing
+    std::vector<std::complex<float>> block_symbols;
+    std::vector<float> block_llr;
+    std::vector<uint8_t> block_sliced;
+    const int max_preamble_block = 64;
+    std::vector<Event> events;
+    int nb_events = 0;
 public:
     FrameDecoder(
         const int _buffer_size, 
@@ -79,18 +99,30 @@ public:
         const uint32_t preamble_word,
         const uint16_t scrambler_syncword, 
         const uint8_t conv_poly[2],
-        const uint8_t crc8_poly);
+        const uint8_t crc8_poly,
+        const int preamble_max_bit_errors=0);
     ~FrameDecoder();
     ProcessResult process(const std::complex<float> IQ);
+    // Process a block of symbols and return all non empty results
+    // Symbols after the preamble are phase corrected and demapped in runs instead of individually
+    tcb::span<const Event> ProcessBlock(tcb::span<const std::complex<float>> x);
     inline State GetState() { return state; }
     inline Payload GetPayload() { return payload; }
 private:
     ProcessResult process_await_preamble(const std::complex<float> IQ);
+    // Slice the block and search for the preamble on all phases
+    // Returns the number of symbols consumed
+    int process_preamble_block(tcb::span<const std::complex<float>> x, ProcessResult& res);
+    // Demap a run of symbols which doesn't go past the end of the current state
+    ProcessResult process_symbols(tcb::span<const std::complex<float>> x);
+    // Number of symbols until the current state is complete
+    int get_remaining_symbols();
+    void push_event(const ProcessResult res, const int symbol_index);
     // Decode the block size so we can anticipate when to stop decoding
-    ProcessResult process_await_block_size(const uint8_t x, const int nb_bits);
+    ProcessResult process_await_block_size(tcb::span<const float> llr);
     // Decode the rest of the payload after block size is known
-    ProcessResult process_await_payload(const uint8_t x, const int nb_bits); 
-    // Construct individual bytes for processing from bits
-    void process_decoder_bits(const uint8_t x, const int nb_bits); 
+    ProcessResult process_await_payload(tcb::span<const float> llr); 
+    // Quantise and descramble soft decision bits for the viterbi decoder
+    void process_decoder_bits(tcb::span<const float> llr); 
     void reset();
 };
\ No newline at end of file
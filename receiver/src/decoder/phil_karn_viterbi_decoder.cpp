@@ -312,3 +312,182 @@ void update_viterbi_blk_scalar(vitdec_t* vp, const COMPUTETYPE *syms, const int
         vp->new_metrics = tmp;
     }
 }
+
+#if defined(VITDEC_SSE2) || defined(VITDEC_AVX2)
+// NOTE: The SIMD kernels are specialised for K=3 which has 4 states
+//       These fit in the lower half of a 128bit register so all butterflies are done at once
+static_assert(NUMSTATES == 4, "SIMD viterbi kernels only support a constraint length of 3");
+
+// Pick components of b where mask is set, otherwise pick from a
+static inline __m128i select_epi16(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a));
+}
+
+static inline __m128i abs_epi16(__m128i x) {
+    return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+// Branch error for each new state j which is reached from old state j/2
+// [e0, max-e0, e1, max-e1] where ei = |BranchTable[:].buf[i] - syms[:]|
+static inline __m128i branch_error_sse2(
+    const COMPUTETYPE* syms, __m128i bt0, __m128i bt1, 
+    __m128i max_error, __m128i odd_mask) 
+{
+    const __m128i s0 = _mm_set1_epi16(syms[0]);
+    const __m128i s1 = _mm_set1_epi16(syms[1]);
+    const __m128i e0 = _mm_srai_epi16(abs_epi16(_mm_sub_epi16(bt0, s0)), METRICSHIFT);
+    const __m128i e1 = _mm_srai_epi16(abs_epi16(_mm_sub_epi16(bt1, s1)), METRICSHIFT);
+    const __m128i e = _mm_srai_epi16(_mm_add_epi16(e0, e1), PRECISIONSHIFT);
+    return select_epi16(odd_mask, e, _mm_sub_epi16(max_error, e));
+}
+
+// Add compare select for all states using the same rules as BFLY
+// new[j] is reached from either old[j/2] or old[j/2 + NUMSTATES/2]
+// The branch from old[j/2 + NUMSTATES/2] has the complementary error max-e
+static inline __m128i ACS_sse2(__m128i old_metrics, __m128i branch_error, __m128i max_error, decision_t* d) {
+    // [o0 o0 o1 o1]
+    const __m128i a_metrics = _mm_shufflelo_epi16(old_metrics, _MM_SHUFFLE(1,1,0,0));
+    // [o2 o2 o3 o3]
+    const __m128i b_metrics = _mm_shufflelo_epi16(old_metrics, _MM_SHUFFLE(3,3,2,2));
+    const __m128i a = _mm_add_epi16(a_metrics, branch_error);
+    const __m128i b = _mm_add_epi16(b_metrics, _mm_sub_epi16(max_error, branch_error));
+    // decision is set if the path from old[j/2 + NUMSTATES/2] survives
+    const __m128i decision = _mm_cmpgt_epi16(a, b);
+    // pack 16bit masks to 8bit masks so we get 1 bit per state
+    d->buf[0] = (DECISIONTYPE)(_mm_movemask_epi8(_mm_packs_epi16(decision, decision)) & 0x0F);
+    return _mm_min_epi16(a, b);
+}
+
+static inline __m128i renormalize_sse2(__m128i x, COMPUTETYPE threshold) {
+    if ((COMPUTETYPE)_mm_extract_epi16(x, 0) <= threshold) {
+        return x;
+    }
+    // minimum of the 4 states broadcast to each state
+    __m128i min = _mm_min_epi16(x, _mm_shufflelo_epi16(x, _MM_SHUFFLE(1,0,3,2)));
+    min = _mm_min_epi16(min, _mm_shufflelo_epi16(min, _MM_SHUFFLE(2,3,0,1)));
+    return _mm_sub_epi16(x, min);
+}
+
+struct ACS_Constants {
+    __m128i bt0;
+    __m128i bt1;
+    __m128i max_error;
+    __m128i odd_mask;
+    ACS_Constants(const vitdec_t* vp) {
+        const auto* b0 = vp->BranchTable[0].buf;
+        const auto* b1 = vp->BranchTable[1].buf;
+        const COMPUTETYPE max = ((CODE_RATE * (vp->soft_decision_max_error >> METRICSHIFT)) >> PRECISIONSHIFT);
+        bt0 = _mm_setr_epi16(b0[0], b0[0], b0[1], b0[1], 0, 0, 0, 0);
+        bt1 = _mm_setr_epi16(b1[0], b1[0], b1[1], b1[1], 0, 0, 0, 0);
+        max_error = _mm_set1_epi16(max);
+        odd_mask = _mm_setr_epi16(0, -1, 0, -1, 0, 0, 0, 0);
+    }
+};
+
+// Write back metrics so that they are in the same state as the scalar code
+// old_metrics holds the latest metrics and new_metrics holds the previous metrics
+static inline void store_metrics_sse2(vitdec_t* vp, __m128i curr, __m128i prev) {
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(vp->old_metrics->buf), curr);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(vp->new_metrics->buf), prev);
+}
+#endif
+
+#if defined(VITDEC_SSE2)
+void update_viterbi_blk_sse2(vitdec_t* vp, const COMPUTETYPE *syms, const int nbits) {
+    if (nbits <= 0) {
+        return;
+    }
+
+    decision_t* d = &vp->decisions[vp->curr_decoded_bit];
+    const auto c = ACS_Constants(vp);
+
+    __m128i curr = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vp->old_metrics->buf));
+    __m128i prev = curr;
+
+    for (int s = 0; s < nbits; s++) {
+        const __m128i e = branch_error_sse2(&syms[s*CODE_RATE], c.bt0, c.bt1, c.max_error, c.odd_mask);
+        prev = curr;
+        curr = ACS_sse2(curr, e, c.max_error, d);
+        curr = renormalize_sse2(curr, RENORMALIZE_THRESHOLD);
+        d++;
+    }
+
+    vp->curr_decoded_bit += nbits;
+    store_metrics_sse2(vp, curr, prev);
+}
+#endif
+
+#if defined(VITDEC_AVX2)
+void update_viterbi_blk_avx2(vitdec_t* vp, const COMPUTETYPE *syms, const int nbits) {
+    if (nbits <= 0) {
+        return;
+    }
+
+    decision_t* d = &vp->decisions[vp->curr_decoded_bit];
+    const auto c = ACS_Constants(vp);
+
+    // The add-compare-select is a serial dependency between bits
+    // So we use the wider registers to calculate branch errors for 4 bits at once
+    // Each 128bit lane holds the errors for 2 bits
+    constexpr int K_BITS = 4;
+    const __m256i bt0 = _mm256_broadcastsi128_si256(_mm_unpacklo_epi64(c.bt0, c.bt0));
+    const __m256i bt1 = _mm256_broadcastsi128_si256(_mm_unpacklo_epi64(c.bt1, c.bt1));
+    const __m256i max_error = _mm256_set1_epi16(_mm_extract_epi16(c.max_error, 0));
+    // Broadcast each symbol across the 4 states of its bit
+    // syms = [x0 y0 x1 y1 x2 y2 x3 y3] as 16bit values
+    const __m256i shuffle_x = _mm256_setr_epi8(
+        0,1,0,1,0,1,0,1, 4,5,4,5,4,5,4,5,
+        8,9,8,9,8,9,8,9, 12,13,12,13,12,13,12,13);
+    const __m256i shuffle_y = _mm256_setr_epi8(
+        2,3,2,3,2,3,2,3, 6,7,6,7,6,7,6,7,
+        10,11,10,11,10,11,10,11, 14,15,14,15,14,15,14,15);
+
+    ALIGNED(ALIGN_AMOUNT) COMPUTETYPE branch_errors[K_BITS*NUMSTATES];
+
+    __m128i curr = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vp->old_metrics->buf));
+    __m128i prev = curr;
+
+    const int M = nbits/K_BITS;
+    for (int i = 0; i < M; i++) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&syms[i*K_BITS*CODE_RATE]));
+        const __m256i s2 = _mm256_broadcastsi128_si256(s);
+        const __m256i x = _mm256_shuffle_epi8(s2, shuffle_x);
+        const __m256i y = _mm256_shuffle_epi8(s2, shuffle_y);
+        const __m256i e0 = _mm256_srai_epi16(_mm256_abs_epi16(_mm256_sub_epi16(bt0, x)), METRICSHIFT);
+        const __m256i e1 = _mm256_srai_epi16(_mm256_abs_epi16(_mm256_sub_epi16(bt1, y)), METRICSHIFT);
+        __m256i e = _mm256_srai_epi16(_mm256_add_epi16(e0, e1), PRECISIONSHIFT);
+        // [e0, max-e0, e1, max-e1]
+        e = _mm256_blend_epi16(e, _mm256_sub_epi16(max_error, e), 0b10101010);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(branch_errors), e);
+
+        for (int j = 0; j < K_BITS; j++) {
+            const __m128i ej = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&branch_errors[j*NUMSTATES]));
+            prev = curr;
+            curr = ACS_sse2(curr, ej, c.max_error, d);
+            curr = renormalize_sse2(curr, RENORMALIZE_THRESHOLD);
+            d++;
+        }
+    }
+
+    for (int s = M*K_BITS; s < nbits; s++) {
+        const __m128i e = branch_error_sse2(&syms[s*CODE_RATE], c.bt0, c.bt1, c.max_error, c.odd_mask);
+        prev = curr;
+        curr = ACS_sse2(curr, e, c.max_error, d);
+        curr = renormalize_sse2(curr, RENORMALIZE_THRESHOLD);
+        d++;
+    }
+
+    vp->curr_decoded_bit += nbits;
+    store_metrics_sse2(vp, curr, prev);
+}
+#endif
+
+void update_viterbi_blk_auto(vitdec_t* vp, const COMPUTETYPE *syms, const int nbits) {
+    #if defined(VITDEC_AVX2)
+    update_viterbi_blk_avx2(vp, syms, nbits);
+    #elif defined(VITDEC_SSE2)
+    update_viterbi_blk_sse2(vp, syms, nbits);
+    #else
+    update_viterbi_blk_scalar(vp, syms, nbits);
+    #endif
+}
@@ -21,6 +21,15 @@ struct vitdec_t;
 #define INITIAL_START_ERROR     0        // Initial error of initial state
 #define INITIAL_NON_START_ERROR (0+3000) // Initial error of non-initial states
 
+// Enable intrinsic code that can be compiled on target
+#if defined(__AVX2__)
+#define VITDEC_AVX2
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define VITDEC_SSE2
+#endif
+
 vitdec_t* create_viterbi(
     const uint8_t polys[CODE_RATE], const int len, 
     const COMPUTETYPE soft_decision_high, const COMPUTETYPE soft_decision_low);
@@ -30,6 +39,16 @@ void init_viterbi(vitdec_t* vp, int starting_state);
 
 // Scalar code: 1x speed
 void update_viterbi_blk_scalar(vitdec_t* vp, const COMPUTETYPE* syms, const int nbits);
+// All 4 states are updated with a single add-compare-select 
+#if defined(VITDEC_SSE2)
+void update_viterbi_blk_sse2(vitdec_t* vp, const COMPUTETYPE* syms, const int nbits);
+#endif
+// Branch metrics are calculated for 4 bits at a time before add-compare-select
+#if defined(VITDEC_AVX2)
+void update_viterbi_blk_avx2(vitdec_t* vp, const COMPUTETYPE* syms, const int nbits);
+#endif
+// Use the fastest implementation available on target
+void update_viterbi_blk_auto(vitdec_t* vp, const COMPUTETYPE* syms, const int nbits);
 
 /* Viterbi chainback */
 void chainback_viterbi(
@@ -1,46 +1,105 @@
 #include "preamble_detector.h"
+#include <assert.h>
+
+// Count the number of bits set without needing compiler intrinsics
+static inline int count_bits(uint32_t x) {
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+    return (int)((x * 0x01010101u) >> 24);
+}
+
+PreambleDetector::PreambleDetector(
+    const uint32_t _preamble,
+    ConstellationSpecification& constellation,
+    const int _total_phases,
+    const int _max_bit_errors)
+: total_phases(_total_phases),
+  nb_bits_per_symbol(constellation.GetBitsPerSymbol()),
+  max_bit_errors(_max_bit_errors)
+{
+    assert(total_phases <= MAX_PHASES);
+    assert(nb_bits_per_symbol <= 8);
 
-PreambleDetector::PreambleDetector(const int32_t _preamble, const int _total_phases) 
-: total_phases(_total_phases) {
     const float PI = 3.1415f;
 
-    preamble_filters.reserve(total_phases);
-    preamble_phases.resize(total_phases);
+    // only compare whole symbols
+    const int nb_symbols = 32 / nb_bits_per_symbol;
+    preamble_length = nb_symbols * nb_bits_per_symbol;
+    preamble_mask = (preamble_length == 32) ? 0xFFFFFFFFu : ((1u << preamble_length) - 1u);
+
+    // Map each symbol in the constellation to the symbol it becomes after rotating by each phase
+    const int nb_symbol_values = 1 << nb_bits_per_symbol;
+    const int nb_points = constellation.GetSize();
+    auto* points = constellation.GetSymbols();
+    std::vector<uint8_t> inverse_lut(nb_symbol_values);
 
+    preamble_phases.resize(total_phases);
     for (int i = 0; i < total_phases; i++) {
-        auto filter = std::make_unique<VariablePreambleFilter<uint32_t>>(_preamble);
-        preamble_filters.push_back(std::move(filter));
         // phase = k*2*PI/M
         const float phase = 2.0f*PI/(float)(total_phases) * (float)(i);
-        preamble_phases[i] = std::complex<float>(std::cos(phase), std::sin(phase));
+        const auto phase_shift = std::complex<float>(std::cos(phase), std::sin(phase));
+        preamble_phases[i] = phase_shift;
+
+        for (int j = 0; j < nb_symbol_values; j++) {
+            inverse_lut[j] = (uint8_t)j;
+        }
+        for (int j = 0; j < nb_points; j++) {
+            const uint8_t sym = constellation.GetNearestSymbol(points[j]);
+            const uint8_t sym_rotated = constellation.GetNearestSymbol(points[j] * phase_shift);
+            inverse_lut[sym_rotated] = sym;
+        }
+
+        // A received symbol sym matches the preamble on this phase if lut[sym] == preamble symbol
+        // Equivalently sym == inverse_lut[preamble symbol], so we precompute that
+        uint32_t word = 0;
+        for (int j = 0; j < nb_symbols; j++) {
+            const int shift = j*nb_bits_per_symbol;
+            const uint8_t sym = (_preamble >> shift) & (nb_symbol_values-1);
+            word |= uint32_t(inverse_lut[sym]) << shift;
+        }
+        phase_preambles[i] = word;
     }
+
+    Reset();
+}
+
+void PreambleDetector::Reset() {
+    reg = 0;
+    bits_since_preamble = 0;
+}
+
+bool PreambleDetector::Process(const std::complex<float> IQ, ConstellationSpecification& constellation)
+{
+    return Process(constellation.GetNearestSymbol(IQ));
 }
 
-bool PreambleDetector::Process(const std::complex<float> IQ, ConstellationSpecification& constellation) 
+bool PreambleDetector::Process(const uint8_t sym)
 {
-    const int bits_per_symbol = constellation.GetBitsPerSymbol();
-    bits_since_preamble += bits_per_symbol;
+    const uint32_t sym_mask = (1u << nb_bits_per_symbol) - 1u;
+    reg = (reg << nb_bits_per_symbol) | (uint32_t(sym) & sym_mask);
+    bits_since_preamble += nb_bits_per_symbol;
 
-    int total_preambles_found = 0;
+    // Check all phases without branching and keep the best match
+    uint32_t found_mask = 0;
+    int best_phase = 0;
+    int best_errors = preamble_length+1;
     for (int i = 0; i < total_phases; i++) {
-        auto& filter = preamble_filters[i];
-        auto IQ_phi = IQ * preamble_phases[i];
-        auto sym = constellation.GetNearestSymbol(IQ_phi);
-        const bool res = filter->process(sym, bits_per_symbol);
-        if (!res) {
-            continue;
-        }
-
-        selected_phase = i;
-        total_preambles_found += 1;
-        desync_bitcount = bits_since_preamble - filter->get_length();
+        const int errors = count_bits((reg ^ phase_preambles[i]) & preamble_mask);
+        const bool is_found = errors <= max_bit_errors;
+        const bool is_better = errors < best_errors;
+        found_mask |= uint32_t(is_found) << i;
+        best_phase = is_better ? i : best_phase;
+        best_errors = is_better ? errors : best_errors;
     }
 
-    if (total_preambles_found > 0) {
-        phase_conflict = (total_preambles_found > 1);
-        bits_since_preamble = 0;
-        return true;
+    if (found_mask == 0) {
+        return false;
     }
 
-    return false;
-}
\ No newline at end of file
+    selected_phase = best_phase;
+    phase_conflict = (found_mask & (found_mask-1)) != 0;
+    desync_bitcount = bits_since_preamble - preamble_length;
+    bits_since_preamble = 0;
+    return true;
+}
@@ -1,32 +1,48 @@
 #pragma once
 #include <complex>
 #include <vector>
-#include <memory>
+#include <stdint.h>
 
-#include "preamble_filter.h"
 #include "constellation/constellation.h"
 
-// Consists of a bank of:
-// 1. preamble filters
-// 2. possible phase shifts
-// The purpose of the preamble detector is to find the preamble on the correct phase
+// Searches for the preamble on all possible phases of the constellation
 // There are multiple potential locked phases for a M-PSK or a QAM signal
 // For M-PSK there are M possible phases: k*2*PI/M where k=[1,M]
 // For M-QAM there are 4 possible phases: 0, PI/2, PI, -PI/2
+// For a gray coded constellation rotating by one of these phases maps each symbol onto another symbol
+// Instead of slicing the received symbol once per phase we slice it once into a shift register
+// and compare it against the preamble mapped into each phase
 class PreambleDetector {
+public:
+    static constexpr int MAX_PHASES = 8;
 private:
-    std::vector<std::unique_ptr<PreambleFilter>> preamble_filters;
+    const int total_phases;
+    const int nb_bits_per_symbol;
+    const int max_bit_errors;
+    int preamble_length; // number of bits compared
+    uint32_t preamble_mask;
+    uint32_t reg = 0;
+    // preamble as it would be sliced if the signal was rotated by the inverse of each phase
+    uint32_t phase_preambles[MAX_PHASES];
     std::vector<std::complex<float>> preamble_phases;
     int bits_since_preamble = 0;
-    const int total_phases;
     int selected_phase = 0;
     bool phase_conflict = false;
     int desync_bitcount = 0;
 public:
-    PreambleDetector(const int32_t _preamble, const int _total_phases);
+    // max_bit_errors = number of bits in the preamble which can be wrong and still be detected
+    PreambleDetector(
+        const uint32_t _preamble,
+        ConstellationSpecification& constellation,
+        const int _total_phases,
+        const int _max_bit_errors=0);
     bool Process(const std::complex<float> IQ, ConstellationSpecification& constellation);
+    // Process a symbol which has already been sliced without any phase correction
+    bool Process(const uint8_t sym);
+    void Reset();
     bool IsPhaseConflict() { return phase_conflict; }
     std::complex<float> GetPhase() { return preamble_phases[selected_phase]; }
     int GetPhaseIndex() { return selected_phase; }
     int GetDesyncBitcount() { return desync_bitcount; }
-};
\ No newline at end of file
+    int GetLength() { return preamble_length; }
+};
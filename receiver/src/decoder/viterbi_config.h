@@ -9,6 +9,7 @@
 // NOTE: int16_t is in the decoding stage since it stores the accumulated error metric which would overflow with int8
 // NOTE: we are using a global typedef since using templates would blow out compile times
 typedef int8_t viterbi_bit_t;
-static constexpr viterbi_bit_t SOFT_DECISION_VITERBI_HIGH      = +1;
-static constexpr viterbi_bit_t SOFT_DECISION_VITERBI_LOW       = -1;
+// NOTE: We use the full range so soft decisions from the demapper keep their resolution
+static constexpr viterbi_bit_t SOFT_DECISION_VITERBI_HIGH      = +127;
+static constexpr viterbi_bit_t SOFT_DECISION_VITERBI_LOW       = -127;
 static constexpr viterbi_bit_t SOFT_DECISION_VITERBI_PUNCTURED = 0;
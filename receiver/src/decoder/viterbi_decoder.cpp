@@ -37,7 +37,21 @@ void ViterbiDecoder::Update(tcb::span<const uint8_t> encoded_bytes)
         }
     }
 
-    update_viterbi_blk_scalar(vitdec, depunctured_bits.data(), nb_decoded_bits);
+    update_viterbi_blk_auto(vitdec, depunctured_bits.data(), nb_decoded_bits);
+}
+
+void ViterbiDecoder::Update(tcb::span<const viterbi_bit_t> encoded_bits)
+{
+    const int nb_encoded_bits = (int)encoded_bits.size();
+    const int nb_decoded_bits = nb_encoded_bits/CODE_RATE;
+
+    assert(nb_encoded_bits <= max_depunctured_bits);
+
+    for (int i = 0; i < nb_encoded_bits; i++) {
+        depunctured_bits[i] = encoded_bits[i];
+    }
+
+    update_viterbi_blk_auto(vitdec, depunctured_bits.data(), nb_decoded_bits);
 }
 
 void ViterbiDecoder::GetTraceback(tcb::span<uint8_t> out_bytes) {
@@ -31,7 +31,10 @@ public:
     ViterbiDecoder& operator=(ViterbiDecoder&) = delete;
     ViterbiDecoder& operator=(ViterbiDecoder&&) = delete;
     void Reset();
+    // Hard decision bits packed msb first
     void Update(tcb::span<const uint8_t> encoded_bytes);
+    // Soft decision bits between SOFT_DECISION_VITERBI_LOW and SOFT_DECISION_VITERBI_HIGH
+    void Update(tcb::span<const viterbi_bit_t> encoded_bits);
     void GetTraceback(tcb::span<uint8_t> out_bytes);
     int16_t GetPathError(const int state=0);
 };
\ No newline at end of file
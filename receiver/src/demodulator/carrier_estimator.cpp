@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cmath>
+#include "carrier_estimator.h"
+#include "dsp/calculate_fft.h"
+
+Carrier_Estimator::Carrier_Estimator(
+    const float _Fs, const int _N, const int _nb_averages,
+    const int _period, const float _min_peak_ratio)
+: Fs(_Fs), N(_N), nb_averages(std::max(_nb_averages, 1)),
+  period(std::max(_period, _N*std::max(_nb_averages, 1))),
+  x_fft(_N), spectrum(_N), min_peak_ratio(_min_peak_ratio)
+{
+    fft_index = 0;
+    average_index = 0;
+    skip_remain = 0;
+    std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+}
+
+bool Carrier_Estimator::Process(const std::complex<float>* x, const int N_block)
+{
+    bool is_valid = false;
+    int i = 0;
+    while (i < N_block) {
+        // Idle between estimates
+        if (skip_remain > 0) {
+            const int N_skip = std::min(skip_remain, N_block-i);
+            skip_remain -= N_skip;
+            i += N_skip;
+            continue;
+        }
+
+        const int N_copy = std::min(N-fft_index, N_block-i);
+        for (int j = 0; j < N_copy; j++) {
+            const auto x2 = x[i+j]*x[i+j];
+            x_fft[fft_index+j] = x2*x2;
+        }
+        fft_index += N_copy;
+        i += N_copy;
+        if (fft_index < N) {
+            continue;
+        }
+
+        fft_index = 0;
+        const auto& plan = GetFFTPlan(N);
+        plan.Forward(x_fft.data(), x_fft.data());
+        for (int k = 0; k < N; k++) {
+            spectrum[k] += std::norm(x_fft[k]);
+        }
+
+        average_index++;
+        if (average_index < nb_averages) {
+            continue;
+        }
+
+        average_index = 0;
+        is_valid = estimate() || is_valid;
+        std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+        skip_remain = period - N*nb_averages;
+    }
+    return is_valid;
+}
+
+bool Carrier_Estimator::estimate()
+{
+    total_estimates++;
+
+    int k_peak = 0;
+    float total_power = 0.0f;
+    for (int k = 0; k < N; k++) {
+        total_power += spectrum[k];
+        if (spectrum[k] > spectrum[k_peak]) {
+            k_peak = k;
+        }
+    }
+
+    const float mean_power = total_power / (float)N;
+    peak_ratio = (mean_power > 0.0f) ? spectrum[k_peak]/mean_power : 0.0f;
+    if (peak_ratio < min_peak_ratio) {
+        return false;
+    }
+
+    // Refine the position of the peak by fitting a parabola to it and its neighbours
+    const float y0 = spectrum[(k_peak-1+N) % N];
+    const float y1 = spectrum[k_peak];
+    const float y2 = spectrum[(k_peak+1) % N];
+    const float d = y0 - 2.0f*y1 + y2;
+    float offset = (d < 0.0f) ? 0.5f*(y0-y2)/d : 0.0f;
+    offset = std::max(std::min(offset, 0.5f), -0.5f);
+
+    // bins above N/2 are negative frequencies
+    float k = (float)k_peak + offset;
+    if (k >= (float)(N/2)) {
+        k -= (float)N;
+    }
+    frequency = k*Fs/(float)N / 4.0f;
+    total_valid_estimates++;
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <complex>
+#include "utility/aligned_vector.h"
+
+// Coarse carrier frequency offset estimator from the spectrum of the 4th power of the signal
+// Square QAM constellations are symmetric under rotations of 90 degrees
+// So raising the signal to the 4th power removes the modulation and leaves a line at 4 times the offset
+// The range of the estimator is +-Fs/8 and each estimate averages the spectrum of several blocks
+class Carrier_Estimator
+{
+private:
+    const float Fs;
+    const int N;
+    const int nb_averages;
+    // samples between the start of each estimate
+    const int period;
+    AlignedVector<std::complex<float>> x_fft;
+    AlignedVector<float> spectrum;
+    int fft_index;
+    int average_index;
+    int skip_remain;
+public:
+    // minimum ratio of the peak to the mean power of the spectrum
+    float min_peak_ratio;
+    // last valid estimate
+    float frequency = 0.0f;
+    // ratio of the last estimate whether or not it was valid
+    float peak_ratio = 0.0f;
+    uint64_t total_estimates = 0;
+    uint64_t total_valid_estimates = 0;
+public:
+    // N = length of the fft which must be a power of 2
+    // period = samples between the start of each estimate which is at least N*nb_averages
+    Carrier_Estimator(
+        const float _Fs, const int _N, const int _nb_averages,
+        const int _period, const float _min_peak_ratio);
+    // return true if a valid estimate was made in this block
+    bool Process(const std::complex<float>* x, const int N_block);
+private:
+    bool estimate();
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+// Carrier detector which gates the demodulator on the power of each block
+// Opens when the power rises above threshold_open
+// Closes once the power has stayed below threshold_close for the hang time
+// threshold_close < threshold_open gives hysteresis so noise near a threshold doesn't toggle it
+class Energy_Squelch 
+{
+public:
+    // mean power in the same units as the signal
+    float threshold_open = 0.0f;
+    float threshold_close = 0.0f;
+    int hang_samples = 0;
+    bool is_open = false;
+    int hang_remain = 0;
+    // last measured power
+    float power = 0.0f;
+    uint64_t total_blocks = 0;
+    uint64_t total_open_blocks = 0;
+public:
+    // power = mean power of the block, N = number of samples in the block
+    // return true if the block should be demodulated
+    bool process(const float _power, const int N) {
+        power = _power;
+        total_blocks++;
+        if ((power >= threshold_open) || (is_open && (power >= threshold_close))) {
+            is_open = true;
+            hang_remain = hang_samples;
+        } else if (is_open) {
+            hang_remain -= N;
+            is_open = (hang_remain > 0);
+        }
+        if (is_open) {
+            total_open_blocks++;
+        }
+        return is_open;
+    }
+};
@@ -2,25 +2,37 @@
 #include <cmath>
 #include "pll_mixer.h"
 #include "dsp/common.h"
+#include "dsp/simd/apply_harmonic_pll.h"
 
 constexpr float PI = (float)M_PI;
 
 PLL_mixer::PLL_mixer() {
+    Ts = 1.0f;
+    phase = 0;
     phase_error = 0.0f;
     phase_error_gain = 4.0f/PI;
     fcenter = 0e3;
     fgain = 1e3;
+    nco = std::make_unique<NCO_Table>();
 }
 
-std::complex<float> PLL_mixer::update(void) {
+float PLL_mixer::get_frequency(void) const {
     float control = phase_error * phase_error_gain;
     control = dsp::clamp(control, -1.0f, 1.0f);
-    float freq = fcenter + control*fgain;
-    float t = integrator.process(2.0f*PI*freq);
-    t = std::fmod(t, 2.0f*PI);
-    integrator.yn = t;
+    return fcenter + control*fgain;
+}
+
+std::complex<float> PLL_mixer::update(void) {
+    phase += GetNCOPhaseIncrement(get_frequency()*Ts);
+    return nco->cis(phase);
+}
 
-    float I = std::cos(t);
-    float Q = std::sin(t);
-    return std::complex<float>(I, Q);
-}
\ No newline at end of file
+void PLL_mixer::update_block(const std::complex<float>* x, std::complex<float>* y, const float* ramp, const int N) {
+    const uint32_t dphase = GetNCOPhaseIncrement(get_frequency()*Ts);
+    // signed step so the ramp doesn't wind through a full cycle for negative frequencies
+    const float dt = (float)static_cast<int32_t>(dphase) * (2.0f*PI/(float)NCO_PHASE_SCALE);
+    const float t0 = GetNCOPhaseRadians(phase);
+    // y[i] = x[i] * e^j(t0 + ramp[i]*dt)
+    apply_harmonic_pll_auto(ramp, x, y, N, dt, t0);
+    phase += static_cast<uint32_t>(N)*dphase;
+}
@@ -1,18 +1,28 @@
 #pragma once
 
 #include <complex>
-#include "dsp/integrator.h"
+#include <memory>
+#include <stdint.h>
+#include "dsp/nco.h"
 
 // phase locked loop mixer for carrier
+// The oscillator is a 32bit phase accumulator with a sine table
 class PLL_mixer 
 {
 public:
-    Integrator_Block<float> integrator;
+    float Ts;
+    uint32_t phase;
     float phase_error;
     float phase_error_gain;
     float fcenter;
     float fgain;
+    std::unique_ptr<NCO_Table> nco;
 public:
     PLL_mixer();
     std::complex<float> update(void);
-};
\ No newline at end of file
+    // Mix a block of N samples with the frequency held constant over the block
+    // ramp = [1,2,...,N] as the sample index of each output relative to the current phase
+    void update_block(const std::complex<float>* x, std::complex<float>* y, const float* ramp, const int N);
+private:
+    float get_frequency(void) const;
+};
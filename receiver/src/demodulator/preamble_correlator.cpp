@@ -0,0 +1,137 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <algorithm>
+#include "preamble_correlator.h"
+#include "dsp/simd/c32_conj_cum_mul.h"
+#include "dsp/simd/c32_sum_power.h"
+
+constexpr float PI = (float)M_PI;
+
+Preamble_Correlator::Preamble_Correlator(
+    const uint32_t preamble, ConstellationSpecification& constellation,
+    const float _samples_per_symbol, const float Fs, const float _threshold)
+: Ts(1.0f/Fs), samples_per_symbol(_samples_per_symbol), threshold(_threshold)
+{
+    // Find the constellation point for each symbol value
+    const int nb_bits_per_symbol = constellation.GetBitsPerSymbol();
+    const int nb_symbol_values = 1 << nb_bits_per_symbol;
+    std::vector<std::complex<float>> symbol_points(nb_symbol_values);
+    auto* points = constellation.GetSymbols();
+    for (int i = 0; i < constellation.GetSize(); i++) {
+        symbol_points[constellation.GetNearestSymbol(points[i])] = points[i];
+    }
+
+    // Hold each preamble symbol for its duration
+    // Each sample is taken at the middle of its sampling period
+    const int nb_symbols = 32 / nb_bits_per_symbol;
+    L = (int)std::ceil((float)nb_symbols * samples_per_symbol);
+    waveform = AlignedVector<std::complex<float>>(L);
+    waveform_power = 0.0f;
+    for (int i = 0; i < L; i++) {
+        const int j = std::min((int)(((float)i + 0.5f)/samples_per_symbol), nb_symbols-1);
+        const int shift = (nb_symbols-1-j)*nb_bits_per_symbol;
+        const auto sym = (preamble >> shift) & (uint32_t)(nb_symbol_values-1);
+        waveform[i] = symbol_points[sym];
+        waveform_power += std::norm(waveform[i]);
+    }
+
+    history = AlignedVector<std::complex<float>>(2*L);
+    for (int i = 0; i < 2*L; i++) {
+        history[i] = 0.0f;
+    }
+    history_index = 0;
+    window_power = 0.0;
+    total_samples = 0;
+    peak.is_active = false;
+    peak.is_waiting_next = false;
+    metric_prev = 0.0f;
+    last_position = INT64_MIN;
+}
+
+tcb::span<const Preamble_Correlator::Result> Preamble_Correlator::Process(const std::complex<float>* x, const int N)
+{
+    results.clear();
+    const int64_t block_start = total_samples;
+    const int L_first = L/2;
+    const int L_second = L-L_first;
+    auto* w = waveform.data();
+
+    for (int i = 0; i < N; i++) {
+        // the sample being overwritten is the one leaving the window
+        window_power += (double)std::norm(x[i]) - (double)std::norm(history[history_index]);
+        history[history_index] = x[i];
+        history[history_index+L] = x[i];
+        history_index = (history_index+1) % L;
+        total_samples++;
+
+        // oldest sample is first
+        const auto* window = &history[history_index];
+        if (history_index == 0) {
+            window_power = (double)c32_sum_power_auto(window, L);
+        }
+        const auto c_first = c32_conj_cum_mul_auto(window, w, L_first);
+        const auto c_second = c32_conj_cum_mul_auto(&window[L_first], &w[L_first], L_second);
+        const float norm = std::max((float)window_power, 0.0f)*waveform_power;
+        const float metric = (norm > 0.0f) ? std::abs(c_first + c_second)/std::sqrt(norm) : 0.0f;
+
+        if (peak.is_waiting_next) {
+            peak.metric_next = metric;
+            peak.is_waiting_next = false;
+        }
+
+        const bool is_above = metric >= threshold;
+        if (is_above && (!peak.is_active || (metric > peak.metric))) {
+            peak.is_active = true;
+            peak.is_waiting_next = true;
+            peak.position = total_samples-1;
+            peak.metric_prev = metric_prev;
+            peak.metric = metric;
+            peak.metric_next = 0.0f;
+            peak.c_first = c_first;
+            peak.c_second = c_second;
+        } else if (peak.is_active && !peak.is_waiting_next) {
+            // Stop once the correlation falls off or the peak is a symbol old
+            const int64_t age = (total_samples-1) - peak.position;
+            if (!is_above || ((float)age > samples_per_symbol)) {
+                emit_peak(block_start);
+            }
+        }
+        metric_prev = metric;
+    }
+    return results;
+}
+
+void Preamble_Correlator::emit_peak(const int64_t block_start)
+{
+    peak.is_active = false;
+    // Data inside a frame can correlate with the preamble so we wait for the frame to finish
+    if ((last_position != INT64_MIN) && ((peak.position - last_position) < (int64_t)holdoff)) {
+        return;
+    }
+    last_position = peak.position;
+
+    // Refine the position of the peak by fitting a parabola to it and its neighbours
+    const float y0 = peak.metric_prev;
+    const float y1 = peak.metric;
+    const float y2 = peak.metric_next;
+    const float d = y0 - 2.0f*y1 + y2;
+    float offset = (d < 0.0f) ? 0.5f*(y0-y2)/d : 0.0f;
+    offset = std::max(std::min(offset, 0.5f), -0.5f);
+
+    // The halves are centered L/2 samples apart
+    const float dt = (float)(L/2) * Ts;
+    const float dphase = std::arg(peak.c_second * std::conj(peak.c_first));
+    const float frequency = dphase / (2.0f*PI*dt);
+    // The phase of the full correlation is at the center of the window
+    const float center = (float)(L-1)/2.0f;
+    const float phase = std::arg(peak.c_first + peak.c_second) - 2.0f*PI*frequency*center*Ts;
+
+    Result res;
+    res.index = (int)(peak.position - (L-1) - block_start);
+    // Samples of the waveform are at the middle of their period so the preamble starts half a sample earlier
+    res.timing = offset - 0.5f;
+    res.phase = phase;
+    res.frequency = frequency;
+    res.metric = peak.metric;
+    results.push_back(res);
+}
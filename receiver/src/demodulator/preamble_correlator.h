@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <complex>
+#include <vector>
+#include "utility/aligned_vector.h"
+#include "utility/span.h"
+#include "constellation/constellation.h"
+
+// Matched filter for the preamble on the IQ signal before carrier and timing recovery
+// At the start of a frame this gives the symbol timing, carrier phase and frequency offset
+// so the loops can be seeded instead of having to pull in over many symbols
+// The correlation is split into two halves whose phase difference gives the frequency offset
+class Preamble_Correlator
+{
+public:
+    struct Result {
+        // first sample of the matched window relative to the start of the block
+        // This is negative if the preamble started in an earlier block
+        int index;
+        // start of the preamble's first symbol relative to index in samples
+        float timing;
+        // carrier phase at index in radians
+        float phase;
+        // carrier frequency offset in Hz
+        float frequency;
+        // normalised correlation from 0 to 1
+        float metric;
+    };
+private:
+    const float Ts;
+    const float samples_per_symbol;
+    int L;
+    // conjugate is taken by the kernel
+    AlignedVector<std::complex<float>> waveform;
+    float waveform_power;
+    // each sample is written twice so the last L samples are always contiguous
+    AlignedVector<std::complex<float>> history;
+    int history_index;
+    // power of the last L samples which is updated as each sample enters and leaves the window
+    // This is summed again each time the history wraps so rounding errors can't build up
+    double window_power;
+    int64_t total_samples;
+    // peak of the normalised correlation above the threshold
+    struct {
+        bool is_active;
+        bool is_waiting_next;
+        int64_t position;
+        float metric_prev;
+        float metric;
+        float metric_next;
+        std::complex<float> c_first;
+        std::complex<float> c_second;
+    } peak;
+    float metric_prev;
+    // position of the last emitted peak
+    int64_t last_position;
+    std::vector<Result> results;
+public:
+    float threshold;
+    // samples after an emitted peak during which other peaks are ignored
+    int holdoff = 0;
+public:
+    // preamble = bits sent msb first where each symbol is sliced into nb_bits_per_symbol bits
+    // samples_per_symbol and Fs are for the signal being correlated
+    Preamble_Correlator(
+        const uint32_t preamble, ConstellationSpecification& constellation,
+        const float _samples_per_symbol, const float Fs, const float _threshold=0.85f);
+    // Results are valid until the next call
+    tcb::span<const Result> Process(const std::complex<float>* x, const int N);
+    int GetLength() const { return L; }
+private:
+    void emit_peak(const int64_t block_start);
+};
@@ -1,9 +1,13 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <assert.h>
+#include <algorithm>
 
 #include "qam_sync.h"
 #include "dsp/filter_designer.h"
+#include "dsp/simd/c8_sum_power.h"
+#include "dsp/simd/c32_sum_power.h"
+#include "utility/profiler.h"
 
 constexpr float PI = (float)M_PI;
 
@@ -28,24 +32,35 @@ QAM_Synchroniser::QAM_Synchroniser(
 
     const float Tsource = 1.0f/Fsource;
     const float Tdownsample = 1.0f/Fdownsample;
-    const float Tupsample = 1.0f/Fupsample;
     const float Tsymbol = 1.0f/Fsymbol;
 
+    // squelch
+    {
+        auto& s = spec.squelch;
+        is_squelch = s.is_enabled;
+        // power of a full scale 8bit tone
+        const float P_ref = 128.0f*128.0f;
+        squelch.threshold_open = P_ref*std::pow(10.0f, s.threshold_open/10.0f);
+        squelch.threshold_close = P_ref*std::pow(10.0f, s.threshold_close/10.0f);
+        squelch.hang_samples = (int)(s.hang_time*Fdownsample);
+        squelch_window_size = std::max(s.window_size, 1);
+    }
+
     // downsampling filter is always mandatory
     // This is because it will implement at least one LPF with cutoff Fsymbol
     {
         auto& s = spec.downsampling_filter;
         const float k = Fsymbol/(Fsource/2.0f);
-        filter_ds = std::make_unique<PolyphaseDownsampler<std::complex<float>>>(s.M, s.K);
+        // NOTE: The zero level of unsigned 8bit IQ is 128
+        const auto x0 = std::complex<uint8_t>(128, 128);
+        filter_ds = std::make_unique<Auto_PolyphaseDownsampler<std::complex<float>, std::complex<uint8_t>>>(s.M, s.K, x0);
         create_fir_lpf(filter_ds->get_b(), filter_ds->get_K(), k);
     } 
 
     // ac filter
     {
         auto& s = spec.ac_filter;
-        const int N = TOTAL_TAPS_IIR_AC_COUPLE;
-        filter_ac = std::make_unique<IIR_Filter<std::complex<float>>>(N);
-        create_iir_ac_filter(filter_ac->get_b(), filter_ac->get_a(), s.k);
+        filter_ac.k = s.k;
     }
 
     // agc
@@ -54,32 +69,55 @@ QAM_Synchroniser::QAM_Synchroniser(
         filter_agc.beta = s.beta;
         filter_agc.current_gain = s.initial_gain;
         filter_agc.target_power = constellation.GetAveragePower();
+        filter_agc.block_size = s.block_size;
     }
 
     // carrier pll
     {
         auto& s = spec.carrier_pll;
-        pll.mixer.integrator.KTs = Tdownsample;
+        pll.mixer.Ts = Tdownsample;
         pll.mixer.fcenter = s.f_center;
         pll.mixer.fgain = -s.f_gain;
         pll.mixer.phase_error_gain = s.phase_error_gain;
+        pll.mixer.nco = std::make_unique<NCO_Table>(s.nco_sfdr, s.is_nco_interpolated);
+
+        // ramp of [1,B] used to generate the oscillator for each sub-block
+        pll_block_size = std::max(s.block_size, 1);
+        pll_ramp = AlignedVector<float>(pll_block_size);
+        for (int i = 0; i < pll_block_size; i++) {
+            pll_ramp[i] = (float)(i+1);
+        }
+    }
+
+    // carrier frequency offset estimator
+    {
+        auto& s = spec.carrier_estimator;
+        if (s.is_enabled) {
+            carrier_estimator = std::make_unique<Carrier_Estimator>(
+                Fdownsample, s.fft_size, s.nb_averages, 
+                (int)(s.period*Fdownsample), std::pow(10.0f, s.min_peak_ratio/10.0f));
+        }
     }
 
     // carrier pll loop filter
     {
         auto& s = spec.carrier_pll_filter;
         pll.prev_error = 0.0f;
-        pll.int_error.KTs = s.integrator_gain*Tdownsample;
+        // The loop filter runs once per sub-block so it is designed at that rate
+        const float Fupdate = Fdownsample/(float)pll_block_size;
+        pll.int_error.KTs = s.integrator_gain/Fupdate;
 
-        const float k = s.butterworth_cutoff/(Fdownsample/2.0f);
+        const float k = s.butterworth_cutoff/(Fupdate/2.0f);
         const int N = TOTAL_TAPS_IIR_SINGLE_POLE_LPF;
-        auto& filt = pll.filt_iir_lpf_error;
-        filt = std::make_unique<IIR_Filter<float>>(N);
-        create_iir_single_pole_lpf(filt->get_b(), filt->get_a(), k);
+        float b[N], a[N];
+        create_iir_single_pole_lpf(b, a, k);
+        pll.filt_lpf_error.set_section(0, create_biquad_section(b, a, N));
     }
 
+    is_gardner = (spec.timing_recovery == QAM_Synchroniser_Specification::TimingRecovery::GARDNER);
+
     // upsampling filter
-    if (spec.upsampling_filter.L > 1) {
+    if (!is_gardner && (spec.upsampling_filter.L > 1)) {
         auto& s = spec.upsampling_filter;
         // const float k = (Fdownsample/2.0f)/(Fupsample/2.0f);
         const float k = Fsymbol/(Fupsample/2.0f);
@@ -88,149 +126,444 @@ QAM_Synchroniser::QAM_Synchroniser(
         auto b = std::vector<float>(NN);
         create_fir_lpf(b.data(), NN, k);
         filter_us = std::make_unique<PolyphaseUpsampler<std::complex<float>>>(b.data(), s.L, s.K);
+        x_upsampled_scratch = AlignedVector<std::complex<float>>(s.L);
     } else {
         filter_us = NULL;
     }
 
     // ted
+    // The gardner ted runs at Fdownsample and strobes on symbols and halfway between them
+    const float Fted = is_gardner ? Fdownsample : Fupsample;
+    const float strobes_per_symbol = is_gardner ? 2.0f : 1.0f;
     {
         auto& s = spec.ted_pll;
-        ted.clock.integrator.KTs = Tupsample;
-        ted.clock.fcenter = Fsymbol + s.f_offset;
-        ted.clock.fgain = -s.f_gain;
+        ted.clock.Ts = 1.0f/Fted;
+        ted.clock.fcenter = strobes_per_symbol*(Fsymbol + s.f_offset);
+        ted.clock.fgain = -strobes_per_symbol*s.f_gain;
         ted.clock.phase_error_gain = s.phase_error_gain;
+        assert(!is_gardner || (ted.clock.fcenter < Fted));
     }
 
     // ted pll loop filter
     {
         auto& s = spec.ted_pll_filter;
         ted.prev_error = 0.0f;
-        ted.int_error.KTs = s.integrator_gain*Tupsample;
+        ted.int_error.KTs = s.integrator_gain/Fted;
 
-        const float k = s.butterworth_cutoff/(Fupsample/2.0f);
+        const float k = s.butterworth_cutoff/(Fted/2.0f);
         const int N = TOTAL_TAPS_IIR_SINGLE_POLE_LPF;
-        auto& filt = ted.filt_iir_lpf_error;
-        filt = std::make_unique<IIR_Filter<float>>(N);
-        create_iir_single_pole_lpf(filt->get_b(), filt->get_a(), k);
+        float b[N], a[N];
+        create_iir_single_pole_lpf(b, a, k);
+        ted.filt_lpf_error.set_section(0, create_biquad_section(b, a, N));
+    }
+
+    // preamble correlator
+    samples_per_symbol = Fdownsample/Fsymbol;
+    {
+        auto& s = spec.preamble;
+        if (s.is_enabled) {
+            preamble_correlator = std::make_unique<Preamble_Correlator>(
+                s.code, constellation, samples_per_symbol, Fdownsample, s.threshold);
+            preamble_correlator->holdoff = (int)(s.holdoff*samples_per_symbol);
+        }
+        // Delay in samples at Fdownsample from the previous input sample to where the ted clock is
+        // NOTE: The farrow interpolator evaluates one sample behind the ted clock
+        ted_delay = 0.0f;
+        if (is_gardner) {
+            ted_delay = 1.0f;
+        } else {
+            const int L = filter_us ? spec.upsampling_filter.L : 1;
+            const int NN = filter_us ? spec.upsampling_filter.K*L : 1;
+            // The polyphase upsampler delays its input by half of its taps at Fupsample
+            // But each input is placed on the first of its L outputs so the last one is (L-1)/L later
+            // The zero crossing detector reads the clock on the sample before the one past the crossing
+            // So the clock locks on to the crossing half an upsampled sample early
+            ted_delay = 0.5f*(float)(NN-1)/(float)L - (float)(L-1)/(float)L - 0.5f/(float)L;
+        }
     }
 
     I_zcd = std::make_unique<N_Level_Crossing_Detector>(N_levels, total_levels);
     Q_zcd = std::make_unique<N_Level_Crossing_Detector>(N_levels, total_levels);
     zcd_cooldown.N_cooldown = (int)std::floorf(Nsymbol*0.0f);
+
+    gardner.is_symbol_strobe = true;
+    gardner.y_mid = 0.0f;
+    gardner.y_prev = 0.0f;
 }
 
 int QAM_Synchroniser::ProcessBlock(QAM_Synchroniser_Buffer& buffers)
+{
+    // The raw signal is checked so that even the downsampling filter is skipped
+    if (is_squelch && !update_squelch(buffers, false)) {
+        return 0;
+    }
+
+    // raw 8bit IQ is converted to float while being downsampled
+    {
+        PROFILE_BEGIN(filter_ds);
+        const int ds_size = buffers.GetPLLSize();
+        filter_ds->process(buffers.x_raw.data(), buffers.x_downsampled.data(), ds_size);
+    }
+    return demodulate_block(buffers);
+}
+
+int QAM_Synchroniser::ProcessDownsampledBlock(QAM_Synchroniser_Buffer& buffers)
+{
+    if (is_squelch && !update_squelch(buffers, true)) {
+        return 0;
+    }
+    return demodulate_block(buffers);
+}
+
+// Mean power of the loudest window in the block
+template <typename T, typename F>
+static float GetPeakWindowPower(const T* x, const int N, const int W, F&& sum_power) {
+    float peak = 0.0f;
+    for (int i = 0; i < N; i += W) {
+        const int N_window = std::min(W, N-i);
+        const float power = (float)sum_power(&x[i], N_window) / (float)N_window;
+        peak = std::max(peak, power);
+    }
+    return peak;
+}
+
+bool QAM_Synchroniser::update_squelch(QAM_Synchroniser_Buffer& buffers, const bool is_downsampled)
+{
+    PROFILE_BEGIN(squelch);
+    const int ds_size = buffers.GetPLLSize();
+    float power = 0.0f;
+    if (is_downsampled) {
+        power = GetPeakWindowPower(buffers.x_downsampled.data(), ds_size, squelch_window_size, c32_sum_power_auto);
+    } else {
+        // NOTE: The raw signal has the full bandwidth of Fs so its noise floor is higher
+        const int M = buffers.GetDownsamplingFactor();
+        power = GetPeakWindowPower(buffers.x_raw.data(), buffers.GetInputSize(), squelch_window_size*M, c8_sum_power_auto);
+    }
+    if (squelch.process(power, ds_size)) {
+        return true;
+    }
+
+    if (buffers.HasTelemetry()) {
+        auto clear = [](auto x) { std::fill(x.begin(), x.end(), typename decltype(x)::value_type(0)); };
+        if (!is_downsampled) {
+            clear(buffers.x_downsampled);
+        }
+        clear(buffers.x_ac);
+        clear(buffers.x_agc);
+        clear(buffers.x_pll_out);
+        clear(buffers.error_pll);
+        clear(buffers.x_upsampled);
+        clear(buffers.trig_zero_crossing);
+        clear(buffers.trig_ted_clock);
+        clear(buffers.trig_integrator_dump);
+        clear(buffers.error_ted);
+        clear(buffers.y_sym_out);
+    }
+    return false;
+}
+
+int QAM_Synchroniser::demodulate_block(QAM_Synchroniser_Buffer& buffers)
+{
+    if (buffers.HasTelemetry()) {
+        return process_downsampled_block<true>(buffers);
+    }
+    return process_downsampled_block<false>(buffers);
+}
+
+template <bool IS_TELEMETRY>
+int QAM_Synchroniser::process_downsampled_block(QAM_Synchroniser_Buffer& buffers)
 {
     float thresh_acquire_error = 0.2f; // max distance allowed for a valid symbol reading
     const bool use_all_points = false;
 
-    const int source_size = buffers.GetInputSize();
     const int ds_size = buffers.GetPLLSize();
     const int us_size = buffers.GetTEDSize();
     const int L = us_size/ds_size;
 
     int total_symbols = 0;
 
-    for (int i = 0; i < source_size; i++) {
-        const auto& IQ = buffers.x_raw[i];
-        const float I = static_cast<float>(IQ.real()) - 128.0f;
-        const float Q = static_cast<float>(IQ.imag()) - 128.0f;
-        buffers.x_in[i] = std::complex<float>(I, Q);
-    }
-
     // per block filtering
     {
-        filter_ds->process(buffers.x_in.data(), buffers.x_downsampled.data(), ds_size);
-        filter_ac->process(buffers.x_downsampled.data(), buffers.x_ac.data(), ds_size);
+        PROFILE_BEGIN(filter_ac);
+        filter_ac.process(buffers.x_downsampled.data(), buffers.x_ac.data(), ds_size);
+        PROFILE_END(filter_ac);
+        PROFILE_BEGIN(filter_agc);
         filter_agc.process(buffers.x_ac.data(), buffers.x_agc.data(), ds_size);
+        PROFILE_END(filter_agc);
     }
 
+    if (carrier_estimator) {
+        PROFILE_BEGIN(carrier_estimator);
+        if (carrier_estimator->Process(buffers.x_agc.data(), ds_size)) {
+            steer_pll(carrier_estimator->frequency);
+        }
+        PROFILE_END(carrier_estimator);
+    }
+
+    // Find preambles in the block ahead of the loops so they can be seeded before the frame starts
+    tcb::span<const Preamble_Correlator::Result> preambles;
+    if (preamble_correlator) {
+        PROFILE_BEGIN(preamble_correlator);
+        preambles = preamble_correlator->Process(buffers.x_agc.data(), ds_size);
+        PROFILE_END(preamble_correlator);
+    }
+    size_t next_preamble = 0;
+
     // Our multirate processing loop
     // Outer loop runs at Fdownsample
     // Inner TED loop runs at Fupsample
-    for (int i = 0; i < ds_size; i++) {
-        const auto IQ_raw = buffers.x_agc[i];
-        const auto IQ_mixer_out = pll.mixer.update();
-        const auto IQ_pll = IQ_raw * IQ_mixer_out;
-
-        // Run carrier phase estimation for every possible sample
-        // {
-        //     const auto A = std::abs(IQ_pll);
-        //     auto res = estimate_phase_error(IQ_pll, constellation);
-        //     if (res.mag_error < thresh_acquire_error) {
-        //         pll_error_prev = res.phase_error;
-        //     }
-        // }
-
-        // pass new pll phase error through first order butterworth filter
-        {
-            float error_lpf = 0;
-            pll.filt_iir_lpf_error->process(&pll.prev_error, &error_lpf, 1);
-            pll.int_error.process(error_lpf);
-            pll.int_error.yn = dsp::clamp(pll.int_error.yn, -1.0f, 1.0f);
-            pll.mixer.phase_error = error_lpf + pll.int_error.yn;
+    PROFILE_BEGIN(multirate_loop);
+    const int B = pll_block_size;
+    for (int i0 = 0; i0 < ds_size; i0 += B) {
+        const int N_block = std::min(B, ds_size-i0);
+        // With a vectorised carrier loop we can only seed at the start of each sub-block
+        if (B > 1) {
+            while ((next_preamble < preambles.size()) && (preambles[next_preamble].index < (i0+N_block))) {
+                seed_loops(preambles[next_preamble++], i0);
+            }
+        }
+        // Update the carrier loop once per sub-block and generate its oscillator with a vectorised kernel
+        if (B > 1) {
+            update_pll_loop();
+            pll.mixer.update_block(&buffers.x_agc[i0], &buffers.x_pll_out[i0], pll_ramp.data(), N_block);
         }
 
-        buffers.x_pll_out[i] = IQ_pll;
-        buffers.error_pll[i] = pll.mixer.phase_error;
+        for (int i = i0; i < (i0+N_block); i++) {
+            auto IQ_pll = buffers.x_pll_out[i];
+            if (B == 1) {
+                while ((next_preamble < preambles.size()) && (preambles[next_preamble].index <= i)) {
+                    seed_loops(preambles[next_preamble++], i);
+                }
+                const auto IQ_raw = buffers.x_agc[i];
+                const auto IQ_mixer_out = pll.mixer.update();
+                IQ_pll = IQ_raw * IQ_mixer_out;
+                update_pll_loop();
+            }
 
-        // Upsample signal (optional)
-        auto rd_buf = buffers.x_pll_out;
-        if (filter_us) {
-            filter_us->process(&buffers.x_pll_out[i], &buffers.x_upsampled[i*L], 1);
-            rd_buf = buffers.x_upsampled;
-        }
+            // Run carrier phase estimation for every possible sample
+            // {
+            //     const auto A = std::abs(IQ_pll);
+            //     auto res = estimate_phase_error(IQ_pll, constellation);
+            //     if (res.mag_error < thresh_acquire_error) {
+            //         pll_error_prev = res.phase_error;
+            //     }
+            // }
+
+            buffers.x_pll_out[i] = IQ_pll;
+            if constexpr(IS_TELEMETRY) {
+                buffers.error_pll[i] = pll.mixer.phase_error;
+            }
+
+            // Timing recovery without upsampling
+            if (is_gardner) {
+                update_ted_loop();
+                bool is_mid_strobe = false;
+                auto IQ_sym = y_sym_out;
+                const bool is_symbol = update_gardner(IQ_pll, IQ_sym, is_mid_strobe);
+                if (is_symbol) {
+                    y_sym_out = IQ_sym;
+                    buffers.y_out[total_symbols++] = IQ_sym;
+
+                    // Update carrier phase estimate for every sampled symbol
+                    auto res = estimate_phase_error(IQ_sym, constellation);
+                    pll.prev_error = res.phase_error;
+                }
+
+                if constexpr(IS_TELEMETRY) {
+                    for (int j = 0; j < L; j++) {
+                        const int us_i = i*L + j;
+                        buffers.trig_zero_crossing[us_i] = is_mid_strobe;
+                        buffers.trig_ted_clock[us_i] = is_mid_strobe || is_symbol;
+                        buffers.trig_integrator_dump[us_i] = is_symbol;
+                        buffers.error_ted[us_i] = ted.clock.phase_error;
+                        buffers.y_sym_out[us_i] = y_sym_out;
+                    }
+                }
+                continue;
+            }
 
-        for (int j = 0; j < L; j++) {
-            const int us_i = i*L + j;
-
-            const auto IQ_us_pll = rd_buf[us_i];
-            bool is_zero_crossing = false;
-            {
-                is_zero_crossing = I_zcd->process(IQ_us_pll.real()) || is_zero_crossing;
-                is_zero_crossing = Q_zcd->process(IQ_us_pll.imag()) || is_zero_crossing;
-                is_zero_crossing = zcd_cooldown.on_trigger(is_zero_crossing);
-            } 
-
-            // if zero crossing detector triggered, update the phase error into the ted clock
-            if (is_zero_crossing) {
-                ted.prev_error = ted.clock.get_timing_error();
-            }             
-
-            // propagate ted error into pll
-            {
-                float error_lpf = 0.0f;
-                ted.filt_iir_lpf_error->process(&ted.prev_error, &error_lpf, 1);
-                ted.int_error.process(error_lpf);
-                ted.int_error.yn = dsp::clamp(ted.int_error.yn, -1.0f, 1.0f);
-                ted.clock.phase_error = error_lpf + ted.int_error.yn;
+            // Upsample signal (optional)
+            // Without telemetry the upsampled samples are only kept until they are read
+            const std::complex<float>* rd_buf = &buffers.x_pll_out[i];
+            if (filter_us) {
+                auto* us_buf = IS_TELEMETRY ? &buffers.x_upsampled[i*L] : x_upsampled_scratch.data();
+                filter_us->process(&buffers.x_pll_out[i], us_buf, 1);
+                rd_buf = us_buf;
             }
 
-            const bool is_ted_clock_trigger = ted.clock.update();
-            if (is_ted_clock_trigger) {
-                delay_line.add(Nsymbol/2);
+            for (int j = 0; j < L; j++) {
+                const int us_i = i*L + j;
+
+                const auto IQ_us_pll = rd_buf[j];
+                bool is_zero_crossing = false;
+                {
+                    is_zero_crossing = I_zcd->process(IQ_us_pll.real()) || is_zero_crossing;
+                    is_zero_crossing = Q_zcd->process(IQ_us_pll.imag()) || is_zero_crossing;
+                    is_zero_crossing = zcd_cooldown.on_trigger(is_zero_crossing);
+                } 
+
+                // if zero crossing detector triggered, update the phase error into the ted clock
+                if (is_zero_crossing) {
+                    ted.prev_error = ted.clock.get_timing_error();
+                }             
+
+                // propagate ted error into pll
+                update_ted_loop();
+
+                const bool is_ted_clock_trigger = ted.clock.update();
+                if (is_ted_clock_trigger) {
+                    delay_line.add(Nsymbol/2);
+                }
+                const bool is_integrate_dump_trigger = delay_line.process();
+
+                if (is_integrate_dump_trigger) {
+                    auto IQ_out = IQ_us_pll;
+                    y_sym_out = IQ_out;
+                    buffers.y_out[total_symbols++] = IQ_out;
+
+                    // Update carrier phase estimate for every sampled symbol
+                    auto res = estimate_phase_error(IQ_pll, constellation);
+                    pll.prev_error = res.phase_error;
+                } 
+
+                // place all of our data into the buffer
+                if constexpr(IS_TELEMETRY) {
+                    buffers.trig_zero_crossing[us_i] = is_zero_crossing;
+                    buffers.trig_ted_clock[us_i] = is_ted_clock_trigger;
+                    buffers.trig_integrator_dump[us_i] = is_integrate_dump_trigger;
+                    buffers.error_ted[us_i] = ted.clock.phase_error;
+                    buffers.y_sym_out[us_i] = y_sym_out;
+                }
             }
-            const bool is_integrate_dump_trigger = delay_line.process();
-
-            if (is_integrate_dump_trigger) {
-                auto IQ_out = IQ_us_pll;
-                y_sym_out = IQ_out;
-                buffers.y_out[total_symbols++] = IQ_out;
-
-                // Update carrier phase estimate for every sampled symbol
-                auto res = estimate_phase_error(IQ_pll, constellation);
-                pll.prev_error = res.phase_error;
-            } 
-
-            buffers.trig_zero_crossing[us_i] = is_zero_crossing;
-            buffers.trig_ted_clock[us_i] = is_ted_clock_trigger;
-            buffers.trig_integrator_dump[us_i] = is_integrate_dump_trigger;
-            
-            // place all of our data into the buffer
-            buffers.error_ted[us_i] = ted.clock.phase_error;
-            buffers.y_sym_out[us_i] = y_sym_out;
         }
     }
+    PROFILE_END(multirate_loop);
 
     return total_symbols;
-}
\ No newline at end of file
+}
+
+void QAM_Synchroniser::seed_loops(const Preamble_Correlator::Result& res, const int i)
+{
+    const auto& p = spec.preamble;
+    // Carrier phase that the mixer needs to have reached on the previous sample
+    // There are 4 phases which the QAM constellation maps onto itself
+    // So we pick the one closest to the current phase which the frame decoder can already resolve
+    {
+        const float t = (float)(i-1-res.index)*pll.mixer.Ts;
+        const float phase_target = -(res.phase + 2.0f*PI*res.frequency*t);
+        const float phase_current = GetNCOPhaseRadians(pll.mixer.phase);
+        const float quadrant = 0.5f*PI;
+        float dphase = phase_target - phase_current;
+        dphase -= quadrant*std::round(dphase/quadrant);
+        if (std::abs(dphase) > p.max_phase_error) {
+            pll.mixer.phase += (uint32_t)(int32_t)std::round(dphase/(2.0f*PI) * (float)NCO_PHASE_SCALE);
+        }
+        // frequency of the mixer is fcenter + control*fgain where the integrator holds the control
+        auto& m = pll.mixer;
+        const float K = m.fgain*m.phase_error_gain;
+        const float f_target = -res.frequency;
+        const float f_current = m.fcenter + pll.int_error.yn*K;
+        if (std::abs(f_current - f_target) > p.max_frequency_error*std::abs(m.fgain)) {
+            pll.int_error.yn = dsp::clamp((f_target - m.fcenter)/K, -1.0f, 1.0f);
+        }
+    }
+
+    // Position of the previous sample of the timing recovery's input in symbols since the preamble started
+    const float t = (float)(i-1) - ted_delay;
+    const float start = (float)res.index + res.timing;
+    const float tau = (t - start) / samples_per_symbol;
+    // Clock phase in symbols relative to the one predicted by the preamble
+    float dtau = 0.0f;
+    if (is_gardner) {
+        // The clock strobes every half symbol where odd strobes are on the middle of a symbol
+        const float current = 0.5f*((float)ted.clock.phase/(float)NCO_PHASE_SCALE + (gardner.is_symbol_strobe ? 0.0f : 1.0f));
+        dtau = current - tau;
+    } else {
+        // The clock resets on the end of each symbol
+        dtau = (float)ted.clock.phase/(float)NCO_PHASE_SCALE - tau;
+    }
+    dtau -= std::round(dtau);
+    if (std::abs(dtau) <= p.max_timing_error) {
+        return;
+    }
+
+    if (is_gardner) {
+        const float tau_half = 2.0f*tau;
+        const float tau_floor = std::floor(tau_half);
+        ted.clock.phase = (uint32_t)((double)(tau_half - tau_floor) * NCO_PHASE_SCALE);
+        gardner.is_symbol_strobe = (((int64_t)tau_floor+1) & 1) == 1;
+    } else {
+        ted.clock.phase = (uint32_t)((double)(tau - std::floor(tau)) * NCO_PHASE_SCALE);
+    }
+}
+
+void QAM_Synchroniser::steer_pll(const float f_offset)
+{
+    // frequency of the mixer is fcenter + control*fgain where the integrator holds the control
+    auto& m = pll.mixer;
+    const float K = m.fgain*m.phase_error_gain;
+    const float f_target = -f_offset;
+    const float f_current = m.fcenter + pll.int_error.yn*K;
+
+    // If the loop is tracking the estimate we keep its frequency and only recentre its range
+    // Otherwise jump to the estimate and let the loop pull in from there
+    float control = 0.0f;
+    const float max_error = spec.carrier_estimator.max_loop_error*std::abs(m.fgain);
+    if (std::abs(f_current - f_target) < max_error) {
+        control = (f_current - f_target)/K;
+    }
+    m.fcenter = f_target;
+    pll.int_error.yn = dsp::clamp(control, -1.0f, 1.0f);
+}
+
+// pass new pll phase error through first order butterworth filter
+void QAM_Synchroniser::update_pll_loop()
+{
+    float error_lpf = 0;
+    pll.filt_lpf_error.process(&pll.prev_error, &error_lpf, 1);
+    pll.int_error.process(error_lpf);
+    pll.int_error.yn = dsp::clamp(pll.int_error.yn, -1.0f, 1.0f);
+    pll.mixer.phase_error = error_lpf + pll.int_error.yn;
+}
+
+void QAM_Synchroniser::update_ted_loop()
+{
+    float error_lpf = 0.0f;
+    ted.filt_lpf_error.process(&ted.prev_error, &error_lpf, 1);
+    ted.int_error.process(error_lpf);
+    ted.int_error.yn = dsp::clamp(ted.int_error.yn, -1.0f, 1.0f);
+    ted.clock.phase_error = error_lpf + ted.int_error.yn;
+}
+
+// Gardner ted using the samples on and halfway between symbols
+// e = Re{(y[k-1] - y[k]) * conj(y[k-1/2])}
+// This is zero when the midpoint is on the zero crossing of a symbol transition
+bool QAM_Synchroniser::update_gardner(const std::complex<float> x, std::complex<float>& y, bool& is_mid_strobe)
+{
+    auto& g = gardner;
+    g.interpolator.push(x);
+
+    float mu = 0.0f;
+    if (!ted.clock.update_interpolated(mu)) {
+        return false;
+    }
+
+    // the interpolator is one sample behind so the strobe falls between x[n-2] and x[n-1]
+    const auto IQ = g.interpolator.interpolate(mu);
+    if (!g.is_symbol_strobe) {
+        g.y_mid = IQ;
+        g.is_symbol_strobe = true;
+        is_mid_strobe = true;
+        return false;
+    }
+
+    // normalise by the agc target so the loop gain doesn't depend on the constellation
+    const auto dy = g.y_prev - IQ;
+    const float error = dy.real()*g.y_mid.real() + dy.imag()*g.y_mid.imag();
+    ted.prev_error = dsp::clamp(error/filter_agc.target_power, -1.0f, 1.0f);
+
+    g.y_prev = IQ;
+    g.is_symbol_strobe = false;
+    y = IQ;
+    return true;
+}
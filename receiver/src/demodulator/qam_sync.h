@@ -7,15 +7,21 @@
 #include "utility/span.h"
 
 #include "dsp/integrator.h"
-#include "dsp/iir_filter.h"
+#include "dsp/biquad_filter.h"
 #include "dsp/polyphase_filter.h"
+#include "dsp/fft_fir_filter.h"
 #include "dsp/agc.h"
+#include "dsp/ac_coupling_filter.h"
+#include "dsp/farrow_interpolator.h"
 
 #include "pll_mixer.h"
 #include "ted_clock.h"
 #include "N_level_crossing_detector.h"
 #include "trigger_cooldown.h"
 #include "delay_line.h"
+#include "energy_squelch.h"
+#include "preamble_correlator.h"
+#include "carrier_estimator.h"
 
 #include "qam_sync_spec.h"
 #include "qam_sync_buffers.h"
@@ -30,25 +36,50 @@ private:
 private:
     int Nsymbol;
 private:
+    // skip demodulation while there is no carrier
+    bool is_squelch;
+    Energy_Squelch squelch;
+    int squelch_window_size;
     // prefiltering before demodulation
-    std::unique_ptr<PolyphaseDownsampler<std::complex<float>>> filter_ds;
-    std::unique_ptr<IIR_Filter<std::complex<float>>> filter_ac;
+    // raw 8bit IQ is converted to floats inside the downsampling filter
+    std::unique_ptr<Auto_PolyphaseDownsampler<std::complex<float>, std::complex<uint8_t>>> filter_ds;
+    AC_Coupling_Filter filter_ac;
     AGC_Filter<std::complex<float>> filter_agc;
     std::unique_ptr<PolyphaseUpsampler<std::complex<float>>> filter_us;
+    // output of the upsampler for one sample if the buffers don't keep it as telemetry
+    AlignedVector<std::complex<float>> x_upsampled_scratch;
     // phase locked loop
     struct {
         PLL_mixer mixer;
         float prev_error;
         Integrator_Block<float> int_error;
-        std::unique_ptr<IIR_Filter<float>> filt_iir_lpf_error;
+        Biquad_Filter_Bank filt_lpf_error;
     } pll;
+    // recentres the carrier pll on the coarse frequency offset
+    std::unique_ptr<Carrier_Estimator> carrier_estimator;
+    // carrier pll is updated once every sub-block of this size
+    int pll_block_size;
+    AlignedVector<float> pll_ramp;
     // timing error detector
     struct {
         TED_Clock clock;
         float prev_error;
         Integrator_Block<float> int_error;
-        std::unique_ptr<IIR_Filter<float>> filt_iir_lpf_error;
+        Biquad_Filter_Bank filt_lpf_error;
     } ted;
+    // gardner timing recovery where the ted clock strobes every half symbol
+    bool is_gardner;
+    struct {
+        Farrow_Interpolator<std::complex<float>> interpolator;
+        bool is_symbol_strobe;
+        std::complex<float> y_mid;
+        std::complex<float> y_prev;
+    } gardner;
+    // seeds the loops from the preamble
+    std::unique_ptr<Preamble_Correlator> preamble_correlator;
+    float samples_per_symbol;
+    // delay of the timing recovery's input relative to the signal at Fs/M
+    float ted_delay;
     // zero crossing detectors
     std::unique_ptr<N_Level_Crossing_Detector> I_zcd;
     std::unique_ptr<N_Level_Crossing_Detector> Q_zcd;
@@ -63,5 +94,27 @@ public:
     QAM_Synchroniser(QAM_Synchroniser_Specification _spec, ConstellationSpecification& _constellation);
     // return the number of symbols read into the buffer
     // x must be at least block_size large
+    // Telemetry is only written if the buffers were allocated with it
     int ProcessBlock(QAM_Synchroniser_Buffer& buffers);
+    // Same as ProcessBlock except x_downsampled has already been filled
+    // E.g. by a channeliser which extracts this signal from a wideband capture
+    int ProcessDownsampledBlock(QAM_Synchroniser_Buffer& buffers);
+    const auto& GetSquelch() const { return squelch; }
+    // NULL if the estimator is disabled
+    const Carrier_Estimator* GetCarrierEstimator() const { return carrier_estimator.get(); }
+private:
+    // return true if the squelch is open for this block
+    // If closed the telemetry is cleared so the gui doesn't show stale values
+    bool update_squelch(QAM_Synchroniser_Buffer& buffers, const bool is_downsampled);
+    int demodulate_block(QAM_Synchroniser_Buffer& buffers);
+    template <bool IS_TELEMETRY>
+    int process_downsampled_block(QAM_Synchroniser_Buffer& buffers);
+    void update_pll_loop();
+    // move the centre of the carrier pll onto the estimated offset
+    void steer_pll(const float f_offset);
+    void update_ted_loop();
+    // seed the loops before the sample i is demodulated
+    void seed_loops(const Preamble_Correlator::Result& res, const int i);
+    // return true if a symbol was sampled
+    bool update_gardner(const std::complex<float> x, std::complex<float>& y, bool& is_mid_strobe);
 };
\ No newline at end of file
@@ -10,15 +10,20 @@ class QAM_Synchroniser_Buffer
 {
 public:
     AlignedVector<uint8_t> data_allocate;
+private:
+    tcb::span<std::complex<uint8_t>> x_raw_storage;
 public:
     const int src_block_size;                    // Fs 
     const int ds_block_size;                     // Fs/M
     const int us_block_size;                     // L/M * Fs
     const int ds_factor;
     const int us_factor;
+    // Telemetry is only used to view the demodulator in the GUI
+    // Without telemetry error_pll, x_upsampled, trig_*, error_ted and y_sym_out are empty
+    const bool is_telemetry;
     // Input 
-    tcb::span<std::complex<uint8_t>> x_raw;       // Fs
-    tcb::span<std::complex<float>> x_in;          // Fs
+    // NOTE: This can point to external read only memory (e.g. a memory mapped file) to avoid a copy
+    tcb::span<const std::complex<uint8_t>> x_raw; // Fs
     // Downsampled PLL
     tcb::span<std::complex<float>> x_downsampled; // Fs/M
     tcb::span<std::complex<float>> x_ac;          // Fs/M 
@@ -35,12 +40,14 @@ public:
     // Output symbols
     tcb::span<std::complex<float>> y_out;         // Fsymbol
 public:
-    QAM_Synchroniser_Buffer(const int _block_size, const int M, const int L);
+    QAM_Synchroniser_Buffer(const int _block_size, const int M, const int L, const bool _is_telemetry=true);
     size_t Size() { return data_allocate.size(); }
-    bool CopyFrom(QAM_Synchroniser_Buffer& in); 
     int GetInputSize() const { return src_block_size; }
+    // Memory owned by the buffer for the input
+    tcb::span<std::complex<uint8_t>> GetInputBuffer() { return x_raw_storage; }
     int GetPLLSize() const { return ds_block_size; }
     int GetTEDSize() const { return us_block_size; }
     int GetDownsamplingFactor() const { return ds_factor; }
     int GetUpsamplingFactor() const { return us_factor; }
+    bool HasTelemetry() const { return is_telemetry; }
 };
\ No newline at end of file
@@ -1,7 +1,8 @@
 #pragma once
 
 // Diagram of our carrier to symbol demodulator
-// RX_IN --> 8bit IQ --> [8bit to float] --> Downsample --> AC Filter --> AGC --> X0
+// RX_IN --> 8bit IQ --> Squelch --> Downsample [8bit to float] --> AC Filter --> AGC --> X0
+// X0 --> Carrier offset estimator --> Centre frequency of IQ Mixer
 
 // X0 --> IQ Mixer --> Upsample --> [        Sampler          ] --> Y0        
 //           ^            |            |                   ^         |
@@ -10,6 +11,12 @@
 //           |                                                       |
 //           |-- PI <-- LPF <-- Phase detector <---------------------|                    
 
+// With gardner timing recovery the upsampler and zero crossing detector are replaced by
+// X0 --> IQ Mixer --> Farrow interpolator --> Y0 
+//                        ^          |
+//                        |          v
+//                        |-- PI <-- LPF <-- Gardner TED
+
 // Specification for the carrier to symbol demodulator 
 struct QAM_Synchroniser_Specification 
 {
@@ -21,6 +28,20 @@ struct QAM_Synchroniser_Specification
         int K = 10;
     } downsampling_filter;
 
+    // energy detector which skips demodulation while there is no carrier
+    // The loop state is frozen while squelched so it resumes where it left off
+    struct {
+        bool is_enabled = false;
+        // mean power in dB relative to a full scale 8bit tone, i.e. 128^2
+        float threshold_open = -30.0f;
+        float threshold_close = -33.0f;
+        // keep demodulating for this long after the power drops below threshold_close
+        float hang_time = 10e-3f;
+        // power is measured over windows of this many samples at Fs/M and the loudest one is used
+        // This way a carrier which starts late in a block still opens the squelch
+        int window_size = 256;
+    } squelch;
+
     // iir ac filter
     // 0 <= k <= 1.0f
     struct {
@@ -31,6 +52,10 @@ struct QAM_Synchroniser_Specification
     struct {
         float beta = 0.1f;
         float initial_gain = 0.1f;
+        // samples at Fs/M between updates of the gain where 0 updates once per block
+        // With 0 the updated gain is applied to the whole block as a constant
+        // Otherwise it is interpolated across each update so a short period doesn't add steps
+        int block_size = 0;
     } agc;
 
     // carrier phased lock loop
@@ -38,8 +63,32 @@ struct QAM_Synchroniser_Specification
         float f_center = 0e3;
         float f_gain = 5e3;
         float phase_error_gain = 8.0f/3.1415f;
+        // Number of samples between updates of the loop
+        // If greater than 1 the mixer is generated for each sub-block with a vectorised kernel
+        // E.g. set this to about one symbol period at Fs/M
+        int block_size = 1;
+        // Minimum spurious free dynamic range of the oscillator's sine table in dB
+        // Linear interpolation needs a much smaller table for the same SFDR
+        float nco_sfdr = 90.0f;
+        bool is_nco_interpolated = true;
     } carrier_pll;
 
+    // coarse carrier frequency offset estimator which recentres the carrier pll on the measured offset
+    // This way the pll only has to pull in over the error of the estimate instead of the crystal drift
+    struct {
+        bool is_enabled = false;
+        // fft of the 4th power of the signal at Fs/M which is averaged over several blocks
+        int fft_size = 4096;
+        int nb_averages = 4;
+        // time between the start of each estimate in seconds
+        float period = 0.1f;
+        // minimum ratio in dB of the peak of the spectrum to its mean power
+        float min_peak_ratio = 10.0f;
+        // if the loop is within this fraction of f_gain from the estimate it keeps its frequency
+        // otherwise it has slipped or not pulled in so its integrator is reset on the estimate
+        float max_loop_error = 0.5f;
+    } carrier_estimator;
+
     struct {
         float proportional_gain = 1.0f;
         float integrator_gain = 1000.0f;
@@ -52,6 +101,35 @@ struct QAM_Synchroniser_Specification
         int K = 3;
     } upsampling_filter;
 
+    // symbol timing recovery
+    enum class TimingRecovery {
+        // upsample by L and reset the symbol clock on zero crossings
+        ZERO_CROSSING,
+        // interpolate at Fs/M with a gardner timing error detector
+        // The upsampling filter isn't used and Fs/M should be just above 2 samples per symbol
+        GARDNER,
+    };
+    TimingRecovery timing_recovery = TimingRecovery::ZERO_CROSSING;
+
+    // matched filter on the preamble which seeds the carrier and timing loops at the start of a frame
+    // This lets short bursts be demodulated without waiting for the loops to pull in
+    struct {
+        bool is_enabled = false;
+        uint32_t code = 0b11111001101011111100110101101101;
+        // minimum normalised correlation from 0 to 1
+        // Payload data can reach about 0.84 while a clean preamble is around 0.86 to 0.95
+        float threshold = 0.85f;
+        // symbols after a seeded preamble during which other peaks are ignored
+        // This is about the length of a frame so that its payload can't reseed the loops
+        // A preamble which is skipped is still decoded since the loops are already tracking
+        float holdoff = 424.0f;
+        // A loop is only seeded if it is further than this from the preamble's estimate
+        // Otherwise it is already tracking better than a short preamble can estimate
+        float max_phase_error = 0.6f;           // radians
+        float max_frequency_error = 0.2f;       // fraction of the carrier pll's f_gain
+        float max_timing_error = 0.2f;          // symbols
+    } preamble;
+
     // timing error detector
     struct {
         float f_offset = 0e3;
@@ -0,0 +1,79 @@
+#include "qam_sync_telemetry.h"
+#include <algorithm>
+#include "utility/profiler.h"
+
+// Split x into buckets and store the [min,max] of each one
+// If there are fewer samples than buckets then samples are repeated
+template <typename T, typename F>
+static void ReduceMinMax(tcb::span<T> x, MinMax_Trace& y, F&& get) {
+    const int64_t N = (int64_t)x.size();
+    const int64_t B = (int64_t)y.GetTotalBuckets();
+    auto* y0 = y.data.data();
+    if (N == 0) {
+        std::fill_n(y0, 2*B, 0.0f);
+        return;
+    }
+
+    for (int64_t b = 0; b < B; b++) {
+        const int64_t i0 = (b*N)/B;
+        const int64_t i1 = std::max(i0+1, ((b+1)*N)/B);
+        float v_min = get(x[i0]);
+        float v_max = v_min;
+        for (int64_t i = i0+1; i < i1; i++) {
+            const float v = get(x[i]);
+            v_min = std::min(v_min, v);
+            v_max = std::max(v_max, v);
+        }
+        y0[2*b+0] = v_min;
+        y0[2*b+1] = v_max;
+    }
+}
+
+// Take evenly spaced points if there are more than will fit
+template <typename T>
+static int DecimatePoints(tcb::span<T> x, std::vector<std::complex<float>>& y) {
+    const int64_t N = (int64_t)x.size();
+    const int64_t M = (int64_t)y.size();
+    if (N <= M) {
+        std::copy_n(x.begin(), N, y.begin());
+        return (int)N;
+    }
+    for (int64_t i = 0; i < M; i++) {
+        y[i] = x[(i*N)/M];
+    }
+    return (int)M;
+}
+
+void QAM_Synchroniser_Telemetry::Publish(const QAM_Synchroniser_Buffer& buffer, const int total_symbols) {
+    PROFILE_BEGIN(telemetry_publish);
+    auto& frame = frames.GetBack();
+    frame.input_size = buffer.GetInputSize();
+    frame.block_index = total_blocks++;
+
+    auto get_I = [](const auto x) { return (float)x.real(); };
+    auto get_Q = [](const auto x) { return (float)x.imag(); };
+    auto get_value = [](const auto x) { return (float)x; };
+
+    ReduceMinMax(buffer.x_raw, frame.x_raw_I, get_I);
+    ReduceMinMax(buffer.x_raw, frame.x_raw_Q, get_Q);
+    ReduceMinMax(buffer.x_downsampled, frame.x_downsampled_I, get_I);
+    ReduceMinMax(buffer.x_downsampled, frame.x_downsampled_Q, get_Q);
+    ReduceMinMax(buffer.x_pll_out, frame.x_pll_out_I, get_I);
+    ReduceMinMax(buffer.x_pll_out, frame.x_pll_out_Q, get_Q);
+    ReduceMinMax(buffer.error_pll, frame.error_pll, get_value);
+
+    ReduceMinMax(buffer.x_upsampled, frame.x_upsampled_I, get_I);
+    ReduceMinMax(buffer.x_upsampled, frame.x_upsampled_Q, get_Q);
+    ReduceMinMax(buffer.y_sym_out, frame.y_sym_out_I, get_I);
+    ReduceMinMax(buffer.y_sym_out, frame.y_sym_out_Q, get_Q);
+    ReduceMinMax(buffer.error_ted, frame.error_ted, get_value);
+    ReduceMinMax(buffer.trig_zero_crossing, frame.trig_zero_crossing, get_value);
+    ReduceMinMax(buffer.trig_ted_clock, frame.trig_ted_clock, get_value);
+    ReduceMinMax(buffer.trig_integrator_dump, frame.trig_integrator_dump, get_value);
+
+    frame.total_symbols = DecimatePoints(buffer.y_out.first(total_symbols), frame.y_out);
+    frame.total_pll_points = DecimatePoints(buffer.x_pll_out, frame.x_pll_out);
+
+    frames.Publish();
+    PROFILE_END(telemetry_publish);
+}
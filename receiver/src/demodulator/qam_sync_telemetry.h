@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <complex>
+#include <vector>
+#include "qam_sync_buffers.h"
+#include "utility/triple_buffer.h"
+
+// Signal reduced to a fixed number of buckets where each bucket is stored as [min,max]
+// Drawing the pairs as one line keeps the envelope and any spikes of the full rate signal
+class MinMax_Trace
+{
+public:
+    std::vector<float> data;
+public:
+    MinMax_Trace(const int total_buckets): data(2*total_buckets, 0.0f) {}
+    int GetTotalBuckets() const { return (int)data.size()/2; }
+    int GetTotalPoints() const { return (int)data.size(); }
+};
+
+// Reduced copy of the telemetry in QAM_Synchroniser_Buffer for the GUI
+// This is a few tens of kilobytes regardless of the block size
+struct QAM_Synchroniser_Telemetry_Frame
+{
+    const int total_buckets;
+    const int max_points;
+    // number of input samples covered by the traces
+    int input_size = 0;
+    uint64_t block_index = 0;
+    // Downsampled PLL
+    MinMax_Trace x_raw_I, x_raw_Q;
+    MinMax_Trace x_downsampled_I, x_downsampled_Q;
+    MinMax_Trace x_pll_out_I, x_pll_out_Q;
+    MinMax_Trace error_pll;
+    // Upsampled TED
+    MinMax_Trace x_upsampled_I, x_upsampled_Q;
+    MinMax_Trace y_sym_out_I, y_sym_out_Q;
+    MinMax_Trace error_ted;
+    MinMax_Trace trig_zero_crossing;
+    MinMax_Trace trig_ted_clock;
+    MinMax_Trace trig_integrator_dump;
+    // Constellation points where the PLL output is decimated to fit
+    std::vector<std::complex<float>> y_out;
+    std::vector<std::complex<float>> x_pll_out;
+    int total_symbols = 0;
+    int total_pll_points = 0;
+
+    QAM_Synchroniser_Telemetry_Frame(const int _total_buckets, const int _max_points)
+    : total_buckets(_total_buckets), max_points(_max_points),
+      x_raw_I(_total_buckets), x_raw_Q(_total_buckets),
+      x_downsampled_I(_total_buckets), x_downsampled_Q(_total_buckets),
+      x_pll_out_I(_total_buckets), x_pll_out_Q(_total_buckets),
+      error_pll(_total_buckets),
+      x_upsampled_I(_total_buckets), x_upsampled_Q(_total_buckets),
+      y_sym_out_I(_total_buckets), y_sym_out_Q(_total_buckets),
+      error_ted(_total_buckets),
+      trig_zero_crossing(_total_buckets),
+      trig_ted_clock(_total_buckets),
+      trig_integrator_dump(_total_buckets),
+      y_out(_max_points), x_pll_out(_max_points) {}
+};
+
+// Publishes reduced telemetry from the demodulator thread to the GUI thread
+// Frames are passed through a triple buffer so neither thread waits on the other
+class QAM_Synchroniser_Telemetry
+{
+private:
+    TripleBuffer<QAM_Synchroniser_Telemetry_Frame> frames;
+    uint64_t total_blocks = 0;
+public:
+    // total_buckets = number of [min,max] pairs per trace
+    // max_points = maximum number of constellation points
+    QAM_Synchroniser_Telemetry(const int total_buckets=512, const int max_points=1024)
+    : frames(total_buckets, max_points) {}
+    // Producer: reduce the buffer's telemetry into a new frame
+    // NOTE: The buffer must have been allocated with telemetry
+    void Publish(const QAM_Synchroniser_Buffer& buffer, const int total_symbols);
+    // Consumer: return true if a newer frame is available
+    bool Update() { return frames.Update(); }
+    const QAM_Synchroniser_Telemetry_Frame& GetFrame() const { return frames.GetFront(); }
+};
@@ -1,26 +1,31 @@
 #pragma once
 
-#include "dsp/integrator.h"
+#include <stdint.h>
+#include "dsp/nco.h"
 #include "dsp/common.h"
 
 // timing error detector clock
 class TED_Clock 
 {
 public:
-    Integrator_Block<float> integrator; // used as ramp oscillator for symbol timing from 0 to 1
+    float Ts;
+    uint32_t phase;     // used as ramp oscillator for symbol timing where 2^32 is one symbol
     float phase_error;
     float phase_error_gain;      // the phase error is +-1 from zero crossing detector
     float fcenter;
     float fgain;
 public:
     TED_Clock() {
+        Ts = 1.0f;
+        phase = 0;
         phase_error = 0.0f;
         phase_error_gain = 1.0f; 
         fcenter = 10e3f;
         fgain = 5e3f;
     }
 
-    float get_current_timing() const { return integrator.yn; }
+    // symbol timing from 0 to 1
+    float get_current_timing() const { return (float)((double)phase / NCO_PHASE_SCALE); }
 
     // normalised error between -1 to 1
     float get_timing_error() const {
@@ -36,17 +41,38 @@ public:
 
     // return true if the oscillator resets this sample
     bool update() {
-        float control = phase_error * phase_error_gain;
-        control = dsp::clamp(control, -1.0f, 1.0f);
-        const float freq = fcenter + control*fgain;
-        const float v = integrator.process(freq);
-        const float offset = integrator.KTs * freq / 2.0f;
+        const uint32_t dphase = GetNCOPhaseIncrement(get_frequency()*Ts);
+        // reset on the sample closest to the end of the symbol
+        const uint64_t v = (uint64_t)phase + (uint64_t)dphase;
+        const uint64_t threshold = (uint64_t)NCO_PHASE_SCALE - (uint64_t)(dphase/2);
+
+        if (v < threshold) {
+            phase = (uint32_t)v;
+            return false;
+        }
+        // reset oscillator otherwise
+        phase = 0;
+        return true;
+    }
 
-        if (v < (1.0f-offset)) {
+    // Free running oscillator for an interpolating timing loop
+    // return true if the oscillator wraps this sample
+    // mu = fraction of the sample period after the previous sample where the wrap occurred
+    bool update_interpolated(float& mu) {
+        const uint32_t dphase = GetNCOPhaseIncrement(get_frequency()*Ts);
+        const uint32_t prev_phase = phase;
+        phase += dphase;
+        if (phase >= prev_phase) {
             return false;
         }
-        // reset integrator otherwise
-        integrator.yn = 0.0f;
+        const uint32_t dphase_wrap = 0u - prev_phase;
+        mu = (float)((double)dphase_wrap / (double)dphase);
         return true;
     }
+private:
+    float get_frequency() const {
+        float control = phase_error * phase_error_gain;
+        control = dsp::clamp(control, -1.0f, 1.0f);
+        return fcenter + control*fgain;
+    }
 };
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <complex>
+#include "simd/c32_ac_couple.h"
+
+// First order high pass filter which removes the dc offset of the signal
+// y[n] = x[n] - x[n-1] + k*y[n-1]
+// Same response as an IIR_Filter made with create_iir_ac_filter
+// Block processing is vectorised with a look-ahead formulation of the recursion
+class AC_Coupling_Filter
+{
+private:
+    std::complex<float> x_prev;
+    std::complex<float> y_prev;
+public:
+    // 0 <= k <= 1.0f
+    float k;
+public:
+    AC_Coupling_Filter(const float _k=0.9999f)
+    : x_prev(0.0f), y_prev(0.0f), k(_k) {}
+
+    // x and y can be the same buffer
+    void process(const std::complex<float>* x, std::complex<float>* y, const int N) {
+        c32_ac_couple_auto(x, y, N, k, x_prev, y_prev);
+    }
+};
@@ -1,7 +1,16 @@
 #pragma once
 
 #include <cmath>
+#include <complex>
+#include <algorithm>
+#include <type_traits>
+#include "simd/c32_sum_power.h"
+#include "simd/c32_gain_ramp.h"
 
+// Scales the signal towards a target power
+// The power is measured over sub-blocks and the gain is interpolated across each one
+// This way the gain has no steps at the boundaries of a sub-block
+// Without sub-blocks the updated gain is applied to the whole call like before
 template <typename T>
 class AGC_Filter 
 {
@@ -9,23 +18,59 @@ public:
     float target_power = 1.0f;
     float current_gain = 0.1f;
     float beta = 0.2f;
+    // samples between updates of the gain where 0 updates once per call with a constant gain
+    int block_size = 0;
     void process(const T* x, T* y, const int N) {
-        const float avg_power = calculate_average_power(x, N);
-        const float target_gain = std::sqrt(target_power/avg_power);
-        current_gain = current_gain + beta*(target_gain - current_gain);
-        for (int i = 0; i < N; i++) {
-            y[i] = current_gain*x[i];
+        if (block_size <= 0) {
+            process_block(x, y, N, false);
+            return;
+        }
+        const int B = block_size;
+        for (int i = 0; i < N; i += B) {
+            const int N_block = std::min(B, N-i);
+            process_block(&x[i], &y[i], N_block, true);
         }
     }
 private:
+    void process_block(const T* x, T* y, const int N, const bool is_ramp) {
+        const float avg_power = calculate_average_power(x, N);
+        // hold the gain while the signal is silent
+        float next_gain = current_gain;
+        if (avg_power > 0.0f) {
+            const float target_gain = std::sqrt(target_power/avg_power);
+            next_gain = current_gain + beta*(target_gain - current_gain);
+        }
+        if (is_ramp) {
+            const float dg = (next_gain - current_gain)/(float)N;
+            apply_gain_ramp(x, y, N, current_gain, dg);
+        } else {
+            apply_gain_ramp(x, y, N, next_gain, 0.0f);
+        }
+        current_gain = next_gain;
+    }
+
     float calculate_average_power(const T* x, const int N) {
-        float avg_power = 0.0f;
-        for (int i = 0; i < N; i++) {
-            const float I = x[i].real();
-            const float Q = x[i].imag();
-            avg_power += (I*I + Q*Q);
+        if constexpr(std::is_same_v<T, std::complex<float>>) {
+            return c32_sum_power_auto(x, N) / (float)N;
+        } else {
+            float avg_power = 0.0f;
+            for (int i = 0; i < N; i++) {
+                const float I = x[i].real();
+                const float Q = x[i].imag();
+                avg_power += (I*I + Q*Q);
+            }
+            avg_power /= (float)N;
+            return avg_power;
+        }
+    }
+
+    void apply_gain_ramp(const T* x, T* y, const int N, const float g0, const float dg) {
+        if constexpr(std::is_same_v<T, std::complex<float>>) {
+            c32_gain_ramp_auto(x, y, N, g0, dg);
+        } else {
+            for (int i = 0; i < N; i++) {
+                y[i] = (g0 + (float)(i+1)*dg)*x[i];
+            }
         }
-        avg_power /= (float)N;
-        return avg_power;
     }
-};
\ No newline at end of file
+};
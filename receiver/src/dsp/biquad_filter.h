@@ -0,0 +1,100 @@
+#pragma once
+
+#include <assert.h>
+#include "utility/aligned_vector.h"
+#include "simd/f32_biquad.h"
+
+// Second order section
+// H(z) = (b0 + b1*z^-1 + b2*z^-2) / (1 - a1*z^-1 - a2*z^-2)
+// NOTE: The feedback coefficients have the same sign as IIR_Filter
+struct Biquad_Section {
+    float b0 = 1.0f;
+    float b1 = 0.0f;
+    float b2 = 0.0f;
+    float a1 = 0.0f;
+    float a2 = 0.0f;
+};
+
+// Convert the taps made for an IIR_Filter by the filter designer into a section
+// The designer stores the taps time reversed, i.e. b[K-1] is applied to x[n]
+// K = 2 or 3 taps
+inline Biquad_Section create_biquad_section(const float* b, const float* a, const int K) {
+    assert((K == 2) || (K == 3));
+    Biquad_Section s;
+    s.b0 = b[K-1];
+    s.b1 = b[K-2];
+    s.a1 = a[K-2];
+    if (K == 3) {
+        s.b2 = b[K-3];
+        s.a2 = a[K-3];
+    }
+    return s;
+}
+
+// Cascade of second order sections in transposed direct form II
+// Each of the C channels is an independent cascade which are filtered together across the SIMD lanes
+// Samples are interleaved by channel, i.e. x[n*C + c], which is the layout of Frame<float>
+class Biquad_Filter_Bank
+{
+private:
+    const int C;
+    const int S;
+    // [s][b0 b1 b2 a1 a2][c]
+    AlignedVector<float> coeffs;
+    // [s][s1 s2][c]
+    AlignedVector<float> state;
+public:
+    // C = number of channels, S = number of sections in each cascade
+    // Each section starts as a passthrough
+    Biquad_Filter_Bank(const int _C=1, const int _S=1)
+    : C(_C), S(_S),
+      coeffs(_S*5*_C), state(_S*2*_C)
+    {
+        assert(C > 0);
+        assert(S > 0);
+        for (int s = 0; s < S; s++) {
+            set_section(s, Biquad_Section());
+        }
+        reset();
+    }
+
+    // Set the same section for all channels
+    void set_section(const int s, const Biquad_Section& section) {
+        for (int c = 0; c < C; c++) {
+            set_section(c, s, section);
+        }
+    }
+
+    void set_section(const int c, const int s, const Biquad_Section& section) {
+        assert((c >= 0) && (c < C));
+        assert((s >= 0) && (s < S));
+        float* v = &coeffs[s*5*C];
+        v[0*C + c] = section.b0;
+        v[1*C + c] = section.b1;
+        v[2*C + c] = section.b2;
+        v[3*C + c] = section.a1;
+        v[4*C + c] = section.a2;
+    }
+
+    void reset() {
+        for (auto& v: state) {
+            v = 0.0f;
+        }
+    }
+
+    // x and y hold N samples of C interleaved channels and can be the same buffer
+    // Each section is run over the whole block before the next one
+    void process(const float* x, float* y, const int N) {
+        if (x != y) {
+            for (int i = 0; i < N*C; i++) {
+                y[i] = x[i];
+            }
+        }
+        for (int s = 0; s < S; s++) {
+            f32_biquad_auto(y, N, &coeffs[s*5*C], &state[s*2*C], C);
+        }
+    }
+
+    int get_channels() const { return C; }
+    int get_sections() const { return S; }
+};
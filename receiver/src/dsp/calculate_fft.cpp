@@ -0,0 +1,285 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <assert.h>
+#include <stdint.h>
+
+#include "calculate_fft.h"
+#include "simd/c32_fft_butterfly.h"
+#include "utility/lru_cache.h"
+
+// NOTE: Twiddles are computed in double precision so large transforms stay accurate
+static std::complex<float> GetTwiddle(const int k, const int N) {
+    const double phase = -2.0*M_PI*(double)k/(double)N;
+    return std::complex<float>((float)std::cos(phase), (float)std::sin(phase));
+}
+
+FFT_Plan::FFT_Plan(const int _N)
+: N(_N)
+{
+    assert(N > 0);
+    if ((N & (N-1)) != 0) {
+        CreateChirp();
+        return;
+    }
+
+    int total_bits = 0;
+    while ((1 << total_bits) < N) {
+        total_bits++;
+    }
+
+    bit_reversed.resize(N);
+    for (int i = 0; i < N; i++) {
+        int j = 0;
+        for (int b = 0; b < total_bits; b++) {
+            j |= ((i >> b) & 0b1) << (total_bits-1-b);
+        }
+        bit_reversed[i] = j;
+    }
+
+    int total_twiddles = 0;
+    int h = 1;
+    for (; 4*h <= N; h *= 4) {
+        stages.push_back({ 4, h, total_twiddles });
+        total_twiddles += 2*h;
+    }
+    if (2*h == N) {
+        stages.push_back({ 2, h, total_twiddles });
+        total_twiddles += h;
+    }
+
+    twiddles_forward = AlignedVector<std::complex<float>>(total_twiddles);
+    twiddles_inverse = AlignedVector<std::complex<float>>(total_twiddles);
+    for (const auto& stage: stages) {
+        auto* w = &twiddles_forward.data()[stage.w_offset];
+        if (stage.radix == 4) {
+            for (int k = 0; k < stage.h; k++) {
+                w[k] = GetTwiddle(k, 2*stage.h);
+                w[stage.h+k] = GetTwiddle(k, 4*stage.h);
+            }
+        } else {
+            for (int k = 0; k < stage.h; k++) {
+                w[k] = GetTwiddle(k, 2*stage.h);
+            }
+        }
+    }
+    for (int i = 0; i < total_twiddles; i++) {
+        twiddles_inverse[i] = std::conj(twiddles_forward[i]);
+    }
+}
+
+// y[k] = sum x[n] e^(-j2pi.k.n/N)
+// Since 2.k.n = k^2 + n^2 - (k-n)^2 this becomes
+// y[k] = c[k] sum (x[n] c[n]) c*[k-n] where c[n] = e^(-j.pi.n^2/N)
+// The sum is a linear convolution which we do as a circular one of length M >= 2N-1
+void FFT_Plan::CreateChirp() {
+    int M = 1;
+    while (M < (2*N-1)) {
+        M *= 2;
+    }
+    chirp_plan = std::make_unique<FFT_Plan>(M);
+    chirp = AlignedVector<std::complex<float>>(N);
+    chirp_filter = AlignedVector<std::complex<float>>(M);
+    chirp_scratch = AlignedVector<std::complex<float>>(M);
+
+    // NOTE: n^2 is reduced modulo 2N so that the phase stays accurate for large n
+    for (int n = 0; n < N; n++) {
+        const int k = (int)(((int64_t)n*(int64_t)n) % (int64_t)(2*N));
+        chirp[n] = GetTwiddle(k, 2*N);
+    }
+
+    // c*[k-n] for k-n = (-N,N) wrapped around M
+    auto* h = chirp_filter.data();
+    for (int i = 0; i < M; i++) {
+        h[i] = 0.0f;
+    }
+    h[0] = std::conj(chirp[0]);
+    for (int n = 1; n < N; n++) {
+        h[n] = std::conj(chirp[n]);
+        h[M-n] = std::conj(chirp[n]);
+    }
+    chirp_plan->Forward(h, h);
+    const float scale = 1.0f/(float)M;
+    for (int i = 0; i < M; i++) {
+        h[i] *= scale;
+    }
+}
+
+void FFT_Plan::Forward(const std::complex<float>* x, std::complex<float>* y) const {
+    Execute(x, y, false);
+}
+
+void FFT_Plan::Inverse(const std::complex<float>* x, std::complex<float>* y) const {
+    Execute(x, y, true);
+}
+
+void FFT_Plan::Execute(const std::complex<float>* x, std::complex<float>* y, const bool is_inverse) const {
+    if (chirp_plan != NULL) {
+        ExecuteChirp(x, y, is_inverse);
+        return;
+    }
+
+    if (x == y) {
+        for (int i = 0; i < N; i++) {
+            const int j = bit_reversed[i];
+            if (i < j) {
+                std::swap(y[i], y[j]);
+            }
+        }
+    } else {
+        for (int i = 0; i < N; i++) {
+            y[bit_reversed[i]] = x[i];
+        }
+    }
+
+    const auto& twiddles = is_inverse ? twiddles_inverse : twiddles_forward;
+    for (const auto& stage: stages) {
+        const auto* w = &twiddles.data()[stage.w_offset];
+        if (stage.radix == 4) {
+            c32_fft_radix4_auto(y, w, &w[stage.h], stage.h, N, is_inverse);
+        } else {
+            c32_fft_radix2_auto(y, w, stage.h, N);
+        }
+    }
+}
+
+// The inverse transform is the same with the conjugate of each chirp
+// Since the chirp filter is symmetric its transform is also conjugated
+void FFT_Plan::ExecuteChirp(const std::complex<float>* x, std::complex<float>* y, const bool is_inverse) const {
+    const int M = chirp_plan->GetSize();
+    const auto* c = chirp.data();
+    const auto* h = chirp_filter.data();
+    auto* z = chirp_scratch.data();
+
+    if (is_inverse) {
+        for (int n = 0; n < N; n++) {
+            z[n] = x[n]*std::conj(c[n]);
+        }
+    } else {
+        for (int n = 0; n < N; n++) {
+            z[n] = x[n]*c[n];
+        }
+    }
+    for (int n = N; n < M; n++) {
+        z[n] = 0.0f;
+    }
+
+    chirp_plan->Forward(z, z);
+    if (is_inverse) {
+        for (int i = 0; i < M; i++) {
+            z[i] *= std::conj(h[i]);
+        }
+    } else {
+        for (int i = 0; i < M; i++) {
+            z[i] *= h[i];
+        }
+    }
+    chirp_plan->Inverse(z, z);
+
+    if (is_inverse) {
+        for (int k = 0; k < N; k++) {
+            y[k] = z[k]*std::conj(c[k]);
+        }
+    } else {
+        for (int k = 0; k < N; k++) {
+            y[k] = z[k]*c[k];
+        }
+    }
+}
+
+// Even and odd samples are packed into a complex transform of length H = N/2
+// z[n] = x[2n] + j.x[2n+1] --> Z[k] = E[k] + j.O[k]
+// The spectrums of even and odd samples are separated using conjugate symmetry
+// E[k] = (Z[k] + Z*[H-k])/2
+// O[k] = (Z[k] - Z*[H-k])/2j
+// X[k] = E[k] + W_N^k.O[k]
+// X[H-k] = (E[k] - W_N^k.O[k])*
+Real_FFT_Plan::Real_FFT_Plan(const int _N)
+: N(_N), plan(_N/2), twiddles(_N/2)
+{
+    assert((N >= 2) && ((N % 2) == 0));
+    for (int k = 0; k < N/2; k++) {
+        twiddles[k] = GetTwiddle(k, N);
+    }
+}
+
+void Real_FFT_Plan::Forward(const float* x, std::complex<float>* y) const {
+    const int H = N/2;
+    plan.Forward(reinterpret_cast<const std::complex<float>*>(x), y);
+
+    const auto Z0 = y[0];
+    y[0] = { Z0.real() + Z0.imag(), 0.0f };
+    y[H] = { Z0.real() - Z0.imag(), 0.0f };
+
+    for (int k = 1; k <= H/2; k++) {
+        const auto Z0 = y[k];
+        const auto Z1 = std::conj(y[H-k]);
+        const auto E = 0.5f*(Z0 + Z1);
+        const auto O = std::complex<float>(0.0f, -0.5f)*(Z0 - Z1);
+        const auto WO = twiddles.data()[k]*O;
+        y[k] = E + WO;
+        y[H-k] = std::conj(E - WO);
+    }
+}
+
+// Reverse of the forward transform without the factor of 1/2
+// Z[k] = E[k] + j.O[k]
+// E[k] = X[k] + X*[H-k]
+// O[k] = (X[k] - X*[H-k]).W_N^-k
+void Real_FFT_Plan::Inverse(std::complex<float>* x, float* y) const {
+    const int H = N/2;
+    const float X0 = x[0].real();
+    const float XH = x[H].real();
+    x[0] = { X0 + XH, X0 - XH };
+
+    for (int k = 1; k <= H/2; k++) {
+        const auto X0 = x[k];
+        const auto X1 = std::conj(x[H-k]);
+        const auto E = X0 + X1;
+        const auto O = (X0 - X1)*std::conj(twiddles.data()[k]);
+        const auto jO = std::complex<float>(-O.imag(), O.real());
+        x[k] = E + jO;
+        x[H-k] = std::conj(E - jO);
+    }
+
+    plan.Inverse(x, reinterpret_cast<std::complex<float>*>(y));
+}
+
+template <typename T>
+static const T& GetCachedPlan(LRU_Cache<int, T>& plans, const int N) {
+    auto* plan = plans.find(N);
+    if (plan != NULL) {
+        return *plan;
+    }
+    return plans.emplace(N, N);
+}
+
+// NOTE: One cache per thread so that channels running on a thread pool don't contend
+const FFT_Plan& GetFFTPlan(const int N) {
+    static thread_local LRU_Cache<int, FFT_Plan> plans(FFT_PLAN_CACHE_SIZE);
+    return GetCachedPlan(plans, N);
+}
+
+const Real_FFT_Plan& GetRealFFTPlan(const int N) {
+    static thread_local LRU_Cache<int, Real_FFT_Plan> plans(FFT_PLAN_CACHE_SIZE);
+    return GetCachedPlan(plans, N);
+}
+
+void CalculateFFT(tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y) {
+    assert(x.size() == y.size());
+    GetFFTPlan((int)x.size()).Forward(x.data(), y.data());
+}
+
+void CalculateIFFT(tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y) {
+    assert(x.size() == y.size());
+    GetFFTPlan((int)x.size()).Inverse(x.data(), y.data());
+}
+
+void CalculateRealFFT(tcb::span<const float> x, tcb::span<std::complex<float>> y) {
+    assert(y.size() == (x.size()/2 + 1));
+    GetRealFFTPlan((int)x.size()).Forward(x.data(), y.data());
+}
+
+void CalculateRealIFFT(tcb::span<std::complex<float>> x, tcb::span<float> y) {
+    assert(x.size() == (y.size()/2 + 1));
+    GetRealFFTPlan((int)y.size()).Inverse(x.data(), y.data());
+}
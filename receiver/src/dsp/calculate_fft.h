@@ -0,0 +1,88 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+#include <memory>
+#include "utility/aligned_vector.h"
+#include "utility/span.h"
+
+// Discrete fourier transform of a block of any length
+// Forward: y[k] = sum x[n] e^(-j2pi.k.n/N)
+// Inverse: y[n] = sum x[k] e^(+j2pi.k.n/N)
+// NOTE: The inverse transform isn't scaled by 1/N
+
+// Complex transform of length N
+// Input is reordered by bit reversed index followed by radix-4 stages
+// If log2(N) is odd then the last stage is radix-2
+// If N isn't a power of 2 then Bluestein's algorithm turns the transform into a
+// circular convolution with a chirp which is done with a power of 2 plan
+// NOTE: These plans hold scratch memory so they shouldn't be shared between threads
+class FFT_Plan
+{
+private:
+    struct Stage {
+        int radix;
+        int h;
+        // offset into the twiddle tables
+        int w_offset;
+    };
+    const int N;
+    std::vector<int> bit_reversed;
+    std::vector<Stage> stages;
+    AlignedVector<std::complex<float>> twiddles_forward;
+    AlignedVector<std::complex<float>> twiddles_inverse;
+    // Bluestein's algorithm
+    std::unique_ptr<FFT_Plan> chirp_plan;
+    // chirp[n] = e^(-j.pi.n^2/N) for n = [0,N)
+    AlignedVector<std::complex<float>> chirp;
+    // transform of the conjugate chirp which is scaled by the 1/M of the inverse transform
+    AlignedVector<std::complex<float>> chirp_filter;
+    mutable AlignedVector<std::complex<float>> chirp_scratch;
+public:
+    FFT_Plan(const int _N);
+    // x and y can be the same buffer for an in-place transform
+    void Forward(const std::complex<float>* x, std::complex<float>* y) const;
+    void Inverse(const std::complex<float>* x, std::complex<float>* y) const;
+    int GetSize() const { return N; }
+private:
+    void CreateChirp();
+    void Execute(const std::complex<float>* x, std::complex<float>* y, const bool is_inverse) const;
+    void ExecuteChirp(const std::complex<float>* x, std::complex<float>* y, const bool is_inverse) const;
+};
+
+// Real transform of even length N using a complex transform of length N/2
+// Forward: N real samples --> N/2+1 bins from DC to Fs/2
+// Inverse: N/2+1 bins --> N real samples
+class Real_FFT_Plan
+{
+private:
+    const int N;
+    FFT_Plan plan;
+    // twiddles[k] = e^(-j2pi.k/N) for k = [0,N/2)
+    AlignedVector<std::complex<float>> twiddles;
+public:
+    Real_FFT_Plan(const int _N);
+    // y can share the same buffer as x, which must have room for N/2+1 complex samples
+    void Forward(const float* x, std::complex<float>* y) const;
+    // y can share the same buffer as x
+    // NOTE: x is used as scratch memory and is overwritten
+    void Inverse(std::complex<float>* x, float* y) const;
+    int GetSize() const { return N; }
+};
+
+// Plans for each length are cached per thread so repeated calls don't recompute twiddles
+// NOTE: The reference is only valid until the plan is evicted by another length
+constexpr int FFT_PLAN_CACHE_SIZE = 8;
+const FFT_Plan& GetFFTPlan(const int N);
+const Real_FFT_Plan& GetRealFFTPlan(const int N);
+
+// x and y can be the same buffer for an in-place transform
+void CalculateFFT(tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y);
+void CalculateIFFT(tcb::span<const std::complex<float>> x, tcb::span<std::complex<float>> y);
+
+// x = N real samples
+// y = N/2+1 bins
+void CalculateRealFFT(tcb::span<const float> x, tcb::span<std::complex<float>> y);
+// x = N/2+1 bins which are overwritten
+// y = N real samples
+void CalculateRealIFFT(tcb::span<std::complex<float>> x, tcb::span<float> y);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <complex>
+#include <cmath>
+#include <assert.h>
+#include "polyphase_filter.h"
+#include "fft_fir_filter.h"
+#include "filter_designer.h"
+#include "utility/aligned_vector.h"
+
+// Extract a narrowband channel at a frequency offset from a wideband signal
+// x --> mix down by f_offset --> lowpass and downsample by M --> y
+// Long filters are applied with overlap-save instead of a polyphase filter
+class NCO_Channeliser
+{
+private:
+    const int M;
+    const int max_input_size;
+    const double f_offset;
+    Auto_PolyphaseDownsampler<std::complex<float>> filter_ds;
+    // oscillator over one block which is rotated by the phase at the start of each block
+    AlignedVector<std::complex<float>> nco_lut;
+    AlignedVector<std::complex<float>> x_mixed;
+    double nco_phase = 0.0;
+public:
+    // f_offset = frequency of the channel as a fraction of the sampling rate [-0.5,0.5]
+    // M = downsampling factor
+    // K = number of coefficients per phase of the polyphase filter
+    // k = cutoff of the lowpass filter as Fc/(Fs/2) of the wideband signal
+    // max_output_size = maximum number of output samples per block
+    NCO_Channeliser(const float _f_offset, const int _M, const int K, const float k, const int max_output_size)
+    : M(_M), max_input_size(_M*max_output_size), f_offset((double)_f_offset),
+      filter_ds(_M, K),
+      nco_lut(_M*max_output_size), x_mixed(_M*max_output_size)
+    {
+        create_fir_lpf(filter_ds.get_b(), filter_ds.get_K(), k);
+
+        // NOTE: We compute the oscillator in double precision to avoid phase drift over long captures
+        constexpr double PI = 3.14159265358979323846;
+        for (int i = 0; i < max_input_size; i++) {
+            const double phase = -2.0*PI*f_offset*(double)i;
+            nco_lut[i] = std::complex<float>((float)std::cos(phase), (float)std::sin(phase));
+        }
+    }
+
+    // x = input of length M*N
+    // y = output of length N
+    void process(const std::complex<float>* x, std::complex<float>* y, const int N) {
+        const int N_in = N*M;
+        assert(N_in <= max_input_size);
+
+        const auto nco_start = std::complex<float>((float)std::cos(nco_phase), (float)std::sin(nco_phase));
+        for (int i = 0; i < N_in; i++) {
+            x_mixed[i] = x[i] * (nco_lut[i] * nco_start);
+        }
+
+        constexpr double PI = 3.14159265358979323846;
+        nco_phase = std::fmod(nco_phase - 2.0*PI*f_offset*(double)N_in, 2.0*PI);
+
+        filter_ds.process(x_mixed.data(), y, N);
+    }
+
+    int GetDownsamplingFactor() const { return M; }
+    float GetFrequencyOffset() const { return (float)f_offset; }
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+// Fractional delay interpolator using a cubic lagrange polynomial in farrow form
+// The last 4 samples x[n-3],x[n-2],x[n-1],x[n] are fitted with a cubic
+// and evaluated between x[n-2] and x[n-1] so the interpolant is centred on its support
+// y(mu) = ((c3*mu + c2)*mu + c1)*mu + c0, where mu = [0,1]
+// NOTE: Evaluating the centre interval adds one sample of delay
+template <typename T>
+class Farrow_Interpolator
+{
+private:
+    T xn[4];
+public:
+    Farrow_Interpolator() {
+        for (int i = 0; i < 4; i++) {
+            xn[i] = T(0);
+        }
+    }
+
+    void push(const T x) {
+        xn[0] = xn[1];
+        xn[1] = xn[2];
+        xn[2] = xn[3];
+        xn[3] = x;
+    }
+
+    // mu = fractional position from x[n-2] to x[n-1]
+    T interpolate(const float mu) const {
+        const T c0 = xn[1];
+        const T c1 = -(1.0f/3.0f)*xn[0] - 0.5f*xn[1] + xn[2] - (1.0f/6.0f)*xn[3];
+        const T c2 = 0.5f*(xn[0] + xn[2]) - xn[1];
+        const T c3 = (1.0f/6.0f)*(xn[3] - xn[0]) + 0.5f*(xn[1] - xn[2]);
+        return ((c3*mu + c2)*mu + c1)*mu + c0;
+    }
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <complex>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <assert.h>
+#include <stdint.h>
+#include "calculate_fft.h"
+#include "fir_filter.h"
+#include "polyphase_filter.h"
+#include "simd/c8_f32_cum_mul.h"
+#include "utility/aligned_vector.h"
+
+// Number of taps per input sample where overlap-save becomes faster than direct form
+// Measured with receiver_bench filter/fir/c32/K=* against filter/fft_fir/c32/K=* using avx2
+// At 32 taps both are about 9ns/sample for blocks of 256 to 4096 samples
+constexpr int FFT_FIR_CROSSOVER_TAPS = 32;
+
+// Direct form costs K/M multiplies per input sample while overlap-save is roughly constant
+// K = total taps
+// M = downsampling factor
+static inline bool IsFFTFilterFaster(const int K, const int M=1) {
+    return (K/M) >= FFT_FIR_CROSSOVER_TAPS;
+}
+
+// FIR filter using overlap-save fast convolution
+// Each FFT of N_fft samples produces N_fft-(K-1) outputs from the previous K-1 inputs and the new samples
+// Blocks smaller than this are transformed immediately so there is no added latency
+//
+// T = output type
+// U = input type, which can differ if we convert while filling the window
+//     E.g. raw 8bit IQ samples are filtered straight into complex floats
+// M = downsampling factor where we keep every Mth output
+// NOTE: When downsampling the full rate output is still computed, but this is cheap compared to direct form
+template <typename T, typename U = T>
+class FFT_FIR_Filter
+{
+private:
+    static constexpr bool IS_REAL = std::is_same<T, float>::value;
+    using Plan = typename std::conditional<IS_REAL, Real_FFT_Plan, FFT_Plan>::type;
+
+    const int K;
+    const int M;
+    const int N_fft;
+    // number of new input samples per transform, which is a multiple of M
+    const int N_hop;
+    const int N_bins;
+    const Plan plan;
+    AlignedVector<float> b;
+    // frequency response scaled by 1/N_fft for the unscaled inverse transform
+    AlignedVector<std::complex<float>> H;
+    // K-1 previous inputs followed by the new inputs
+    AlignedVector<T> x_window;
+    AlignedVector<std::complex<float>> X;
+    // the response is recalculated if get_b() was called since it may have been modified
+    mutable bool is_b_changed = true;
+public:
+    float* get_b() const { is_b_changed = true; return b.data(); }
+    int    get_K() const { return K; }
+public:
+    // K = total number of taps
+    // M = downsampling factor
+    // x0 = initial value of the input history, which should be the input's zero level
+    FFT_FIR_Filter(const int _K, const int _M=1, const U x0 = U(0))
+    : K(_K), M(_M),
+      N_fft(GetTransformSize(_K, _M)),
+      N_hop(((N_fft-(_K-1))/_M)*_M),
+      N_bins(IS_REAL ? (N_fft/2+1) : N_fft),
+      plan(N_fft),
+      b(_K), H(N_bins), x_window(N_fft), X(N_bins)
+    {
+        assert(N_hop >= M);
+        for (int i = 0; i < K; i++) {
+            b[i] = 0.0f;
+        }
+        const T y0 = convert_input(x0);
+        for (int i = 0; i < N_fft; i++) {
+            x_window[i] = y0;
+        }
+    }
+
+    // x = input of length N*M
+    // y = output of length N
+    // NOTE: x and y can be the same buffer if there is no downsampling
+    void process(const U* x, T* y, const int N) {
+        if (is_b_changed) {
+            update_response();
+        }
+
+        const int N_in = N*M;
+        const int L = K-1;
+        for (int i = 0; i < N_in;) {
+            const int N_chunk = std::min(N_hop, N_in-i);
+            for (int j = 0; j < N_chunk; j++) {
+                x_window[L+j] = convert_input(x[i+j]);
+            }
+
+            // Circular convolution is only valid for outputs [L,L+N_chunk)
+            // These only depend on the window up to L+N_chunk so the stale tail is ignored
+            const T* z = apply_filter();
+            for (int j = M-1, k = i/M; j < N_chunk; j += M, k++) {
+                y[k] = z[L+j];
+            }
+
+            for (int j = 0; j < L; j++) {
+                x_window[j] = x_window[N_chunk+j];
+            }
+            i += N_chunk;
+        }
+    }
+
+    int GetTransformSize() const { return N_fft; }
+private:
+    // Transforms of 4x the filter length keep most of each window as new samples
+    static int GetTransformSize(const int K, const int M) {
+        int N = 4;
+        while (N < 4*K || (N-(K-1)) < M) {
+            N *= 2;
+        }
+        return N;
+    }
+
+    static T convert_input(const U x) {
+        if constexpr(std::is_same<U, std::complex<uint8_t>>::value) {
+            return T(
+                static_cast<float>(x.real()) - C8_IQ_OFFSET,
+                static_cast<float>(x.imag()) - C8_IQ_OFFSET);
+        } else {
+            return T(x);
+        }
+    }
+
+    // The taps are stored in reverse so that b[K-1] multiplies the newest sample
+    void update_response() {
+        is_b_changed = false;
+        AlignedVector<T> h(N_fft);
+        const float scale = 1.0f/(float)N_fft;
+        for (int i = 0; i < N_fft; i++) {
+            h[i] = (i < K) ? T(b[K-1-i]*scale) : T(0);
+        }
+        plan.Forward(h.data(), H.data());
+    }
+
+    // Returns the full rate output over the window
+    const T* apply_filter() {
+        plan.Forward(x_window.data(), X.data());
+        auto* X0 = X.data();
+        auto* H0 = H.data();
+        for (int i = 0; i < N_bins; i++) {
+            X0[i] *= H0[i];
+        }
+        if constexpr(IS_REAL) {
+            auto* z = reinterpret_cast<float*>(X0);
+            plan.Inverse(X0, z);
+            return z;
+        } else {
+            plan.Inverse(X0, X0);
+            return X0;
+        }
+    }
+};
+
+// Uses direct form below the crossover and overlap-save above it
+template <typename T>
+class Auto_FIR_Filter
+{
+private:
+    std::unique_ptr<FIR_Filter<T>> filter_direct;
+    std::unique_ptr<FFT_FIR_Filter<T>> filter_fft;
+public:
+    Auto_FIR_Filter(const int K) {
+        if (IsFFTFilterFaster(K)) {
+            filter_fft = std::make_unique<FFT_FIR_Filter<T>>(K);
+        } else {
+            filter_direct = std::make_unique<FIR_Filter<T>>(K);
+        }
+    }
+    float* get_b() const { return filter_fft ? filter_fft->get_b() : filter_direct->get_b(); }
+    int    get_K() const { return filter_fft ? filter_fft->get_K() : filter_direct->get_K(); }
+    bool   IsUsingFFT() const { return filter_fft != NULL; }
+    void process(const T* x, T* y, const int N) {
+        if (filter_fft) {
+            filter_fft->process(x, y, N);
+        } else {
+            filter_direct->process(x, y, N);
+        }
+    }
+};
+
+// Uses a polyphase filter below the crossover and overlap-save above it
+template <typename T, typename U = T>
+class Auto_PolyphaseDownsampler
+{
+private:
+    std::unique_ptr<PolyphaseDownsampler<T,U>> filter_direct;
+    std::unique_ptr<FFT_FIR_Filter<T,U>> filter_fft;
+public:
+    // M = downsampling factor
+    // K = total coefficients per phase
+    // x0 = initial value of the input history, which should be the input's zero level
+    Auto_PolyphaseDownsampler(const int M, const int K, const U x0 = U(0)) {
+        if (IsFFTFilterFaster(M*K, M)) {
+            filter_fft = std::make_unique<FFT_FIR_Filter<T,U>>(M*K, M, x0);
+        } else {
+            filter_direct = std::make_unique<PolyphaseDownsampler<T,U>>(M, K, x0);
+        }
+    }
+    float* get_b() const { return filter_fft ? filter_fft->get_b() : filter_direct->get_b(); }
+    int    get_K() const { return filter_fft ? filter_fft->get_K() : filter_direct->get_K(); }
+    bool   IsUsingFFT() const { return filter_fft != NULL; }
+    void process(const U* x, T* y, const int N) {
+        if (filter_fft) {
+            filter_fft->process(x, y, N);
+        } else {
+            filter_direct->process(x, y, N);
+        }
+    }
+};
@@ -4,7 +4,7 @@
 #include "utility/span.h"
 
 // Performs the Hilbert transform using spectral manipulation via FFT
-void HilbertFFTTransform(tcb::span<const float> x, tcb::span<std::complex<float>> y) {
+inline void HilbertFFTTransform(tcb::span<const float> x, tcb::span<std::complex<float>> y) {
     const size_t N = x.size();
     const size_t M = N/2;
     for (size_t i = 0; i < N; i++) {
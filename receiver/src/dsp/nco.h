@@ -0,0 +1,101 @@
+#pragma once
+
+#include <complex>
+#include <cmath>
+#include <stdint.h>
+#include "utility/aligned_vector.h"
+
+// Oscillator phase as a 32bit fixed point fraction of a cycle
+// Adding the increment wraps around at 2^32 so the phase never drifts over long captures
+constexpr double NCO_PHASE_SCALE = 4294967296.0;
+
+// f = frequency as a fraction of the sampling rate [-0.5,0.5]
+static inline uint32_t GetNCOPhaseIncrement(const float f) {
+    return static_cast<uint32_t>(static_cast<int64_t>((double)f * NCO_PHASE_SCALE));
+}
+
+static inline float GetNCOPhaseRadians(const uint32_t phase) {
+    constexpr double PI = 3.14159265358979323846;
+    return (float)((double)phase * (2.0*PI/NCO_PHASE_SCALE));
+}
+
+// Quarter wave sine table indexed by a 32bit phase
+// The top 2 bits select the quadrant, the next Q bits the table entry and the rest interpolate between entries
+//
+// The spurious free dynamic range is set by the worst case amplitude error of the table
+// P = Q+2 bits of phase resolve one full cycle, where dt = 2pi/2^P
+// - Truncated phase has an error of up to dt
+// - Linear interpolation has an error of up to dt^2/8
+class NCO_Table
+{
+private:
+    // NOTE: The table is capped at 64k entries so very high truncated SFDRs aren't reached
+    static constexpr int MIN_BITS = 2;
+    static constexpr int MAX_BITS = 16;
+    const bool is_interpolated;
+    int Q;
+    int frac_bits;
+    uint32_t frac_mask;
+    float frac_scale;
+    // sin(x) for x = [0,pi/2] with an extra entry so interpolation can read past the end
+    AlignedVector<float> table;
+public:
+    // sfdr = minimum spurious free dynamic range in dB
+    // is_interpolated = linearly interpolate between table entries for a much smaller table
+    NCO_Table(const float sfdr=90.0f, const bool _is_interpolated=true)
+    : is_interpolated(_is_interpolated)
+    {
+        Q = MIN_BITS;
+        while ((Q < MAX_BITS) && (GetSFDR(Q, is_interpolated) < sfdr)) {
+            Q++;
+        }
+        frac_bits = 30-Q;
+        frac_mask = (1u << frac_bits) - 1u;
+        frac_scale = 1.0f/(float)(1u << frac_bits);
+
+        constexpr double PI = 3.14159265358979323846;
+        const int N = 1 << Q;
+        table = AlignedVector<float>(N+2);
+        for (int i = 0; i < (N+2); i++) {
+            table[i] = (float)std::sin(PI/2.0 * (double)i/(double)N);
+        }
+    }
+
+    float sin(const uint32_t phase) const {
+        const uint32_t quadrant = phase >> 30;
+        uint32_t x = phase & 0x3FFFFFFFu;
+        // second half of each half cycle reads the table backwards
+        if (quadrant & 0b01) {
+            x = 0x40000000u - x;
+        }
+        const auto* T = table.data();
+        const uint32_t i = x >> frac_bits;
+        float y = T[i];
+        if (is_interpolated) {
+            const float frac = (float)(x & frac_mask) * frac_scale;
+            y = y + frac*(T[i+1]-T[i]);
+        }
+        return (quadrant & 0b10) ? -y : y;
+    }
+
+    float cos(const uint32_t phase) const {
+        return sin(phase + 0x40000000u);
+    }
+
+    // e^jt
+    std::complex<float> cis(const uint32_t phase) const {
+        return std::complex<float>(cos(phase), sin(phase));
+    }
+
+    int GetTableBits() const { return Q; }
+    int GetTableSize() const { return (int)table.size(); }
+    bool IsInterpolated() const { return is_interpolated; }
+    float GetSFDR() const { return GetSFDR(Q, is_interpolated); }
+private:
+    static float GetSFDR(const int Q, const bool is_interpolated) {
+        constexpr double PI = 3.14159265358979323846;
+        const double dt = 2.0*PI/(double)(1 << (Q+2));
+        const double error = is_interpolated ? (dt*dt/8.0) : dt;
+        return (float)(-20.0*std::log10(error));
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <complex>
+#include <cmath>
+#include <assert.h>
+#include "calculate_fft.h"
+#include "filter_designer.h"
+#include "utility/aligned_vector.h"
+#include "utility/span.h"
+
+// Polyphase filterbank which splits a wideband signal into M evenly spaced channels
+// Channel c is centred at c*Fs/M, where channels c >= M/2 are the negative frequencies
+// Each output frame costs one M*K tap filter and an M point FFT for all channels
+// instead of a mixer and decimating filter per channel
+//
+// y_c[m] = sum_r h[r] x[t-r] e^(-j2pi.c.(t-r)/M), where t = m*D + (D-1)
+//        = IFFT(v)[c], where v is the filtered input folded into M phases
+//
+// D = decimation factor which must divide M
+// - D = M gives a critically sampled filterbank
+// - D = M/2 gives a 2x oversampled filterbank so signals near the channel edges don't alias
+class PFB_Channeliser
+{
+private:
+    const int M;
+    const int D;
+    const int K;
+    const int L;
+    // prototype lowpass filter in reverse order so it lines up with ascending input
+    AlignedVector<float> b;
+    // input history of L-1 samples followed by the current block
+    AlignedVector<std::complex<float>> xn;
+    AlignedVector<std::complex<float>> v;
+    AlignedVector<std::complex<float>> y_fft;
+    const FFT_Plan fft_plan;
+    const int max_input_size;
+    // position of the last input sample of the next frame within a cycle of M samples
+    int frame_phase;
+public:
+    // M = total channels
+    // D = decimation factor of each channel
+    // K = number of coefficients per phase so the prototype filter has M*K taps
+    // k = cutoff of the prototype filter as Fc/(Fs/2) of the wideband signal
+    //     e.g. k = 1/M for channels that just touch each other
+    // max_output_size = maximum number of output samples per channel per block
+    PFB_Channeliser(const int _M, const int _D, const int _K, const float k, const int max_output_size)
+    : M(_M), D(_D), K(_K), L(_M*_K),
+      b(_M*_K),
+      xn(_M*_K-1 + _D*max_output_size),
+      v(_M), y_fft(_M), fft_plan(_M),
+      max_input_size(_D*max_output_size)
+    {
+        assert((M & (M-1)) == 0);
+        assert(M % D == 0);
+        create_fir_lpf(b.data(), L, k);
+        for (auto& x: xn) {
+            x = 0.0f;
+        }
+        frame_phase = D-1;
+    }
+
+    // x = input of length D*N
+    // y = list of M output buffers of length N, where y[c] = NULL skips channel c
+    void process(const std::complex<float>* x, std::complex<float>* const* y, const int N) {
+        const int N_in = N*D;
+        assert(N_in <= max_input_size);
+
+        const int L_history = L-1;
+        for (int i = 0; i < N_in; i++) {
+            xn[L_history + i] = x[i];
+        }
+
+        for (int m = 0; m < N; m++) {
+            // x[t-L+1 ... t]
+            const auto* xw = &xn[m*D + (D-1)];
+
+            // fold the filtered window into M phases
+            // v[j] = sum_q b[q*M+j]*x[t-L+1+q*M+j]
+            for (int j = 0; j < M; j++) {
+                v[j] = 0.0f;
+            }
+            for (int q = 0; q < K; q++) {
+                const auto* b0 = &b[q*M];
+                const auto* x0 = &xw[q*M];
+                for (int j = 0; j < M; j++) {
+                    v[j] += x0[j] * b0[j];
+                }
+            }
+
+            // v[j] holds the taps r where r mod M = p = M-1-j
+            // The IFFT input is rotated by the position of t so each channel is referenced to absolute time
+            // w[(p-t) mod M] = v[j]
+            for (int j = 0; j < M; j++) {
+                const int p = M-1-j;
+                const int i = (p - frame_phase + M) & (M-1);
+                y_fft[i] = v[j];
+            }
+            fft_plan.Inverse(y_fft.data(), y_fft.data());
+
+            for (int c = 0; c < M; c++) {
+                if (y[c] != NULL) {
+                    y[c][m] = y_fft[c];
+                }
+            }
+
+            frame_phase = (frame_phase + D) & (M-1);
+        }
+
+        // keep the end of the block as history
+        for (int i = 0; i < L_history; i++) {
+            xn[i] = xn[N_in + i];
+        }
+    }
+
+    int GetTotalChannels() const { return M; }
+    int GetDecimationFactor() const { return D; }
+    // Centre frequency of channel c as a fraction of the sampling rate [-0.5,0.5)
+    float GetChannelFrequency(const int c) const {
+        const int i = (c < M/2) ? c : (c-M);
+        return (float)i / (float)M;
+    }
+    // Index of the channel centred at f as a fraction of the sampling rate, or -1 if it isn't on the grid
+    int GetChannelIndex(const float f) const {
+        const float i = f*(float)M;
+        const int c = (int)std::round(i);
+        if (std::abs(i - (float)c) > 1e-3f) {
+            return -1;
+        }
+        if ((c < -M/2) || (c >= M/2)) {
+            return -1;
+        }
+        return (c + M) & (M-1);
+    }
+};
@@ -4,7 +4,10 @@
 #define _min(A,B) (A > B) ? B : A
 #define _max(A,B) (A > B) ? A : B
 
-template <typename T>
+// T = output type
+// U = input type, which can differ if apply_filter performs the conversion
+//     E.g. raw 8bit IQ samples are filtered straight into complex floats
+template <typename T, typename U = T>
 class PolyphaseDownsampler
 {
 private:
@@ -12,7 +15,7 @@ private:
     const int K;
     const int NN;
     AlignedVector<float> b;
-    AlignedVector<T> xn;
+    AlignedVector<U> xn;
 public:
     float* get_b() const { return b.data(); }
     int    get_K() const { return NN; }
@@ -20,13 +23,14 @@ public:
     // b = FIR filter with M*K coefficients
     // M = downsampling factor and total phases 
     // K = total coefficients per phase
-    PolyphaseDownsampler(const int _M, const int _K) 
+    // x0 = initial value of the input history, which should be the input's zero level
+    PolyphaseDownsampler(const int _M, const int _K, const U x0 = U(0)) 
     : M(_M), K(_K), NN(_M*_K),
       b(NN), xn(NN)
      {
         for (int i = 0; i < NN; i++) {
             b[i] = 0;
-            xn[i] = 0;
+            xn[i] = x0;
         }
     }
 
@@ -37,7 +41,7 @@ public:
     //       b5 b4 b3 b2 b1 b0    => ...
     //          b5 b4 b3 b2 b1 b0 => y1
     // N = produce N output samples
-    void process(const T* x, T* y, const int N) {
+    void process(const U* x, T* y, const int N) {
         const int M0 = _min(K-1, N);
 
         // NOTE: When downsampling we don't expect x and y to be the same buffer
@@ -63,7 +67,7 @@ public:
     }
 
 private:
-    void push_values(const T* x, const int N) {
+    void push_values(const U* x, const int N) {
         const int M = NN-N;
         for (int i = 0; i < M; i++) {
             xn[i] = xn[i+N];
@@ -73,7 +77,7 @@ private:
         }
     }
 
-    T apply_filter(const T* x) {
+    T apply_filter(const U* x) {
         T y;
         y = 0;
         for (int i = 0; i < NN; i++) {
@@ -182,11 +186,20 @@ private:
 #undef _max
 
 #include "simd/f32_cum_mul.h"
-float PolyphaseDownsampler<float>::apply_filter(const float* x) {
+template <>
+inline float PolyphaseDownsampler<float>::apply_filter(const float* x) {
     return f32_cum_mul_auto(x, b.data(), NN);
 }
 
 #include "simd/c32_f32_cum_mul.h"
-std::complex<float> PolyphaseDownsampler<std::complex<float>>::apply_filter(const std::complex<float>* x) {
+template <>
+inline std::complex<float> PolyphaseDownsampler<std::complex<float>>::apply_filter(const std::complex<float>* x) {
     return c32_f32_cum_mul_auto(x, b.data(), NN);
+}
+
+// Fuse the conversion of raw 8bit IQ samples to floats with the filter
+#include "simd/c8_f32_cum_mul.h"
+template <>
+inline std::complex<float> PolyphaseDownsampler<std::complex<float>, std::complex<uint8_t>>::apply_filter(const std::complex<uint8_t>* x) {
+    return c8_f32_cum_mul_auto(x, b.data(), NN);
 }
\ No newline at end of file
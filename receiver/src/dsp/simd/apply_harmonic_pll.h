@@ -3,7 +3,8 @@
 #include <assert.h>
 #include <complex>
 
-// NOTE: Assumes arrays are aligned
+// NOTE: Assumes the time vector is aligned
+//       The input and output can start at any sample within a block
 // Multiple a reference signal element-wise with a vector of complex floats
 // The reference signal is given as:
 // - Vector of floats representing time
@@ -69,7 +70,7 @@ void apply_harmonic_pll_ssse3(
 
     for (int i = 0; i < M; i++) {
         // [c0 c1]
-        __m128 b0 = _mm_load_ps(reinterpret_cast<const float*>(&x[i*K]));
+        __m128 b0 = _mm_loadu_ps(reinterpret_cast<const float*>(&x[i*K]));
 
         // [t0 t0 t1 t1]
         cpx128_t dt_vec; 
@@ -85,7 +86,7 @@ void apply_harmonic_pll_ssse3(
 
         __m128 b1 = _mm_cos_ps(dt_vec.ps);
         __m128 res = c32_mul_ssse3(b0, b1);
-        _mm_store_ps(reinterpret_cast<float*>(&y[i*K]), res);
+        _mm_storeu_ps(reinterpret_cast<float*>(&y[i*K]), res);
     }
 
     const int N_vector = M*K;
@@ -122,7 +123,7 @@ void apply_harmonic_pll_avx2(
 
     for (int i = 0; i < M; i++) {
         // [c0 c1 c2 c3]
-        __m256 b0 = _mm256_load_ps(reinterpret_cast<const float*>(&x[i*K]));
+        __m256 b0 = _mm256_loadu_ps(reinterpret_cast<const float*>(&x[i*K]));
 
         // [t0 t1 t2 t3]
         __m128 dt_sub_vec = _mm_load_ps(&dt[i*K]);
@@ -138,7 +139,7 @@ void apply_harmonic_pll_avx2(
 
         __m256 b1 = _mm256_cos_ps(dt_vec.ps);
         __m256 res = c32_mul_avx2(b0, b1);
-        _mm256_store_ps(reinterpret_cast<float*>(&y[i*K]), res);
+        _mm256_storeu_ps(reinterpret_cast<float*>(&y[i*K]), res);
     }
 
     const int N_vector = M*K;
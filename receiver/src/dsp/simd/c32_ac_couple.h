@@ -0,0 +1,168 @@
+#pragma once
+#include <assert.h>
+#include <complex>
+
+// First order ac coupling filter on complex floats
+// y[n] = x[n] - x[n-1] + k*y[n-1]
+// x_prev and y_prev hold the last input and output between calls
+// NOTE: Unaligned loads are used so this can be run over any window of a buffer
+
+// The SIMD kernels break the loop carried dependency with a look-ahead formulation
+// For a vector of K samples starting at n, where d[n] = x[n] - x[n-1]
+// y[n+j] = sum_{m=0}^{j} k^(j-m)*d[n+m] + k^(j+1)*y[n-1]
+// The sum is a prefix scan across the lanes which takes log2(K) shift and multiply-add steps
+// So only the final multiply-add with y[n-1] is carried between vectors
+
+static inline
+void c32_ac_couple_scalar(
+    const std::complex<float>* x, std::complex<float>* y, const int N, const float k,
+    std::complex<float>& x_prev, std::complex<float>& y_prev)
+{
+    auto xn = x_prev;
+    auto yn = y_prev;
+    for (int i = 0; i < N; i++) {
+        yn = x[i] - xn + k*yn;
+        xn = x[i];
+        y[i] = yn;
+    }
+    x_prev = xn;
+    y_prev = yn;
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+#include "data_packing.h"
+
+#if defined(_DSP_SSSE3)
+static inline
+void c32_ac_couple_ssse3(
+    const std::complex<float>* x, std::complex<float>* y, const int N, const float k,
+    std::complex<float>& x_prev, std::complex<float>& y_prev)
+{
+    // 128bits = 16bytes = 2*8bytes
+    constexpr int K = 2;
+    const int M = N/K;
+
+    const __m128 v_zero = _mm_set1_ps(0.0f);
+    const __m128 v_k = _mm_set1_ps(k);
+    // decay of the previous output on each lane
+    const __m128 v_k_pow = _mm_set_ps(k*k, k*k, k, k);
+
+    // [c c] where c is the last sample
+    __m128 v_x_prev = _mm_castpd_ps(_mm_load1_pd(reinterpret_cast<const double*>(&x_prev)));
+    __m128 v_y_prev = _mm_castpd_ps(_mm_load1_pd(reinterpret_cast<const double*>(&y_prev)));
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1]
+        __m128 a0 = _mm_loadu_ps(reinterpret_cast<const float*>(&x[i*K]));
+        // [x_prev c0]
+        __m128 a_shift = _mm_movelh_ps(v_x_prev, a0);
+        __m128 d = _mm_sub_ps(a0, a_shift);
+        // [0 d0]
+        __m128 t = _mm_movelh_ps(v_zero, d);
+        #if !defined(_DSP_FMA)
+        d = _mm_add_ps(_mm_mul_ps(v_k, t), d);
+        __m128 b0 = _mm_add_ps(_mm_mul_ps(v_k_pow, v_y_prev), d);
+        #else
+        d = _mm_fmadd_ps(v_k, t, d);
+        __m128 b0 = _mm_fmadd_ps(v_k_pow, v_y_prev, d);
+        #endif
+        _mm_storeu_ps(reinterpret_cast<float*>(&y[i*K]), b0);
+        // [c1 c1]
+        v_x_prev = _mm_movehl_ps(a0, a0);
+        v_y_prev = _mm_movehl_ps(b0, b0);
+    }
+
+    cpx128_t v_x, v_y;
+    v_x.ps = v_x_prev;
+    v_y.ps = v_y_prev;
+    x_prev = v_x.c32[0];
+    y_prev = v_y.c32[0];
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    c32_ac_couple_scalar(&x[N_vector], &y[N_vector], N_remain, k, x_prev, y_prev);
+}
+#endif
+
+#if defined(_DSP_AVX2)
+static inline
+void c32_ac_couple_avx2(
+    const std::complex<float>* x, std::complex<float>* y, const int N, const float k,
+    std::complex<float>& x_prev, std::complex<float>& y_prev)
+{
+    // 256bits = 32bytes = 4*8bytes
+    constexpr int K = 4;
+    const int M = N/K;
+
+    const float k2 = k*k;
+    const float k3 = k2*k;
+    const float k4 = k3*k;
+    const __m256 v_zero = _mm256_set1_ps(0.0f);
+    const __m256 v_k = _mm256_set1_ps(k);
+    const __m256 v_k2 = _mm256_set1_ps(k2);
+    // decay of the previous output on each lane
+    const __m256 v_k_pow = _mm256_set_ps(k4, k4, k3, k3, k2, k2, k, k);
+    // [c0 c1 c2 c3] -> [c0 c0 c1 c2]
+    const __m256i SHIFT_ONE = _mm256_set_epi32(5,4,3,2,1,0,1,0);
+    // [c0 c1 c2 c3] -> [c3 c3 c3 c3]
+    const __m256i BROADCAST_LAST = _mm256_set_epi32(7,6,7,6,7,6,7,6);
+    // replace the first complex lane
+    constexpr int BLEND_FIRST = 0b00000011;
+    // [a0 a1] -> [0 a0] across the 128bit lanes
+    constexpr int SHIFT_TWO = 0x08;
+
+    // [c c c c] where c is the last sample
+    __m256 v_x_prev = _mm256_castpd_ps(_mm256_broadcast_sd(reinterpret_cast<const double*>(&x_prev)));
+    __m256 v_y_prev = _mm256_castpd_ps(_mm256_broadcast_sd(reinterpret_cast<const double*>(&y_prev)));
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1 c2 c3]
+        __m256 a0 = _mm256_loadu_ps(reinterpret_cast<const float*>(&x[i*K]));
+        // [x_prev c0 c1 c2]
+        __m256 a_shift = _mm256_blend_ps(_mm256_permutevar8x32_ps(a0, SHIFT_ONE), v_x_prev, BLEND_FIRST);
+        __m256 d = _mm256_sub_ps(a0, a_shift);
+        // [0 d0 d1 d2] then [0 0 d0 d1]
+        __m256 t0 = _mm256_blend_ps(_mm256_permutevar8x32_ps(d, SHIFT_ONE), v_zero, BLEND_FIRST);
+        #if !defined(_DSP_FMA)
+        d = _mm256_add_ps(_mm256_mul_ps(v_k, t0), d);
+        __m256 t1 = _mm256_permute2f128_ps(d, d, SHIFT_TWO);
+        d = _mm256_add_ps(_mm256_mul_ps(v_k2, t1), d);
+        __m256 b0 = _mm256_add_ps(_mm256_mul_ps(v_k_pow, v_y_prev), d);
+        #else
+        d = _mm256_fmadd_ps(v_k, t0, d);
+        __m256 t1 = _mm256_permute2f128_ps(d, d, SHIFT_TWO);
+        d = _mm256_fmadd_ps(v_k2, t1, d);
+        __m256 b0 = _mm256_fmadd_ps(v_k_pow, v_y_prev, d);
+        #endif
+        _mm256_storeu_ps(reinterpret_cast<float*>(&y[i*K]), b0);
+        v_x_prev = _mm256_permutevar8x32_ps(a0, BROADCAST_LAST);
+        v_y_prev = _mm256_permutevar8x32_ps(b0, BROADCAST_LAST);
+    }
+
+    cpx256_t v_x, v_y;
+    v_x.ps = v_x_prev;
+    v_y.ps = v_y_prev;
+    x_prev = v_x.c32[0];
+    y_prev = v_y.c32[0];
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    c32_ac_couple_scalar(&x[N_vector], &y[N_vector], N_remain, k, x_prev, y_prev);
+}
+#endif
+
+inline static
+void c32_ac_couple_auto(
+    const std::complex<float>* x, std::complex<float>* y, const int N, const float k,
+    std::complex<float>& x_prev, std::complex<float>& y_prev)
+{
+    #if defined(_DSP_AVX2)
+    c32_ac_couple_avx2(x, y, N, k, x_prev, y_prev);
+    #elif defined(_DSP_SSSE3)
+    c32_ac_couple_ssse3(x, y, N, k, x_prev, y_prev);
+    #else
+    c32_ac_couple_scalar(x, y, N, k, x_prev, y_prev);
+    #endif
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <assert.h>
+#include <complex>
+
+// Correlate two vectors of complex floats, i.e. sum(x0 * conj(x1))
+// NOTE: Unaligned loads are used so x0 can be a sliding window
+// We accumulate x0*Re{x1} and x0*Im{x1} separately and combine them at the end
+// This avoids the component swap of a full complex multiply in the inner loop
+// sum(x0*conj(x1)) = (sum(I0*I1) + sum(Q0*Q1)) + j(sum(Q0*I1) - sum(I0*Q1))
+
+static inline
+std::complex<float> c32_conj_cum_mul_scalar(const std::complex<float>* x0, const std::complex<float>* x1, const int N) {
+    auto y = std::complex<float>(0,0);
+    for (int i = 0; i < N; i++) {
+        y += x0[i] * std::conj(x1[i]);
+    }
+    return y;
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+#include "data_packing.h"
+#include "c32_cum_sum.h"
+
+static inline
+std::complex<float> c32_conj_cum_mul_combine(const std::complex<float> sum_real, const std::complex<float> sum_imag) {
+    return std::complex<float>(
+        sum_real.real() + sum_imag.imag(),
+        sum_real.imag() - sum_imag.real());
+}
+
+#if defined(_DSP_SSSE3)
+static inline
+std::complex<float> c32_conj_cum_mul_ssse3(const std::complex<float>* x0, const std::complex<float>* x1, const int N)
+{
+    // 128bits = 16bytes = 2*8bytes
+    constexpr int K = 2;
+    const int M = N/K;
+
+    // [I0*I1 Q0*I1] and [I0*Q1 Q0*Q1]
+    cpx128_t v_real, v_imag;
+    v_real.ps = _mm_set1_ps(0.0f);
+    v_imag.ps = _mm_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1]
+        __m128 a0 = _mm_loadu_ps(reinterpret_cast<const float*>(&x0[i*K]));
+        __m128 b0 = _mm_loadu_ps(reinterpret_cast<const float*>(&x1[i*K]));
+        // [I1 I1] and [Q1 Q1]
+        __m128 b_real = _mm_moveldup_ps(b0);
+        __m128 b_imag = _mm_movehdup_ps(b0);
+        #if !defined(_DSP_FMA)
+        v_real.ps = _mm_add_ps(_mm_mul_ps(a0, b_real), v_real.ps);
+        v_imag.ps = _mm_add_ps(_mm_mul_ps(a0, b_imag), v_imag.ps);
+        #else
+        v_real.ps = _mm_fmadd_ps(a0, b_real, v_real.ps);
+        v_imag.ps = _mm_fmadd_ps(a0, b_imag, v_imag.ps);
+        #endif
+    }
+
+    auto y = c32_conj_cum_mul_combine(c32_cum_sum_ssse3(v_real), c32_cum_sum_ssse3(v_imag));
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    y += c32_conj_cum_mul_scalar(&x0[N_vector], &x1[N_vector], N_remain);
+    return y;
+}
+#endif
+
+#if defined(_DSP_AVX2)
+static inline
+std::complex<float> c32_conj_cum_mul_avx2(const std::complex<float>* x0, const std::complex<float>* x1, const int N)
+{
+    // 256bits = 32bytes = 4*8bytes
+    constexpr int K = 4;
+    const int M = N/K;
+
+    cpx256_t v_real, v_imag;
+    v_real.ps = _mm256_set1_ps(0.0f);
+    v_imag.ps = _mm256_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1 c2 c3]
+        __m256 a0 = _mm256_loadu_ps(reinterpret_cast<const float*>(&x0[i*K]));
+        __m256 b0 = _mm256_loadu_ps(reinterpret_cast<const float*>(&x1[i*K]));
+        // [I1 I1 ...] and [Q1 Q1 ...]
+        __m256 b_real = _mm256_moveldup_ps(b0);
+        __m256 b_imag = _mm256_movehdup_ps(b0);
+        #if !defined(_DSP_FMA)
+        v_real.ps = _mm256_add_ps(_mm256_mul_ps(a0, b_real), v_real.ps);
+        v_imag.ps = _mm256_add_ps(_mm256_mul_ps(a0, b_imag), v_imag.ps);
+        #else
+        v_real.ps = _mm256_fmadd_ps(a0, b_real, v_real.ps);
+        v_imag.ps = _mm256_fmadd_ps(a0, b_imag, v_imag.ps);
+        #endif
+    }
+
+    auto y = c32_conj_cum_mul_combine(c32_cum_sum_avx2(v_real), c32_cum_sum_avx2(v_imag));
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    y += c32_conj_cum_mul_scalar(&x0[N_vector], &x1[N_vector], N_remain);
+    return y;
+}
+#endif
+
+inline static
+std::complex<float> c32_conj_cum_mul_auto(const std::complex<float>* x0, const std::complex<float>* x1, const int N) {
+    #if defined(_DSP_AVX2)
+    return c32_conj_cum_mul_avx2(x0, x1, N);
+    #elif defined(_DSP_SSSE3)
+    return c32_conj_cum_mul_ssse3(x0, x1, N);
+    #else
+    return c32_conj_cum_mul_scalar(x0, x1, N);
+    #endif
+}
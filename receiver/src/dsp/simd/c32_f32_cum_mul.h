@@ -2,7 +2,8 @@
 #include <assert.h>
 #include <complex>
 
-// NOTE: Assumes arrays are aligned
+// NOTE: Assumes the coefficients x1 are aligned
+//       The input x0 is unaligned since filters slide across it one sample at a time
 // Multiply and accumulate vector of complex floats with vector of floats
 
 static inline
@@ -40,9 +41,9 @@ std::complex<float> c32_f32_cum_mul_ssse3(const std::complex<float>* x0, const f
 
     for (int i = 0; i < M; i++) {
         // [c0 c1]
-        __m128 a0 = _mm_load_ps(reinterpret_cast<const float*>(&x0[i*K]));
+        __m128 a0 = _mm_loadu_ps(reinterpret_cast<const float*>(&x0[i*K]));
         // [c2 c3]
-        __m128 a1 = _mm_load_ps(reinterpret_cast<const float*>(&x0[i*K + K/2]));
+        __m128 a1 = _mm_loadu_ps(reinterpret_cast<const float*>(&x0[i*K + K/2]));
 
         // [a0 a1 a2 a3]
         __m128 b0 = _mm_load_ps(&x1[i*K]);
@@ -91,7 +92,7 @@ std::complex<float> c32_f32_cum_mul_avx2(const std::complex<float>* x0, const fl
 
     for (int i = 0; i < M; i++) {
         // [c0 c1 c2 c3]
-        __m256 a0 = _mm256_load_ps(reinterpret_cast<const float*>(&x0[i*K]));
+        __m256 a0 = _mm256_loadu_ps(reinterpret_cast<const float*>(&x0[i*K]));
 
         // [a0 a1 a2 a3]
         __m128 b0 = _mm_load_ps(&x1[i*K]);
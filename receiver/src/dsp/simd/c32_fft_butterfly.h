@@ -0,0 +1,261 @@
+#pragma once
+
+#include <immintrin.h>
+#include <complex>
+#include "simd_config.h"
+#include "c32_mul.h"
+
+// Butterfly stages of an iterative decimation in time FFT
+// The input to the first stage is in bit reversed order
+// x = N samples which are transformed in place
+// h = quarter (radix-4) or half (radix-2) the size of each butterfly group
+//
+// Radix-2 stage over groups of 2h, where w[k] = W_2h^k
+// y[k]   = x[k] + w[k]*x[k+h]
+// y[k+h] = x[k] - w[k]*x[k+h]
+//
+// Radix-4 stage is two radix-2 stages fused over groups of 4h, where w1[k] = W_2h^k and w2[k] = W_4h^k
+// b0 = x[k]    + w1*x[k+h]
+// b1 = x[k]    - w1*x[k+h]
+// b2 = x[k+2h] + w1*x[k+3h]
+// b3 = x[k+2h] - w1*x[k+3h]
+// y[k]    = b0 + w2*b2
+// y[k+2h] = b0 - w2*b2
+// y[k+h]  = b1 + (-j)*w2*b3
+// y[k+3h] = b1 - (-j)*w2*b3
+// For the inverse transform the twiddles are conjugated and -j becomes +j
+
+static inline
+void c32_fft_radix2_scalar(std::complex<float>* x, const std::complex<float>* w, const int h, const int N) {
+    for (int i = 0; i < N; i += 2*h) {
+        auto* x0 = &x[i];
+        auto* x1 = &x[i+h];
+        for (int k = 0; k < h; k++) {
+            const auto a = x0[k];
+            const auto b = x1[k] * w[k];
+            x0[k] = a + b;
+            x1[k] = a - b;
+        }
+    }
+}
+
+static inline
+void c32_fft_radix4_scalar(std::complex<float>* x, const std::complex<float>* w1, const std::complex<float>* w2, const int h, const int N, const bool is_inverse) {
+    const auto j = std::complex<float>(0.0f, is_inverse ? 1.0f : -1.0f);
+    for (int i = 0; i < N; i += 4*h) {
+        auto* x0 = &x[i];
+        auto* x1 = &x[i+h];
+        auto* x2 = &x[i+2*h];
+        auto* x3 = &x[i+3*h];
+        for (int k = 0; k < h; k++) {
+            const auto t1 = x1[k] * w1[k];
+            const auto t3 = x3[k] * w1[k];
+            const auto b0 = x0[k] + t1;
+            const auto b1 = x0[k] - t1;
+            const auto b2 = x2[k] + t3;
+            const auto b3 = x2[k] - t3;
+            const auto u2 = b2 * w2[k];
+            const auto u3 = b3 * w2[k] * j;
+            x0[k] = b0 + u2;
+            x2[k] = b0 - u2;
+            x1[k] = b1 + u3;
+            x3[k] = b1 - u3;
+        }
+    }
+}
+
+#if defined(_DSP_SSSE3)
+// Multiply packed complex floats by -j or +j
+static inline
+__m128 c32_mul_j_ssse3(__m128 x, const bool is_inverse) {
+    // [3 2 1 0] -> [2 3 0 1]
+    constexpr uint8_t SWAP_COMPONENT_MASK = 0b10110001;
+    // NOTE: Sign bits are set as integers since -ffast-math can fold -0.0f into 0.0f
+    constexpr int S = (int)0x80000000;
+    const __m128 sign = _mm_castsi128_ps(is_inverse ?
+        _mm_set_epi32(0, S, 0, S) :
+        _mm_set_epi32(S, 0, S, 0));
+    // -j*(a+jb) = b-ja, +j*(a+jb) = -b+ja
+    return _mm_xor_ps(_mm_shuffle_ps(x, x, SWAP_COMPONENT_MASK), sign);
+}
+
+// h must be a multiple of 2
+static inline
+void c32_fft_radix2_ssse3(std::complex<float>* x, const std::complex<float>* w, const int h, const int N) {
+    auto* X = reinterpret_cast<float*>(x);
+    auto* W = reinterpret_cast<const float*>(w);
+    for (int i = 0; i < N; i += 2*h) {
+        for (int k = 0; k < h; k += 2) {
+            float* x0 = &X[2*(i+k)];
+            float* x1 = &X[2*(i+k+h)];
+            const __m128 a = _mm_loadu_ps(x0);
+            const __m128 b = c32_mul_ssse3(_mm_loadu_ps(x1), _mm_loadu_ps(&W[2*k]));
+            _mm_storeu_ps(x0, _mm_add_ps(a, b));
+            _mm_storeu_ps(x1, _mm_sub_ps(a, b));
+        }
+    }
+}
+
+// h must be a multiple of 2
+static inline
+void c32_fft_radix4_ssse3(std::complex<float>* x, const std::complex<float>* w1, const std::complex<float>* w2, const int h, const int N, const bool is_inverse) {
+    auto* X = reinterpret_cast<float*>(x);
+    auto* W1 = reinterpret_cast<const float*>(w1);
+    auto* W2 = reinterpret_cast<const float*>(w2);
+    for (int i = 0; i < N; i += 4*h) {
+        for (int k = 0; k < h; k += 2) {
+            float* x0 = &X[2*(i+k)];
+            float* x1 = &X[2*(i+k+h)];
+            float* x2 = &X[2*(i+k+2*h)];
+            float* x3 = &X[2*(i+k+3*h)];
+            const __m128 v1 = _mm_loadu_ps(&W1[2*k]);
+            const __m128 v2 = _mm_loadu_ps(&W2[2*k]);
+            const __m128 a0 = _mm_loadu_ps(x0);
+            const __m128 a2 = _mm_loadu_ps(x2);
+            const __m128 t1 = c32_mul_ssse3(_mm_loadu_ps(x1), v1);
+            const __m128 t3 = c32_mul_ssse3(_mm_loadu_ps(x3), v1);
+            const __m128 b0 = _mm_add_ps(a0, t1);
+            const __m128 b1 = _mm_sub_ps(a0, t1);
+            const __m128 b2 = _mm_add_ps(a2, t3);
+            const __m128 b3 = _mm_sub_ps(a2, t3);
+            const __m128 u2 = c32_mul_ssse3(b2, v2);
+            const __m128 u3 = c32_mul_j_ssse3(c32_mul_ssse3(b3, v2), is_inverse);
+            _mm_storeu_ps(x0, _mm_add_ps(b0, u2));
+            _mm_storeu_ps(x2, _mm_sub_ps(b0, u2));
+            _mm_storeu_ps(x1, _mm_add_ps(b1, u3));
+            _mm_storeu_ps(x3, _mm_sub_ps(b1, u3));
+        }
+    }
+}
+#endif
+
+#if defined(_DSP_AVX2)
+// Multiply packed complex floats by -j or +j
+static inline
+__m256 c32_mul_j_avx2(__m256 x, const bool is_inverse) {
+    // [3 2 1 0] -> [2 3 0 1]
+    constexpr uint8_t SWAP_COMPONENT_MASK = 0b10110001;
+    // NOTE: Sign bits are set as integers since -ffast-math can fold -0.0f into 0.0f
+    constexpr int S = (int)0x80000000;
+    const __m256 sign = _mm256_castsi256_ps(is_inverse ?
+        _mm256_set_epi32(0, S, 0, S, 0, S, 0, S) :
+        _mm256_set_epi32(S, 0, S, 0, S, 0, S, 0));
+    // -j*(a+jb) = b-ja, +j*(a+jb) = -b+ja
+    return _mm256_xor_ps(_mm256_permute_ps(x, SWAP_COMPONENT_MASK), sign);
+}
+
+// h must be a multiple of 4
+static inline
+void c32_fft_radix2_avx2(std::complex<float>* x, const std::complex<float>* w, const int h, const int N) {
+    auto* X = reinterpret_cast<float*>(x);
+    auto* W = reinterpret_cast<const float*>(w);
+    for (int i = 0; i < N; i += 2*h) {
+        for (int k = 0; k < h; k += 4) {
+            float* x0 = &X[2*(i+k)];
+            float* x1 = &X[2*(i+k+h)];
+            const __m256 a = _mm256_loadu_ps(x0);
+            const __m256 b = c32_mul_avx2(_mm256_loadu_ps(x1), _mm256_loadu_ps(&W[2*k]));
+            _mm256_storeu_ps(x0, _mm256_add_ps(a, b));
+            _mm256_storeu_ps(x1, _mm256_sub_ps(a, b));
+        }
+    }
+}
+
+// First radix-4 stage where h = 1 and all twiddles are 1
+// Each register holds an entire group [x0 x1 | x2 x3]
+static inline
+void c32_fft_radix4_first_avx2(std::complex<float>* x, const int N, const bool is_inverse) {
+    // [3 2 1 0] -> [1 0 3 2]
+    constexpr uint8_t SWAP_PAIR_MASK = 0b01001110;
+    // Select [lo hi lo hi] from two registers
+    constexpr uint8_t BLEND_HIGH_PAIR_MASK = 0b11001100;
+    auto* X = reinterpret_cast<float*>(x);
+    for (int i = 0; i < N; i += 4) {
+        float* x0 = &X[2*i];
+        const __m256 a = _mm256_loadu_ps(x0);
+        // [x0 x1] -> [x0+x1 x0-x1] in each lane
+        const __m256 a_swap = _mm256_permute_ps(a, SWAP_PAIR_MASK);
+        const __m256 b = _mm256_blend_ps(
+            _mm256_add_ps(a, a_swap),
+            _mm256_sub_ps(a_swap, a),
+            BLEND_HIGH_PAIR_MASK);
+        // [b0 b1 | b0 b1] and [b2 b3 | b2 b3]
+        const __m256 lo = _mm256_permute2f128_ps(b, b, 0x00);
+        __m256 hi = _mm256_permute2f128_ps(b, b, 0x11);
+        // [b2 -j*b3]
+        hi = _mm256_blend_ps(hi, c32_mul_j_avx2(hi, is_inverse), BLEND_HIGH_PAIR_MASK);
+        // [b0+b2 b1-j*b3 | b0-b2 b1+j*b3]
+        const __m256 y = _mm256_permute2f128_ps(
+            _mm256_add_ps(lo, hi),
+            _mm256_sub_ps(lo, hi),
+            0x20);
+        _mm256_storeu_ps(x0, y);
+    }
+}
+
+// h must be a multiple of 4
+static inline
+void c32_fft_radix4_avx2(std::complex<float>* x, const std::complex<float>* w1, const std::complex<float>* w2, const int h, const int N, const bool is_inverse) {
+    auto* X = reinterpret_cast<float*>(x);
+    auto* W1 = reinterpret_cast<const float*>(w1);
+    auto* W2 = reinterpret_cast<const float*>(w2);
+    for (int i = 0; i < N; i += 4*h) {
+        for (int k = 0; k < h; k += 4) {
+            float* x0 = &X[2*(i+k)];
+            float* x1 = &X[2*(i+k+h)];
+            float* x2 = &X[2*(i+k+2*h)];
+            float* x3 = &X[2*(i+k+3*h)];
+            const __m256 v1 = _mm256_loadu_ps(&W1[2*k]);
+            const __m256 v2 = _mm256_loadu_ps(&W2[2*k]);
+            const __m256 a0 = _mm256_loadu_ps(x0);
+            const __m256 a2 = _mm256_loadu_ps(x2);
+            const __m256 t1 = c32_mul_avx2(_mm256_loadu_ps(x1), v1);
+            const __m256 t3 = c32_mul_avx2(_mm256_loadu_ps(x3), v1);
+            const __m256 b0 = _mm256_add_ps(a0, t1);
+            const __m256 b1 = _mm256_sub_ps(a0, t1);
+            const __m256 b2 = _mm256_add_ps(a2, t3);
+            const __m256 b3 = _mm256_sub_ps(a2, t3);
+            const __m256 u2 = c32_mul_avx2(b2, v2);
+            const __m256 u3 = c32_mul_j_avx2(c32_mul_avx2(b3, v2), is_inverse);
+            _mm256_storeu_ps(x0, _mm256_add_ps(b0, u2));
+            _mm256_storeu_ps(x2, _mm256_sub_ps(b0, u2));
+            _mm256_storeu_ps(x1, _mm256_add_ps(b1, u3));
+            _mm256_storeu_ps(x3, _mm256_sub_ps(b1, u3));
+        }
+    }
+}
+#endif
+
+// Pick the widest kernel that the group size allows
+static inline
+void c32_fft_radix2_auto(std::complex<float>* x, const std::complex<float>* w, const int h, const int N) {
+    #if defined(_DSP_AVX2)
+    if (h % 4 == 0) {
+        return c32_fft_radix2_avx2(x, w, h, N);
+    }
+    #endif
+    #if defined(_DSP_SSSE3)
+    if (h % 2 == 0) {
+        return c32_fft_radix2_ssse3(x, w, h, N);
+    }
+    #endif
+    return c32_fft_radix2_scalar(x, w, h, N);
+}
+
+static inline
+void c32_fft_radix4_auto(std::complex<float>* x, const std::complex<float>* w1, const std::complex<float>* w2, const int h, const int N, const bool is_inverse) {
+    #if defined(_DSP_AVX2)
+    if (h % 4 == 0) {
+        return c32_fft_radix4_avx2(x, w1, w2, h, N, is_inverse);
+    }
+    if (h == 1) {
+        return c32_fft_radix4_first_avx2(x, N, is_inverse);
+    }
+    #endif
+    #if defined(_DSP_SSSE3)
+    if (h % 2 == 0) {
+        return c32_fft_radix4_ssse3(x, w1, w2, h, N, is_inverse);
+    }
+    #endif
+    return c32_fft_radix4_scalar(x, w1, w2, h, N, is_inverse);
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <assert.h>
+#include <complex>
+
+// Apply a linearly interpolated gain to complex floats
+// y[i] = x[i] * (g0 + (i+1)*dg)
+// The gain is calculated from the index instead of being accumulated so it doesn't drift
+// NOTE: Unaligned loads are used so this can be run over any window of a buffer
+
+static inline
+void c32_gain_ramp_scalar(const std::complex<float>* x, std::complex<float>* y, const int N, const float g0, const float dg) {
+    for (int i = 0; i < N; i++) {
+        y[i] = x[i] * (g0 + (float)(i+1)*dg);
+    }
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+
+#if defined(_DSP_SSSE3)
+static inline
+void c32_gain_ramp_ssse3(const std::complex<float>* x, std::complex<float>* y, const int N, const float g0, const float dg)
+{
+    // 128bits = 16bytes = 2*8bytes
+    constexpr int K = 2;
+    const int M = N/K;
+
+    const __m128 v_g0 = _mm_set1_ps(g0);
+    const __m128 v_dg = _mm_set1_ps(dg);
+    const __m128 v_step = _mm_set1_ps((float)K);
+    // [1 1 2 2]
+    __m128 v_index = _mm_set_ps(2.0f, 2.0f, 1.0f, 1.0f);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1]
+        __m128 a0 = _mm_loadu_ps(reinterpret_cast<const float*>(&x[i*K]));
+        #if !defined(_DSP_FMA)
+        __m128 v_gain = _mm_add_ps(_mm_mul_ps(v_index, v_dg), v_g0);
+        #else
+        __m128 v_gain = _mm_fmadd_ps(v_index, v_dg, v_g0);
+        #endif
+        _mm_storeu_ps(reinterpret_cast<float*>(&y[i*K]), _mm_mul_ps(a0, v_gain));
+        v_index = _mm_add_ps(v_index, v_step);
+    }
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    c32_gain_ramp_scalar(&x[N_vector], &y[N_vector], N_remain, g0 + (float)N_vector*dg, dg);
+}
+#endif
+
+#if defined(_DSP_AVX2)
+static inline
+void c32_gain_ramp_avx2(const std::complex<float>* x, std::complex<float>* y, const int N, const float g0, const float dg)
+{
+    // 256bits = 32bytes = 4*8bytes
+    constexpr int K = 4;
+    const int M = N/K;
+
+    const __m256 v_g0 = _mm256_set1_ps(g0);
+    const __m256 v_dg = _mm256_set1_ps(dg);
+    const __m256 v_step = _mm256_set1_ps((float)K);
+    // [1 1 2 2 3 3 4 4]
+    __m256 v_index = _mm256_set_ps(4.0f, 4.0f, 3.0f, 3.0f, 2.0f, 2.0f, 1.0f, 1.0f);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1 c2 c3]
+        __m256 a0 = _mm256_loadu_ps(reinterpret_cast<const float*>(&x[i*K]));
+        #if !defined(_DSP_FMA)
+        __m256 v_gain = _mm256_add_ps(_mm256_mul_ps(v_index, v_dg), v_g0);
+        #else
+        __m256 v_gain = _mm256_fmadd_ps(v_index, v_dg, v_g0);
+        #endif
+        _mm256_storeu_ps(reinterpret_cast<float*>(&y[i*K]), _mm256_mul_ps(a0, v_gain));
+        v_index = _mm256_add_ps(v_index, v_step);
+    }
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    c32_gain_ramp_scalar(&x[N_vector], &y[N_vector], N_remain, g0 + (float)N_vector*dg, dg);
+}
+#endif
+
+inline static
+void c32_gain_ramp_auto(const std::complex<float>* x, std::complex<float>* y, const int N, const float g0, const float dg) {
+    #if defined(_DSP_AVX2)
+    c32_gain_ramp_avx2(x, y, N, g0, dg);
+    #elif defined(_DSP_SSSE3)
+    c32_gain_ramp_ssse3(x, y, N, g0, dg);
+    #else
+    c32_gain_ramp_scalar(x, y, N, g0, dg);
+    #endif
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <assert.h>
+#include <stdint.h>
+#include <complex>
+
+// Slice complex symbols to the nearest point on a square constellation
+// For a square constellation the nearest point can be found independently on each axis
+// Each axis has L levels which are equally spaced and centered at 0
+// - step_inv = 1/(distance between adjacent levels)
+// - index = clamp(round(x*step_inv + (L-1)/2), 0, L-1)
+// - y = lut[I_index*L + Q_index]
+// NOTE: The SIMD implementations use a 16 entry lookup table so L*L must be <= 16
+
+static inline
+void c32_slice_square_scalar(
+    const std::complex<float>* x, uint8_t* y, const int N,
+    const float step_inv, const int L, const uint8_t* lut)
+{
+    const float offset = (float)(L-1)/2.0f + 0.5f;
+    const float max_index = (float)(L-1);
+    for (int i = 0; i < N; i++) {
+        float I = x[i].real()*step_inv + offset;
+        float Q = x[i].imag()*step_inv + offset;
+        // truncation is the same as rounding since we added 0.5 and are clamped to positive values
+        I = (I < 0.0f) ? 0.0f : ((I > max_index) ? max_index : I);
+        Q = (Q < 0.0f) ? 0.0f : ((Q > max_index) ? max_index : Q);
+        const int index = (int)I*L + (int)Q;
+        y[i] = lut[index];
+    }
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+
+#if defined(_DSP_SSSE3)
+static inline
+void c32_slice_square_ssse3(
+    const std::complex<float>* x, uint8_t* y, const int N,
+    const float step_inv, const int L, const uint8_t* lut)
+{
+    // 8 symbols in 4x128bit registers
+    constexpr int K = 8;
+    const int M = (L*L <= 16) ? N/K : 0;
+
+    uint8_t lut_padded[16] = {0};
+    for (int i = 0; (i < L*L) && (i < 16); i++) {
+        lut_padded[i] = lut[i];
+    }
+    const __m128i lut_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut_padded));
+
+    const __m128 step_inv_vec = _mm_set1_ps(step_inv);
+    const __m128 offset_vec = _mm_set1_ps((float)(L-1)/2.0f + 0.5f);
+    const __m128 min_vec = _mm_set1_ps(0.0f);
+    const __m128 max_vec = _mm_set1_ps((float)(L-1));
+    // index = I*L + Q
+    const __m128 axis_weight = _mm_setr_ps((float)L, 1.0f, (float)L, 1.0f);
+
+    auto get_index = [&](const std::complex<float>* x0) {
+        // [I0 Q0 I1 Q1]
+        __m128 v = _mm_loadu_ps(reinterpret_cast<const float*>(x0));
+        v = _mm_add_ps(_mm_mul_ps(v, step_inv_vec), offset_vec);
+        v = _mm_min_ps(_mm_max_ps(v, min_vec), max_vec);
+        // truncate to integer level before weighting
+        v = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+        return _mm_mul_ps(v, axis_weight);
+    };
+
+    for (int i = 0; i < M; i++) {
+        const std::complex<float>* x0 = &x[i*K];
+        // [s0 s1 s2 s3]
+        __m128i a0 = _mm_cvttps_epi32(_mm_hadd_ps(get_index(&x0[0]), get_index(&x0[2])));
+        // [s4 s5 s6 s7]
+        __m128i a1 = _mm_cvttps_epi32(_mm_hadd_ps(get_index(&x0[4]), get_index(&x0[6])));
+        // [s0 ... s7] as 8bit indices
+        __m128i b0 = _mm_packs_epi32(a0, a1);
+        b0 = _mm_packus_epi16(b0, b0);
+        // gray code lookup
+        b0 = _mm_shuffle_epi8(lut_vec, b0);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&y[i*K]), b0);
+    }
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    c32_slice_square_scalar(&x[N_vector], &y[N_vector], N_remain, step_inv, L, lut);
+}
+#endif
+
+#if defined(_DSP_AVX2)
+static inline
+void c32_slice_square_avx2(
+    const std::complex<float>* x, uint8_t* y, const int N,
+    const float step_inv, const int L, const uint8_t* lut)
+{
+    // 8 symbols in 2x256bit registers
+    constexpr int K = 8;
+    const int M = (L*L <= 16) ? N/K : 0;
+
+    uint8_t lut_padded[16] = {0};
+    for (int i = 0; (i < L*L) && (i < 16); i++) {
+        lut_padded[i] = lut[i];
+    }
+    const __m128i lut_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lut_padded));
+
+    const __m256 step_inv_vec = _mm256_set1_ps(step_inv);
+    const __m256 offset_vec = _mm256_set1_ps((float)(L-1)/2.0f + 0.5f);
+    const __m256 min_vec = _mm256_set1_ps(0.0f);
+    const __m256 max_vec = _mm256_set1_ps((float)(L-1));
+    // index = I*L + Q
+    const __m256 axis_weight = _mm256_setr_ps(
+        (float)L, 1.0f, (float)L, 1.0f,
+        (float)L, 1.0f, (float)L, 1.0f);
+    // hadd interleaves the 128bit lanes so we undo that
+    const __m256i hadd_order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+
+    auto get_index = [&](const std::complex<float>* x0) {
+        // [I0 Q0 I1 Q1 I2 Q2 I3 Q3]
+        __m256 v = _mm256_loadu_ps(reinterpret_cast<const float*>(x0));
+        #if !defined(_DSP_FMA)
+        v = _mm256_add_ps(_mm256_mul_ps(v, step_inv_vec), offset_vec);
+        #else
+        v = _mm256_fmadd_ps(v, step_inv_vec, offset_vec);
+        #endif
+        v = _mm256_min_ps(_mm256_max_ps(v, min_vec), max_vec);
+        // truncate to integer level before weighting
+        v = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(v));
+        return _mm256_mul_ps(v, axis_weight);
+    };
+
+    for (int i = 0; i < M; i++) {
+        const std::complex<float>* x0 = &x[i*K];
+        // [s0 s1 s4 s5 s2 s3 s6 s7]
+        __m256i a0 = _mm256_cvttps_epi32(_mm256_hadd_ps(get_index(&x0[0]), get_index(&x0[4])));
+        // [s0 ... s7]
+        a0 = _mm256_permutevar8x32_epi32(a0, hadd_order);
+        // [s0 ... s7] as 8bit indices
+        __m128i b0 = _mm_packs_epi32(_mm256_castsi256_si128(a0), _mm256_extracti128_si256(a0, 1));
+        b0 = _mm_packus_epi16(b0, b0);
+        // gray code lookup
+        b0 = _mm_shuffle_epi8(lut_vec, b0);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&y[i*K]), b0);
+    }
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    c32_slice_square_scalar(&x[N_vector], &y[N_vector], N_remain, step_inv, L, lut);
+}
+#endif
+
+inline static
+void c32_slice_square_auto(
+    const std::complex<float>* x, uint8_t* y, const int N,
+    const float step_inv, const int L, const uint8_t* lut)
+{
+    #if defined(_DSP_AVX2)
+    c32_slice_square_avx2(x, y, N, step_inv, L, lut);
+    #elif defined(_DSP_SSSE3)
+    c32_slice_square_ssse3(x, y, N, step_inv, L, lut);
+    #else
+    c32_slice_square_scalar(x, y, N, step_inv, L, lut);
+    #endif
+}
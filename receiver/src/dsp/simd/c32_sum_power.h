@@ -0,0 +1,95 @@
+#pragma once
+#include <assert.h>
+#include <complex>
+
+// Sum of the power of complex floats, i.e. I^2 + Q^2
+// NOTE: Unaligned loads are used so this can be run over any window of a buffer
+
+static inline
+float c32_sum_power_scalar(const std::complex<float>* x, const int N) {
+    float y = 0.0f;
+    for (int i = 0; i < N; i++) {
+        y += x[i].real()*x[i].real() + x[i].imag()*x[i].imag();
+    }
+    return y;
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+#include "data_packing.h"
+#include "c32_cum_sum.h"
+
+#if defined(_DSP_SSSE3)
+static inline
+float c32_sum_power_ssse3(const std::complex<float>* x, const int N)
+{
+    // 128bits = 16bytes = 2*8bytes
+    constexpr int K = 2;
+    const int M = N/K;
+
+    // [I^2 Q^2] for each complex lane
+    cpx128_t v_sum;
+    v_sum.ps = _mm_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1]
+        __m128 a0 = _mm_loadu_ps(reinterpret_cast<const float*>(&x[i*K]));
+        #if !defined(_DSP_FMA)
+        v_sum.ps = _mm_add_ps(_mm_mul_ps(a0, a0), v_sum.ps);
+        #else
+        v_sum.ps = _mm_fmadd_ps(a0, a0, v_sum.ps);
+        #endif
+    }
+
+    const auto c = c32_cum_sum_ssse3(v_sum);
+    float y = c.real() + c.imag();
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    y += c32_sum_power_scalar(&x[N_vector], N_remain);
+    return y;
+}
+#endif
+
+#if defined(_DSP_AVX2)
+static inline
+float c32_sum_power_avx2(const std::complex<float>* x, const int N)
+{
+    // 256bits = 32bytes = 4*8bytes
+    constexpr int K = 4;
+    const int M = N/K;
+
+    cpx256_t v_sum;
+    v_sum.ps = _mm256_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1 c2 c3]
+        __m256 a0 = _mm256_loadu_ps(reinterpret_cast<const float*>(&x[i*K]));
+        #if !defined(_DSP_FMA)
+        v_sum.ps = _mm256_add_ps(_mm256_mul_ps(a0, a0), v_sum.ps);
+        #else
+        v_sum.ps = _mm256_fmadd_ps(a0, a0, v_sum.ps);
+        #endif
+    }
+
+    const auto c = c32_cum_sum_avx2(v_sum);
+    float y = c.real() + c.imag();
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    y += c32_sum_power_scalar(&x[N_vector], N_remain);
+    return y;
+}
+#endif
+
+inline static
+float c32_sum_power_auto(const std::complex<float>* x, const int N) {
+    #if defined(_DSP_AVX2)
+    return c32_sum_power_avx2(x, N);
+    #elif defined(_DSP_SSSE3)
+    return c32_sum_power_ssse3(x, N);
+    #else
+    return c32_sum_power_scalar(x, N);
+    #endif
+}
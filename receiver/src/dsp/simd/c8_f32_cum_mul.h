@@ -0,0 +1,155 @@
+#pragma once
+#include <assert.h>
+#include <stdint.h>
+#include <complex>
+
+// NOTE: Assumes arrays are aligned
+// Multiply and accumulate vector of raw 8bit IQ samples with vector of floats
+// The unsigned 8bit samples are offset by 128, so we remove that offset while widening to float
+// This lets us apply a filter directly on the raw IQ samples without a separate conversion pass
+#include "c8_to_c32.h"
+
+static inline
+std::complex<float> c8_f32_cum_mul_scalar(const std::complex<uint8_t>* x0, const float* x1, const int N) {
+    auto y = std::complex<float>(0,0);
+    for (int i = 0; i < N; i++) {
+        const float I = static_cast<float>(x0[i].real()) - C8_IQ_OFFSET;
+        const float Q = static_cast<float>(x0[i].imag()) - C8_IQ_OFFSET;
+        y += std::complex<float>(I, Q) * x1[i];
+    }
+    return y;
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+#include "data_packing.h"
+#include "c32_cum_sum.h"
+
+#if defined(_DSP_SSSE3)
+static inline
+std::complex<float> c8_f32_cum_mul_ssse3(const std::complex<uint8_t>* x0, const float* x1, const int N)
+{
+    auto y = std::complex<float>(0,0);
+
+    // 64bits = 8bytes = 4*2bytes
+    constexpr int K = 4;
+    const int M = N/K;
+
+    // [3 2 1 0] -> [3 3 2 2]
+    const uint8_t PERMUTE_UPPER = 0b11111010;
+    // [3 2 1 0] -> [1 1 0 0]
+    const uint8_t PERMUTE_LOWER = 0b01010000;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 offset = _mm_set1_ps(C8_IQ_OFFSET);
+
+    cpx128_t v_sum;
+    v_sum.ps = _mm_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        // NOTE: Raw IQ samples are only aligned to 2bytes since we slide across them
+        // [c0 c1 c2 c3] as 8 x uint8
+        __m128i u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&x0[i*K]));
+        // [c0 c1 c2 c3] as 8 x uint16
+        __m128i u16 = _mm_unpacklo_epi8(u8, zero);
+        // [c0 c1] and [c2 c3] as 4 x int32
+        __m128i i32_lo = _mm_unpacklo_epi16(u16, zero);
+        __m128i i32_hi = _mm_unpackhi_epi16(u16, zero);
+        // [c0 c1] and [c2 c3] as 4 x float with offset removed
+        __m128 a0 = _mm_sub_ps(_mm_cvtepi32_ps(i32_lo), offset);
+        __m128 a1 = _mm_sub_ps(_mm_cvtepi32_ps(i32_hi), offset);
+
+        // [b0 b1 b2 b3]
+        __m128 b0 = _mm_load_ps(&x1[i*K]);
+        // [b2 b2 b3 b3]
+        __m128 b1 = _mm_shuffle_ps(b0, b0, PERMUTE_UPPER);
+        // [b0 b0 b1 b1]
+        b0 = _mm_shuffle_ps(b0, b0, PERMUTE_LOWER);
+
+        // multiply accumulate
+        #if !defined(_DSP_FMA)
+        v_sum.ps = _mm_add_ps(_mm_mul_ps(a0, b0), v_sum.ps);
+        v_sum.ps = _mm_add_ps(_mm_mul_ps(a1, b1), v_sum.ps);
+        #else
+        v_sum.ps = _mm_fmadd_ps(a0, b0, v_sum.ps);
+        v_sum.ps = _mm_fmadd_ps(a1, b1, v_sum.ps);
+        #endif
+    }
+
+    y += c32_cum_sum_ssse3(v_sum);
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    y += c8_f32_cum_mul_scalar(&x0[N_vector], &x1[N_vector], N_remain);
+
+    return y;
+}
+#endif
+
+#if defined(_DSP_AVX2)
+static inline
+std::complex<float> c8_f32_cum_mul_avx2(const std::complex<uint8_t>* x0, const float* x1, const int N)
+{
+    auto y = std::complex<float>(0,0);
+
+    // 256bits = 32bytes = 4*8bytes after widening from 4*2bytes
+    constexpr int K = 4;
+    const int M = N/K;
+
+    // [3 2 1 0] -> [3 3 2 2]
+    const uint8_t PERMUTE_UPPER = 0b11111010;
+    // [3 2 1 0] -> [1 1 0 0]
+    const uint8_t PERMUTE_LOWER = 0b01010000;
+
+    const __m256 offset = _mm256_set1_ps(C8_IQ_OFFSET);
+
+    cpx256_t v_sum;
+    v_sum.ps = _mm256_set1_ps(0.0f);
+
+    for (int i = 0; i < M; i++) {
+        // NOTE: Raw IQ samples are only aligned to 2bytes since we slide across them
+        // [c0 c1 c2 c3] as 8 x uint8
+        __m128i u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&x0[i*K]));
+        // [c0 c1 c2 c3] as 8 x float with offset removed
+        __m256 a0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(u8));
+        a0 = _mm256_sub_ps(a0, offset);
+
+        // [b0 b1 b2 b3]
+        __m128 b0 = _mm_load_ps(&x1[i*K]);
+        // [b0 b0 b1 b1]
+        __m128 b1 = _mm_permute_ps(b0, PERMUTE_LOWER);
+        // [b2 b2 b3 b3]
+        b0 = _mm_permute_ps(b0, PERMUTE_UPPER);
+
+        // [b0 b0 b1 b1 b2 b2 b3 b3]
+        __m256 a1 = _mm256_set_m128(b0, b1);
+
+        // multiply accumulate
+        #if !defined(_DSP_FMA)
+        v_sum.ps = _mm256_add_ps(_mm256_mul_ps(a0, a1), v_sum.ps);
+        #else
+        v_sum.ps = _mm256_fmadd_ps(a0, a1, v_sum.ps);
+        #endif
+    }
+
+    y += c32_cum_sum_avx2(v_sum);
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    y += c8_f32_cum_mul_scalar(&x0[N_vector], &x1[N_vector], N_remain);
+
+    return y;
+}
+#endif
+
+inline static
+std::complex<float> c8_f32_cum_mul_auto(const std::complex<uint8_t>* x0, const float* x1, const int N) {
+    #if defined(_DSP_AVX2)
+    return c8_f32_cum_mul_avx2(x0, x1, N);
+    #elif defined(_DSP_SSSE3)
+    return c8_f32_cum_mul_ssse3(x0, x1, N);
+    #else
+    return c8_f32_cum_mul_scalar(x0, x1, N);
+    #endif
+}
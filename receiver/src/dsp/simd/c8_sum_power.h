@@ -0,0 +1,116 @@
+#pragma once
+#include <assert.h>
+#include <stdint.h>
+#include <complex>
+#include <algorithm>
+
+// Sum of the power of raw 8bit IQ samples, i.e. (I-128)^2 + (Q-128)^2
+// The sum is done with integers so it is exact and doesn't depend on the block size
+// NOTE: The raw IQ samples are only aligned to 2bytes
+
+static inline
+uint64_t c8_sum_power_scalar(const std::complex<uint8_t>* x, const int N) {
+    uint64_t y = 0;
+    for (int i = 0; i < N; i++) {
+        const int32_t I = (int32_t)x[i].real() - 128;
+        const int32_t Q = (int32_t)x[i].imag() - 128;
+        y += (uint64_t)(I*I + Q*Q);
+    }
+    return y;
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+
+// Each 32bit lane gains at most 2*128^2 = 2^15 per iteration
+// So we flush the lanes into a 64bit sum before they can overflow
+constexpr int C8_SUM_POWER_MAX_ITERATIONS = 1 << 15;
+
+#if defined(_DSP_SSSE3)
+static inline
+uint64_t c8_sum_power_ssse3(const std::complex<uint8_t>* x, const int N)
+{
+    uint64_t y = 0;
+
+    // 128bits = 16bytes = 8*2bytes
+    constexpr int K = 8;
+    const int M = N/K;
+
+    // flipping the sign bit is the same as subtracting 128 and reinterpreting as int8
+    const __m128i sign_bit = _mm_set1_epi8((char)0x80);
+
+    for (int i0 = 0; i0 < M; i0 += C8_SUM_POWER_MAX_ITERATIONS) {
+        const int i1 = std::min(i0+C8_SUM_POWER_MAX_ITERATIONS, M);
+        __m128i v_sum = _mm_setzero_si128();
+        for (int i = i0; i < i1; i++) {
+            // [c0 ... c7] as 16 x int8
+            __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i*K]));
+            a0 = _mm_xor_si128(a0, sign_bit);
+            // sign extend by placing each byte in the upper half of a 16bit lane
+            __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(a0, a0), 8);
+            __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(a0, a0), 8);
+            // I^2 + Q^2 as 4 x int32
+            v_sum = _mm_add_epi32(v_sum, _mm_madd_epi16(lo, lo));
+            v_sum = _mm_add_epi32(v_sum, _mm_madd_epi16(hi, hi));
+        }
+        alignas(16) uint32_t v[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(v), v_sum);
+        y += (uint64_t)v[0] + (uint64_t)v[1] + (uint64_t)v[2] + (uint64_t)v[3];
+    }
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    y += c8_sum_power_scalar(&x[N_vector], N_remain);
+    return y;
+}
+#endif
+
+#if defined(_DSP_AVX2)
+static inline
+uint64_t c8_sum_power_avx2(const std::complex<uint8_t>* x, const int N)
+{
+    uint64_t y = 0;
+
+    // 256bits = 32bytes = 16*2bytes after widening from 8*2bytes
+    constexpr int K = 8;
+    const int M = N/K;
+
+    const __m128i sign_bit = _mm_set1_epi8((char)0x80);
+
+    for (int i0 = 0; i0 < M; i0 += C8_SUM_POWER_MAX_ITERATIONS) {
+        const int i1 = std::min(i0+C8_SUM_POWER_MAX_ITERATIONS, M);
+        __m256i v_sum = _mm256_setzero_si256();
+        for (int i = i0; i < i1; i++) {
+            // [c0 ... c7] as 16 x int8
+            __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i*K]));
+            a0 = _mm_xor_si128(a0, sign_bit);
+            // [c0 ... c7] as 16 x int16
+            __m256i a1 = _mm256_cvtepi8_epi16(a0);
+            // I^2 + Q^2 as 8 x int32
+            v_sum = _mm256_add_epi32(v_sum, _mm256_madd_epi16(a1, a1));
+        }
+        alignas(32) uint32_t v[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(v), v_sum);
+        for (int j = 0; j < 8; j++) {
+            y += (uint64_t)v[j];
+        }
+    }
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    y += c8_sum_power_scalar(&x[N_vector], N_remain);
+    return y;
+}
+#endif
+
+inline static
+uint64_t c8_sum_power_auto(const std::complex<uint8_t>* x, const int N) {
+    #if defined(_DSP_AVX2)
+    return c8_sum_power_avx2(x, N);
+    #elif defined(_DSP_SSSE3)
+    return c8_sum_power_ssse3(x, N);
+    #else
+    return c8_sum_power_scalar(x, N);
+    #endif
+}
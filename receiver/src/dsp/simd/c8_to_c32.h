@@ -0,0 +1,95 @@
+#pragma once
+#include <assert.h>
+#include <stdint.h>
+#include <complex>
+
+// Convert raw 8bit IQ samples to complex floats
+// The unsigned 8bit samples are offset by 128, so we remove that offset while widening to float
+// NOTE: The raw IQ samples are only aligned to 2bytes so unaligned loads and stores are used
+
+constexpr float C8_IQ_OFFSET = 128.0f;
+
+static inline
+void c8_to_c32_scalar(const std::complex<uint8_t>* x, std::complex<float>* y, const int N) {
+    for (int i = 0; i < N; i++) {
+        y[i] = std::complex<float>(
+            static_cast<float>(x[i].real()) - C8_IQ_OFFSET,
+            static_cast<float>(x[i].imag()) - C8_IQ_OFFSET);
+    }
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+
+#if defined(_DSP_SSSE3)
+static inline
+void c8_to_c32_ssse3(const std::complex<uint8_t>* x, std::complex<float>* y, const int N)
+{
+    // 64bits = 8bytes = 4*2bytes
+    constexpr int K = 4;
+    const int M = N/K;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 offset = _mm_set1_ps(C8_IQ_OFFSET);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 c1 c2 c3] as 8 x uint8
+        __m128i u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&x[i*K]));
+        // [c0 c1 c2 c3] as 8 x uint16
+        __m128i u16 = _mm_unpacklo_epi8(u8, zero);
+        // [c0 c1] and [c2 c3] as 4 x int32
+        __m128i i32_lo = _mm_unpacklo_epi16(u16, zero);
+        __m128i i32_hi = _mm_unpackhi_epi16(u16, zero);
+        // [c0 c1] and [c2 c3] as 4 x float with offset removed
+        __m128 a0 = _mm_sub_ps(_mm_cvtepi32_ps(i32_lo), offset);
+        __m128 a1 = _mm_sub_ps(_mm_cvtepi32_ps(i32_hi), offset);
+        _mm_storeu_ps(reinterpret_cast<float*>(&y[i*K]), a0);
+        _mm_storeu_ps(reinterpret_cast<float*>(&y[i*K+2]), a1);
+    }
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    c8_to_c32_scalar(&x[N_vector], &y[N_vector], N_remain);
+}
+#endif
+
+#if defined(_DSP_AVX2)
+static inline
+void c8_to_c32_avx2(const std::complex<uint8_t>* x, std::complex<float>* y, const int N)
+{
+    // 128bits = 16bytes = 8*2bytes which widens to 2*256bits
+    constexpr int K = 8;
+    const int M = N/K;
+
+    const __m256 offset = _mm256_set1_ps(C8_IQ_OFFSET);
+
+    for (int i = 0; i < M; i++) {
+        // [c0 ... c7] as 16 x uint8
+        __m128i u8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i*K]));
+        // [c0 c1 c2 c3] and [c4 c5 c6 c7] as 8 x int32
+        __m256i i32_lo = _mm256_cvtepu8_epi32(u8);
+        __m256i i32_hi = _mm256_cvtepu8_epi32(_mm_srli_si128(u8, 8));
+        // [c0 c1 c2 c3] and [c4 c5 c6 c7] as 8 x float with offset removed
+        __m256 a0 = _mm256_sub_ps(_mm256_cvtepi32_ps(i32_lo), offset);
+        __m256 a1 = _mm256_sub_ps(_mm256_cvtepi32_ps(i32_hi), offset);
+        _mm256_storeu_ps(reinterpret_cast<float*>(&y[i*K]), a0);
+        _mm256_storeu_ps(reinterpret_cast<float*>(&y[i*K+4]), a1);
+    }
+
+    const int N_vector = M*K;
+    const int N_remain = N-N_vector;
+    c8_to_c32_scalar(&x[N_vector], &y[N_vector], N_remain);
+}
+#endif
+
+inline static
+void c8_to_c32_auto(const std::complex<uint8_t>* x, std::complex<float>* y, const int N) {
+    #if defined(_DSP_AVX2)
+    c8_to_c32_avx2(x, y, N);
+    #elif defined(_DSP_SSSE3)
+    c8_to_c32_ssse3(x, y, N);
+    #else
+    c8_to_c32_scalar(x, y, N);
+    #endif
+}
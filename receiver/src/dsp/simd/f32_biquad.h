@@ -0,0 +1,139 @@
+#pragma once
+#include <assert.h>
+
+// Apply one second order section in place to N samples of C independent channels
+// Samples are interleaved by channel, i.e. x[n*C + c]
+// Transposed direct form II with the feedback sign of IIR_Filter
+// y  = b0*x + s1
+// s1 = b1*x + a1*y + s2
+// s2 = b2*x + a2*y
+// coeffs = [b0 b1 b2 a1 a2] where each coefficient has C values, one for each channel
+// state  = [s1 s2] where each has C values
+// The SIMD kernels hold the state of a group of channels in registers for the whole block
+// NOTE: Unaligned loads are used so any number of channels can be packed together
+
+// Channels from C_start to C are filtered so the SIMD kernels can finish off the remainder
+static inline
+void f32_biquad_scalar(float* x, const int N, const float* coeffs, float* state, const int C, const int C_start=0) {
+    for (int c = C_start; c < C; c++) {
+        const float b0 = coeffs[0*C + c];
+        const float b1 = coeffs[1*C + c];
+        const float b2 = coeffs[2*C + c];
+        const float a1 = coeffs[3*C + c];
+        const float a2 = coeffs[4*C + c];
+        float s1 = state[0*C + c];
+        float s2 = state[1*C + c];
+        for (int n = 0; n < N; n++) {
+            const float xn = x[n*C + c];
+            const float yn = b0*xn + s1;
+            s1 = b1*xn + a1*yn + s2;
+            s2 = b2*xn + a2*yn;
+            x[n*C + c] = yn;
+        }
+        state[0*C + c] = s1;
+        state[1*C + c] = s2;
+    }
+}
+
+// TODO: Modify code to support ARM platforms like Raspberry PI using NEON
+#include <immintrin.h>
+#include "simd_config.h"
+
+#if defined(_DSP_SSSE3)
+// Channels from C_start to C are filtered in groups of 4
+// return the index of the first channel which wasn't filtered
+static inline
+int f32_biquad_ssse3_channels(float* x, const int N, const float* coeffs, float* state, const int C, const int C_start)
+{
+    // 128bits = 16bytes = 4*4bytes
+    constexpr int K = 4;
+    const int M = (C-C_start)/K;
+
+    for (int i = 0; i < M; i++) {
+        const int c = C_start + i*K;
+        const __m128 b0 = _mm_loadu_ps(&coeffs[0*C + c]);
+        const __m128 b1 = _mm_loadu_ps(&coeffs[1*C + c]);
+        const __m128 b2 = _mm_loadu_ps(&coeffs[2*C + c]);
+        const __m128 a1 = _mm_loadu_ps(&coeffs[3*C + c]);
+        const __m128 a2 = _mm_loadu_ps(&coeffs[4*C + c]);
+        __m128 s1 = _mm_loadu_ps(&state[0*C + c]);
+        __m128 s2 = _mm_loadu_ps(&state[1*C + c]);
+        for (int n = 0; n < N; n++) {
+            float* v = &x[n*C + c];
+            const __m128 xn = _mm_loadu_ps(v);
+            #if !defined(_DSP_FMA)
+            const __m128 yn = _mm_add_ps(_mm_mul_ps(b0, xn), s1);
+            s1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b1, xn), _mm_mul_ps(a1, yn)), s2);
+            s2 = _mm_add_ps(_mm_mul_ps(b2, xn), _mm_mul_ps(a2, yn));
+            #else
+            const __m128 yn = _mm_fmadd_ps(b0, xn, s1);
+            s1 = _mm_fmadd_ps(a1, yn, _mm_fmadd_ps(b1, xn, s2));
+            s2 = _mm_fmadd_ps(a2, yn, _mm_mul_ps(b2, xn));
+            #endif
+            _mm_storeu_ps(v, yn);
+        }
+        _mm_storeu_ps(&state[0*C + c], s1);
+        _mm_storeu_ps(&state[1*C + c], s2);
+    }
+    return C_start + M*K;
+}
+
+static inline
+void f32_biquad_ssse3(float* x, const int N, const float* coeffs, float* state, const int C)
+{
+    const int C_vector = f32_biquad_ssse3_channels(x, N, coeffs, state, C, 0);
+    f32_biquad_scalar(x, N, coeffs, state, C, C_vector);
+}
+#endif
+
+#if defined(_DSP_AVX2)
+static inline
+void f32_biquad_avx2(float* x, const int N, const float* coeffs, float* state, const int C)
+{
+    // 256bits = 32bytes = 8*4bytes
+    constexpr int K = 8;
+    const int M = C/K;
+
+    for (int i = 0; i < M; i++) {
+        const int c = i*K;
+        const __m256 b0 = _mm256_loadu_ps(&coeffs[0*C + c]);
+        const __m256 b1 = _mm256_loadu_ps(&coeffs[1*C + c]);
+        const __m256 b2 = _mm256_loadu_ps(&coeffs[2*C + c]);
+        const __m256 a1 = _mm256_loadu_ps(&coeffs[3*C + c]);
+        const __m256 a2 = _mm256_loadu_ps(&coeffs[4*C + c]);
+        __m256 s1 = _mm256_loadu_ps(&state[0*C + c]);
+        __m256 s2 = _mm256_loadu_ps(&state[1*C + c]);
+        for (int n = 0; n < N; n++) {
+            float* v = &x[n*C + c];
+            const __m256 xn = _mm256_loadu_ps(v);
+            #if !defined(_DSP_FMA)
+            const __m256 yn = _mm256_add_ps(_mm256_mul_ps(b0, xn), s1);
+            s1 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b1, xn), _mm256_mul_ps(a1, yn)), s2);
+            s2 = _mm256_add_ps(_mm256_mul_ps(b2, xn), _mm256_mul_ps(a2, yn));
+            #else
+            const __m256 yn = _mm256_fmadd_ps(b0, xn, s1);
+            s1 = _mm256_fmadd_ps(a1, yn, _mm256_fmadd_ps(b1, xn, s2));
+            s2 = _mm256_fmadd_ps(a2, yn, _mm256_mul_ps(b2, xn));
+            #endif
+            _mm256_storeu_ps(v, yn);
+        }
+        _mm256_storeu_ps(&state[0*C + c], s1);
+        _mm256_storeu_ps(&state[1*C + c], s2);
+    }
+
+    // Use the narrower vectors on what is left over
+    const int C_vector = f32_biquad_ssse3_channels(x, N, coeffs, state, C, M*K);
+    f32_biquad_scalar(x, N, coeffs, state, C, C_vector);
+}
+#endif
+
+inline static
+void f32_biquad_auto(float* x, const int N, const float* coeffs, float* state, const int C) {
+    #if defined(_DSP_AVX2)
+    f32_biquad_avx2(x, N, coeffs, state, C);
+    #elif defined(_DSP_SSSE3)
+    f32_biquad_ssse3(x, N, coeffs, state, C);
+    #else
+    f32_biquad_scalar(x, N, coeffs, state, C);
+    #endif
+}
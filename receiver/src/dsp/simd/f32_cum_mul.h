@@ -1,7 +1,8 @@
 #pragma once
 #include <assert.h>
 
-// NOTE: Assumes arrays are aligned
+// NOTE: Assumes the coefficients x1 are aligned
+//       The input x0 is unaligned since filters slide across it one sample at a time
 // Multiply and accumulate vector of floats with another vector of floats
 
 static inline
@@ -33,7 +34,7 @@ float f32_cum_mul_ssse3(const float* x0, const float* x1, const int N)
     v_sum.ps = _mm_set1_ps(0.0f);
 
     for (int i = 0; i < M; i++) {
-        __m128 a0 = _mm_load_ps(&x0[i*K]);
+        __m128 a0 = _mm_loadu_ps(&x0[i*K]);
         __m128 a1 = _mm_load_ps(&x1[i*K]);
 
         // multiply accumulate
@@ -68,7 +69,7 @@ float f32_cum_mul_avx2(const float* x0, const float* x1, const int N)
     v_sum.ps = _mm256_set1_ps(0.0f);
 
     for (int i = 0; i < M; i++) {
-        __m256 a0 = _mm256_load_ps(&x0[i*K]);
+        __m256 a0 = _mm256_loadu_ps(&x0[i*K]);
         __m256 a1 = _mm256_load_ps(&x1[i*K]);
 
         // multiply accumulate
@@ -0,0 +1,223 @@
+#include "raw_iq_reader.h"
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// StreamIQ_Reader
+StreamIQ_Reader::StreamIQ_Reader(FILE* _fp, const bool _is_owned)
+: fp(_fp), is_owned(_is_owned)
+{
+#if defined(_WIN32)
+    // NOTE: Windows does extra translation stuff that messes up the file if this isn't done
+    // https://docs.microsoft.com/en-us/cpp/c-runtime-library/reference/setmode?view=msvc-170
+    _setmode(_fileno(fp), _O_BINARY);
+#endif
+    // Larger reads mean less time spent in syscalls
+    constexpr size_t STREAM_BUFFER_SIZE = 1u << 20;
+    setvbuf(fp, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+}
+
+StreamIQ_Reader::~StreamIQ_Reader() {
+    if (is_owned) {
+        fclose(fp);
+    }
+}
+
+tcb::span<const std::complex<uint8_t>> StreamIQ_Reader::Read(tcb::span<std::complex<uint8_t>> buf) {
+    const size_t nb_read = fread(buf.data(), sizeof(std::complex<uint8_t>), buf.size(), fp);
+    return buf.first(nb_read);
+}
+
+bool StreamIQ_Reader::Rewind() {
+    // NOTE: This fails for pipes
+    return fseek(fp, 0, SEEK_SET) == 0;
+}
+
+// MmapIQ_Reader
+// Number of bytes behind the read position which we keep mapped in
+// This needs to cover all the blocks which are still in flight in the pipelined receiver
+constexpr size_t MMAP_RELEASE_WINDOW = size_t(64) << 20;
+
+#if defined(_WIN32)
+struct MmapIQ_Reader::Mapping {
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE map = NULL;
+    uint8_t* data = NULL;
+    size_t length = 0;
+};
+#else
+struct MmapIQ_Reader::Mapping {
+    int fd = -1;
+    uint8_t* data = NULL;
+    size_t length = 0;
+};
+#endif
+
+MmapIQ_Reader::MmapIQ_Reader()
+: mapping(std::make_unique<Mapping>())
+{}
+
+MmapIQ_Reader::~MmapIQ_Reader() {
+    Close();
+}
+
+#if defined(_WIN32)
+bool MmapIQ_Reader::Open(const char* filename) {
+    Close();
+    auto& m = *(mapping.get());
+    m.file = CreateFileA(
+        filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m.file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m.file, &size) || (size.QuadPart == 0)) {
+        Close();
+        return false;
+    }
+
+    m.map = CreateFileMappingA(m.file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m.map == NULL) {
+        Close();
+        return false;
+    }
+
+    m.data = reinterpret_cast<uint8_t*>(MapViewOfFile(m.map, FILE_MAP_READ, 0, 0, 0));
+    if (m.data == NULL) {
+        Close();
+        return false;
+    }
+
+    m.length = (size_t)size.QuadPart;
+    total_samples = m.length / sizeof(std::complex<uint8_t>);
+    Rewind();
+    return true;
+}
+
+void MmapIQ_Reader::Close() {
+    auto& m = *(mapping.get());
+    if (m.data != NULL) {
+        UnmapViewOfFile(m.data);
+    }
+    if (m.map != NULL) {
+        CloseHandle(m.map);
+    }
+    if (m.file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m.file);
+    }
+    m = Mapping();
+    total_samples = 0;
+}
+
+void MmapIQ_Reader::ReleaseConsumed() {
+    // NOTE: Windows trims the working set of the mapping by itself
+}
+#else
+bool MmapIQ_Reader::Open(const char* filename) {
+    Close();
+    auto& m = *(mapping.get());
+    m.fd = open(filename, O_RDONLY);
+    if (m.fd < 0) {
+        return false;
+    }
+
+    // Pipes and devices can't be mapped
+    struct stat st;
+    if ((fstat(m.fd, &st) != 0) || !S_ISREG(st.st_mode) || (st.st_size == 0)) {
+        Close();
+        return false;
+    }
+
+    m.length = (size_t)st.st_size;
+    void* data = mmap(NULL, m.length, PROT_READ, MAP_PRIVATE, m.fd, 0);
+    if (data == MAP_FAILED) {
+        m.length = 0;
+        Close();
+        return false;
+    }
+    m.data = reinterpret_cast<uint8_t*>(data);
+
+    // We read the capture from start to end so the kernel can read ahead aggressively
+    madvise(m.data, m.length, MADV_SEQUENTIAL);
+
+    total_samples = m.length / sizeof(std::complex<uint8_t>);
+    Rewind();
+    return true;
+}
+
+void MmapIQ_Reader::Close() {
+    auto& m = *(mapping.get());
+    if (m.data != NULL) {
+        munmap(m.data, m.length);
+    }
+    if (m.fd >= 0) {
+        close(m.fd);
+    }
+    m = Mapping();
+    total_samples = 0;
+}
+
+void MmapIQ_Reader::ReleaseConsumed() {
+    const size_t curr_byte = curr_sample * sizeof(std::complex<uint8_t>);
+    const size_t released_byte = released_sample * sizeof(std::complex<uint8_t>);
+    // release in large chunks to avoid calling madvise every block
+    if (curr_byte < released_byte + 2*MMAP_RELEASE_WINDOW) {
+        return;
+    }
+
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t start = (released_byte / page_size) * page_size;
+    const size_t end = ((curr_byte - MMAP_RELEASE_WINDOW) / page_size) * page_size;
+    if (end > start) {
+        madvise(&mapping->data[start], end-start, MADV_DONTNEED);
+    }
+    released_sample = end / sizeof(std::complex<uint8_t>);
+}
+#endif
+
+tcb::span<const std::complex<uint8_t>> MmapIQ_Reader::Read(tcb::span<std::complex<uint8_t>> buf) {
+    const size_t nb_remain = total_samples - curr_sample;
+    const size_t nb_read = std::min(buf.size(), nb_remain);
+    const auto* samples = reinterpret_cast<const std::complex<uint8_t>*>(mapping->data);
+    auto x = tcb::span<const std::complex<uint8_t>>(&samples[curr_sample], nb_read);
+    curr_sample += nb_read;
+    ReleaseConsumed();
+    return x;
+}
+
+bool MmapIQ_Reader::Rewind() {
+    curr_sample = 0;
+    released_sample = 0;
+    return true;
+}
+
+std::unique_ptr<RawIQ_Reader> CreateRawIQ_Reader(const char* filename, const bool is_mmap) {
+    if (filename == NULL) {
+        return std::make_unique<StreamIQ_Reader>(stdin, false);
+    }
+
+    if (is_mmap) {
+        auto reader = std::make_unique<MmapIQ_Reader>();
+        if (reader->Open(filename)) {
+            return reader;
+        }
+    }
+
+    FILE* fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return nullptr;
+    }
+    return std::make_unique<StreamIQ_Reader>(fp, true);
+}
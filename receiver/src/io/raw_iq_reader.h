@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <complex>
+#include <memory>
+#include "utility/span.h"
+
+// Source of raw 8bit IQ samples from an rtl_sdr capture
+class RawIQ_Reader
+{
+public:
+    virtual ~RawIQ_Reader() {}
+    // Read the next buf.size() samples
+    // Returns either buf filled with samples, or a read only view into the reader's own memory if it can avoid a copy
+    // The returned samples are valid as long as buf and the reader are alive
+    // If less than buf.size() samples are returned then we have reached the end of the input
+    virtual tcb::span<const std::complex<uint8_t>> Read(tcb::span<std::complex<uint8_t>> buf) = 0;
+    // Returns false if the input can't be read from the start again
+    virtual bool Rewind() = 0;
+};
+
+// Reads from a file stream, this works for pipes and stdin
+class StreamIQ_Reader: public RawIQ_Reader
+{
+private:
+    FILE* fp;
+    const bool is_owned;
+public:
+    // is_owned = close the file when the reader is destroyed
+    StreamIQ_Reader(FILE* _fp, const bool _is_owned);
+    virtual ~StreamIQ_Reader();
+    virtual tcb::span<const std::complex<uint8_t>> Read(tcb::span<std::complex<uint8_t>> buf);
+    virtual bool Rewind();
+};
+
+// Memory maps a file so that samples are read straight from the page cache without a copy
+// The mapping is read only so the samples can't be modified in place
+class MmapIQ_Reader: public RawIQ_Reader
+{
+private:
+    struct Mapping;
+    std::unique_ptr<Mapping> mapping;
+    size_t total_samples = 0;
+    size_t curr_sample = 0;
+    // release pages far behind the read position so long captures don't bloat our memory usage
+    size_t released_sample = 0;
+public:
+    MmapIQ_Reader();
+    virtual ~MmapIQ_Reader();
+    // Returns false if the file couldn't be mapped
+    bool Open(const char* filename);
+    virtual tcb::span<const std::complex<uint8_t>> Read(tcb::span<std::complex<uint8_t>> buf);
+    virtual bool Rewind();
+private:
+    void Close();
+    void ReleaseConsumed();
+};
+
+// Memory map the file if possible and fall back to a stream otherwise
+// If filename is NULL then stdin is used
+std::unique_ptr<RawIQ_Reader> CreateRawIQ_Reader(const char* filename, const bool is_mmap=true);
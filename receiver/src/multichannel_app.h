@@ -0,0 +1,234 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <thread>
+
+#include "app.h"
+#include "dsp/channeliser.h"
+#include "dsp/pfb_channeliser.h"
+#include "utility/thread_pool.h"
+#include "utility/aligned_vector.h"
+#include "dsp/simd/c8_to_c32.h"
+
+// Receive several carriers at different frequency offsets from one wideband IQ stream
+// Reader --> [8bit to float] --> Channeliser --> QAM_Synchroniser --> FrameDecoder --> FrameHandler
+//                            --> Channeliser --> QAM_Synchroniser --> FrameDecoder --> FrameHandler
+//                            --> ...
+// Each channel is channelised, demodulated and decoded on a thread pool
+// If every channel lies on the grid of a 2x oversampled filterbank then all channels are extracted at once
+class MultiChannelApp
+{
+public:
+    // Shared by all channels except for the frequency offset of each channel
+    // f_sample is the sampling rate of the wideband signal
+    // downsampling_filter is used by the channeliser
+    QAM_Synchroniser_Specification qam_sync_spec;
+    std::atomic<bool> is_running = true;
+    bool is_read_loop = false;
+private:
+    struct Channel {
+        float f_offset;
+        std::unique_ptr<NCO_Channeliser> channeliser;
+        std::unique_ptr<QAM_Synchroniser_Buffer> buffer;
+        std::unique_ptr<QAM_Synchroniser> qam_sync;
+        std::unique_ptr<FrameDecoder> frame_decoder;
+        std::unique_ptr<AudioFilter> audio_filter;
+        std::unique_ptr<FrameHandler> frame_handler;
+    };
+    std::unique_ptr<RawIQ_Reader> rx_reader;
+    int rd_total_blocks = 0;
+    const int demod_block_size;
+    const int ds_factor;
+    const int us_factor;
+    std::unique_ptr<ConstellationSpecification> constellation;
+    std::vector<Channel> channels;
+    std::unique_ptr<ThreadPool> thread_pool;
+    // shared channeliser when all channels are on its grid
+    std::unique_ptr<PFB_Channeliser> filterbank;
+    std::vector<std::complex<float>*> filterbank_outputs;
+    // wideband input
+    AlignedVector<std::complex<uint8_t>> x_raw;
+    tcb::span<const std::complex<uint8_t>> x_raw_block;
+    AlignedVector<std::complex<float>> x_wideband;
+public:
+    // f_offsets = centre frequency of each channel relative to the centre of the wideband signal
+    // nb_threads = total threads used to process channels, if 0 then use the number of cores
+    MultiChannelApp(
+        std::unique_ptr<RawIQ_Reader> _rx_reader, const int _demod_block_size,
+        const int decoder_block_size, const int _ds_factor, const int _us_factor,
+        const int audio_block_size, const float F_audio,
+        const std::vector<float>& f_offsets, int nb_threads=0)
+    : rx_reader(std::move(_rx_reader)),
+      demod_block_size(_demod_block_size),
+      ds_factor(_ds_factor), us_factor(_us_factor),
+      x_raw(_demod_block_size*_ds_factor),
+      x_wideband(_demod_block_size*_ds_factor)
+    {
+        constellation = std::make_unique<SquareConstellation>(4);
+
+        const uint32_t preamble_code = 0b11111001101011111100110101101101;
+        const uint16_t scrambler_syncword = 0b1000010101011001;
+        const uint8_t conv_poly[2] = { 0b111, 0b101 };
+        const uint8_t crc8_polynomial = 0xD5;
+
+        channels.resize(f_offsets.size());
+        for (size_t i = 0; i < f_offsets.size(); i++) {
+            auto& ch = channels[i];
+            ch.f_offset = f_offsets[i];
+            // channels are only demodulated headless so they don't need telemetry
+            ch.buffer = std::make_unique<QAM_Synchroniser_Buffer>(demod_block_size, ds_factor, us_factor, false);
+            ch.frame_decoder = std::make_unique<FrameDecoder>(
+                decoder_block_size,
+                *(constellation.get()),
+                preamble_code,
+                scrambler_syncword,
+                conv_poly,
+                crc8_polynomial);
+            ch.audio_filter = std::make_unique<AudioFilter>(audio_block_size, F_audio);
+            ch.frame_handler = std::make_unique<FrameHandler>(*(ch.audio_filter.get()));
+        }
+
+        if (nb_threads <= 0) {
+            nb_threads = (int)std::thread::hardware_concurrency();
+        }
+        // The calling thread also processes channels
+        const int nb_workers = std::min(nb_threads, (int)channels.size()) - 1;
+        thread_pool = std::make_unique<ThreadPool>(std::max(nb_workers, 0));
+
+        // NOTE: Demodulator has to be built by user
+    }
+    void BuildDemodulator() {
+        const auto& s = qam_sync_spec;
+        const float Fsource = s.f_sample;
+        // Same cutoff as the downsampling filter of the synchroniser
+        const float k = s.f_symbol/(Fsource/2.0f);
+        for (auto& ch: channels) {
+            ch.channeliser.reset();
+            ch.qam_sync = std::make_unique<QAM_Synchroniser>(qam_sync_spec, *(constellation.get()));
+        }
+
+        if (BuildFilterbank(k)) {
+            return;
+        }
+
+        for (auto& ch: channels) {
+            ch.channeliser = std::make_unique<NCO_Channeliser>(
+                ch.f_offset/Fsource,
+                s.downsampling_filter.M, s.downsampling_filter.K, k,
+                demod_block_size);
+        }
+    }
+    void Run() {
+        is_running = true;
+        rd_total_blocks = 0;
+
+        auto process_channel = std::function<void(int)>([this](int i) {
+            ProcessChannel(channels[i]);
+        });
+
+        while (is_running) {
+            {
+                PROFILE_BEGIN(read);
+                if (!ReadBlock()) {
+                    break;
+                }
+            }
+
+            {
+                PROFILE_BEGIN(convert);
+                // NOTE: The zero level of unsigned 8bit IQ is 128
+                c8_to_c32_auto(x_raw_block.data(), x_wideband.data(), (int)x_raw_block.size());
+            }
+
+            if (filterbank != NULL) {
+                PROFILE_BEGIN(filterbank);
+                filterbank->process(x_wideband.data(), filterbank_outputs.data(), demod_block_size);
+            }
+
+            PROFILE_BEGIN(channels);
+            thread_pool->ParallelFor((int)channels.size(), process_channel);
+        }
+    }
+    void Stop() {
+        is_running = false;
+    }
+public:
+    int GetTotalChannels() const { return (int)channels.size(); }
+    float GetChannelOffset(const int i) const { return channels[i].f_offset; }
+    auto& GetAudioFilter(const int i) { return *(channels[i].audio_filter.get()); }
+    auto& GetFrameHandler(const int i) { return *(channels[i].frame_handler.get()); }
+    bool IsUsingFilterbank() const { return filterbank != NULL; }
+    int GetTotalThreads() const { return thread_pool->GetTotalThreads() + 1; }
+    // Number of raw IQ samples demodulated in the last call to Run
+    int64_t GetTotalSamplesRead() { return (int64_t)rd_total_blocks * (int64_t)x_raw.size(); }
+private:
+    // Return false if we couldn't read a full block
+    // NOTE: The reader can point x_raw_block into its own memory instead of copying into x_raw
+    bool ReadBlock() {
+        auto rx_buffer = tcb::span(x_raw.data(), x_raw.size());
+        while (is_running) {
+            auto rx_block = rx_reader->Read(rx_buffer);
+            if (rx_block.size() == rx_buffer.size()) {
+                x_raw_block = rx_block;
+                rd_total_blocks++;
+                return true;
+            }
+
+            LOG_MESSAGE("Got mismatched block size after %d blocks\n", rd_total_blocks);
+            if (!is_read_loop) {
+                break;
+            }
+            if (!rx_reader->Rewind()) {
+                LOG_MESSAGE("Input can't be rewound for looped reading\n");
+                break;
+            }
+        }
+        return false;
+    }
+
+    // The filterbank has M = 2*D channels which are spaced Fs/M apart and decimated by D
+    // Returns false if a channel isn't on the grid so that each channel has to be mixed separately
+    bool BuildFilterbank(const float k) {
+        filterbank.reset();
+        filterbank_outputs.clear();
+
+        const auto& s = qam_sync_spec;
+        const int D = s.downsampling_filter.M;
+        const int M = 2*D;
+        if ((M & (M-1)) != 0) {
+            return false;
+        }
+
+        auto pfb = std::make_unique<PFB_Channeliser>(M, D, s.downsampling_filter.K, k, demod_block_size);
+        std::vector<std::complex<float>*> outputs(M, NULL);
+        for (auto& ch: channels) {
+            const int i = pfb->GetChannelIndex(ch.f_offset/s.f_sample);
+            if ((i < 0) || (outputs[i] != NULL)) {
+                return false;
+            }
+            outputs[i] = ch.buffer->x_downsampled.data();
+        }
+
+        filterbank = std::move(pfb);
+        filterbank_outputs = std::move(outputs);
+        return true;
+    }
+
+    void ProcessChannel(Channel& ch) {
+        auto& buffer = *(ch.buffer.get());
+        if (ch.channeliser != NULL) {
+            const int ds_size = buffer.GetPLLSize();
+            ch.channeliser->process(x_wideband.data(), buffer.x_downsampled.data(), ds_size);
+        }
+        const int nb_symbols = ch.qam_sync->ProcessDownsampledBlock(buffer);
+        auto syms = buffer.y_out.first(nb_symbols);
+        const auto events = ch.frame_decoder->ProcessBlock(syms);
+        for (auto& ev: events) {
+            ch.frame_handler->OnFrameResult(ev.result, ev.payload);
+        }
+    }
+};
@@ -8,7 +8,11 @@
 #include <fcntl.h>
 #endif
 
+#include <string>
+#include <vector>
+
 #include "app.h"
+#include "multichannel_app.h"
 #include "audio/portaudio_output.h"
 #include "audio/resampled_pcm_player.h"
 #include "audio/portaudio_utility.h"
@@ -28,12 +32,300 @@ void usage() {
         "\t    rd_block_size -> block_size -> us_block_size\n"
         "\t[-i input filename (default: None)]\n"
         "\t    If no file is provided then stdin is used\n"
+        "\t[-M disable memory mapping of the input file (default: false)]\n"
         "\t[-g audio gain (default: 100)]\n"
         "\t[-A toggle audio output (default: true)]\n"
+        "\t[-P run reader, demodulator and decoder on separate threads (default: false)]\n"
+        "\t    Can't be used with -c since channels are already spread across threads with -T\n"
+        "\t[-B run in batch mode without an audio device (default: false)]\n"
+        "\t    Input is processed as fast as possible and a throughput report is printed at the end\n"
+        "\t[-o batch mode output filename for payloads (default: None)]\n"
+        "\t    Each payload is written as a little endian uint16 length followed by its data\n"
+        "\t[-w batch mode output filename for audio (default: None)]\n"
+        "\t    Audio is written as 16bit stereo PCM at symbol_rate/5\n"
+        "\t[-c comma separated list of channel frequency offsets (default: None)]\n"
+        "\t    Demodulates a carrier at each offset from the input, e.g. -c -300e3,0,300e3\n"
+        "\t    Each channel is downsampled by D from the input sample rate\n"
+        "\t    Offsets on multiples of Fs/(2*D) are extracted together by one polyphase filterbank\n"
+        "\t    Audio is played from the first channel\n"
+        "\t[-T number of threads for multiple channels (default: number of cores)]\n"
+        "\t[-G use gardner timing recovery without upsampling (default: false)]\n"
+        "\t    Symbols are interpolated at Fs/D, which should be just above 2 samples per symbol\n"
+        "\t[-p carrier pll update period in downsampled samples (default: 1)]\n"
+        "\t    Periods greater than 1 generate the carrier with a vectorised oscillator\n"
+        "\t[-Q squelch threshold in dB relative to a full scale 8bit tone (default: None)]\n"
+        "\t    Demodulation is skipped while the signal power is below the threshold\n"
+        "\t    The squelch closes 3dB below the threshold so that it doesn't toggle on noise\n"
+        "\t[-C seed the carrier and timing loops from a matched filter on the preamble (default: false)]\n"
+        "\t    Shortens the acquisition of each burst to the length of the preamble\n"
+        "\t[-F estimate the carrier frequency offset and recentre the carrier pll on it (default: false)]\n"
+        "\t    Corrects offsets of up to +-Fs/(8*D), e.g. from the drift of the tuner's crystal\n"
         "\t[-h (show usage)]\n"
     );
 }
 
+// Decoded channel whose outputs are written to files in batch mode
+struct BatchChannel {
+    std::string label;
+    FrameHandler& frame_handler;
+    AudioFilter& audio_filter;
+};
+
+void PrintBatchReport(
+    tcb::span<BatchChannel> channels, const int64_t total_samples,
+    const float Fsample, const double elapsed_seconds) 
+{
+    const double samples_per_second = (double)total_samples / elapsed_seconds;
+    const double realtime_factor = samples_per_second / (double)Fsample;
+
+    fprintf(stderr, "\nThroughput\n");
+    fprintf(stderr, "  samples         : %lld\n", (long long)total_samples);
+    fprintf(stderr, "  elapsed         : %.3f s\n", elapsed_seconds);
+    fprintf(stderr, "  samples/s       : %.4e\n", samples_per_second);
+    fprintf(stderr, "  realtime factor : %.2fx\n", realtime_factor);
+
+    for (auto& channel: channels) {
+        auto& stats = channel.frame_handler.stats;
+        fprintf(stderr, "\nFrames %s\n", channel.label.c_str());
+        fprintf(stderr, "  total           : %d\n", stats.total);
+        fprintf(stderr, "  correct         : %d\n", stats.correct);
+        fprintf(stderr, "  incorrect       : %d\n", stats.incorrect);
+        fprintf(stderr, "  corrupted       : %d\n", stats.corrupted);
+        fprintf(stderr, "  repaired        : %d\n", stats.repaired);
+        if (stats.total > 0) {
+            fprintf(stderr, "  packet error    : %.3f%%\n", stats.GetPacketErrorRate()*100.0f);
+        }
+    }
+
+    fprintf(stderr, "\nStages\n");
+    #if !PROFILE_ENABLE
+    fprintf(stderr, "  Profiling is disabled, build with PROFILE_ENABLE=1 for per stage times\n");
+    #endif
+    fprintf(stderr, "  %-24s %12s %10s %12s %8s\n", "name", "total (ms)", "calls", "us/call", "%");
+    auto& instrumentor = Instrumentor::Get();
+    auto threads_lock = std::scoped_lock(instrumentor.GetThreadsMutex());
+    for (auto& [id, thread]: instrumentor.GetThreadsList()) {
+        auto lock = std::scoped_lock(thread.GetStageTotalsMutex());
+        auto& totals = thread.GetStageTotals();
+        if (totals.empty()) {
+            continue;
+        }
+        const char* label = thread.GetLabel();
+        fprintf(stderr, "  [%s]\n", (label[0] != 0) ? label : "worker");
+        for (auto& [name, total]: totals) {
+            const double total_ms = (double)total.total_micros * 1e-3;
+            const double us_per_call = (double)total.total_micros / (double)total.count;
+            const double percentage = total_ms * 1e-3 / elapsed_seconds * 100.0;
+            // indent nested stages
+            const int indent = 2*total.stack_index;
+            fprintf(stderr, "  %*s%-*s %12.2f %10d %12.2f %8.2f\n", 
+                indent, "", 24-indent, name, 
+                total_ms, total.count, us_per_call, percentage);
+        }
+    }
+}
+
+// Process the input as fast as possible without opening an audio device
+// If there are multiple channels then the output filenames are suffixed with the channel index
+template <typename T>
+int RunBatch(
+    T& app, tcb::span<BatchChannel> channels, 
+    const float Fsample, const float output_gain, 
+    const char* payload_filename, const char* pcm_filename) 
+{
+    const bool is_multichannel = channels.size() > 1;
+    auto get_filename = [is_multichannel](const char* filename, const int index) {
+        auto name = std::string(filename);
+        if (is_multichannel) {
+            name += "." + std::to_string(index);
+        }
+        return name;
+    };
+
+    std::vector<FILE*> files;
+    auto close_files = [&files]() {
+        for (auto* fp: files) {
+            fclose(fp);
+        }
+    };
+    auto open_file = [&files](const std::string& filename) {
+        FILE* fp = fopen(filename.c_str(), "wb");
+        if (fp == NULL) {
+            fprintf(stderr, "Failed to open output file: %s\n", filename.c_str());
+        } else {
+            files.push_back(fp);
+        }
+        return fp;
+    };
+
+    std::vector<std::vector<int16_t>> pcm_buffers(channels.size());
+    for (int i = 0; i < (int)channels.size(); i++) {
+        auto& channel = channels[i];
+
+        if (payload_filename != NULL) {
+            FILE* fp_payload = open_file(get_filename(payload_filename, i));
+            if (fp_payload == NULL) {
+                close_files();
+                return 1;
+            }
+            channel.frame_handler.OnPayload().Attach([fp_payload](tcb::span<const uint8_t> data) {
+                const uint16_t length = (uint16_t)data.size();
+                const uint8_t header[2] = { (uint8_t)(length & 0xFF), (uint8_t)(length >> 8) };
+                fwrite(header, sizeof(uint8_t), 2, fp_payload);
+                fwrite(data.data(), sizeof(uint8_t), data.size(), fp_payload);
+            });
+        }
+
+        FILE* fp_pcm = NULL;
+        if (pcm_filename != NULL) {
+            fp_pcm = open_file(get_filename(pcm_filename, i));
+            if (fp_pcm == NULL) {
+                close_files();
+                return 1;
+            }
+            auto& pcm_buffer = pcm_buffers[i];
+            channel.audio_filter.OnOutputBlock().Attach([fp_pcm, output_gain, &pcm_buffer](tcb::span<const Frame<float>> data) {
+                const int N = (int)data.size();
+                pcm_buffer.resize(N*TOTAL_AUDIO_CHANNELS);
+                for (int i = 0; i < N; i++) {
+                    for (int j = 0; j < TOTAL_AUDIO_CHANNELS; j++) {
+                        const float v = data[i].channels[j] * output_gain * 32767.0f;
+                        pcm_buffer[i*TOTAL_AUDIO_CHANNELS + j] = (int16_t)dsp::clamp(v, -32768.0f, 32767.0f);
+                    }
+                }
+                fwrite(pcm_buffer.data(), sizeof(int16_t), pcm_buffer.size(), fp_pcm);
+            });
+        }
+
+        // Skip audio filtering if we aren't going to write it
+        channel.frame_handler.is_output_audio = channel.frame_handler.is_output_audio && (fp_pcm != NULL);
+    }
+
+    app.BuildDemodulator();
+    PROFILE_TAG_THREAD("main");
+    const auto time_start = GetNow();
+    app.Run();
+    const auto time_end = GetNow();
+    const double elapsed_seconds = (double)(ConvertMicros(time_end) - ConvertMicros(time_start)) * 1e-6;
+
+    // The last audio block is only partially filled when the input runs out
+    for (auto& channel: channels) {
+        channel.audio_filter.Flush();
+    }
+    close_files();
+
+    PrintBatchReport(channels, app.GetTotalSamplesRead(), Fsample, elapsed_seconds);
+    return 0;
+}
+
+// Play the audio of a channel until the input is finished
+template <typename T>
+int RunAudio(T& app, AudioFilter& audio_filter, const float Faudio, const float output_gain) {
+    auto pa_handler = ScopedPaHandler();
+    PaDeviceList pa_devices;
+    PortAudio_Output pa_output;
+    std::unique_ptr<Resampled_PCM_Player> pcm_player;
+    {
+        auto& mixer = pa_output.GetMixer();
+        auto buf = mixer.CreateManagedBuffer(4);
+        auto Fs = pa_output.GetSampleRate();
+        pcm_player = std::make_unique<Resampled_PCM_Player>(buf, Fs);
+
+        #ifdef _WIN32
+        const auto target_host_api_index = Pa_HostApiTypeIdToHostApiIndex(PORTAUDIO_TARGET_HOST_API_ID);
+        const auto target_device_index = Pa_GetHostApiInfo(target_host_api_index)->defaultOutputDevice;
+        pa_output.Open(target_device_index);
+        #else
+        pa_output.Open(Pa_GetDefaultOutputDevice());
+        #endif
+    }
+
+    pa_output.GetMixer().GetOutputGain() = output_gain;
+
+    audio_filter.OnOutputBlock().Attach([&pcm_player, Faudio](tcb::span<const Frame<float>> data) {
+        pcm_player->SetInputSampleRate((int)Faudio);
+        pcm_player->ConsumeBuffer(data);
+    });
+    
+    app.BuildDemodulator();
+    app.Run();
+
+    auto& mixer = pa_output.GetMixer();
+    fprintf(stderr, "\nAudio\n");
+    fprintf(stderr, "  underruns       : %llu\n", (unsigned long long)mixer.GetTotalUnderruns());
+    fprintf(stderr, "  overruns        : %llu\n", (unsigned long long)mixer.GetTotalOverruns());
+    return 0;
+}
+
+void SetupSpecification(
+    QAM_Synchroniser_Specification& spec, 
+    const float Fsample, const float Fsymbol, 
+    const int ds_factor, const int us_factor, const int pll_block_size,
+    const bool is_gardner, const bool is_squelch, const float squelch_threshold,
+    const bool is_preamble_seed, const bool is_carrier_estimator) 
+{
+    const float PI = 3.1415f;
+    spec.f_sample = Fsample; 
+    spec.f_symbol = Fsymbol;
+    
+    spec.downsampling_filter.M = ds_factor;
+    spec.downsampling_filter.K = 6;
+
+    spec.upsampling_filter.L = us_factor;
+    spec.upsampling_filter.K = 6;
+
+    spec.ac_filter.k = 0.99999f;
+    spec.agc.beta = 0.2f;
+    spec.agc.initial_gain = 0.1f;
+    spec.carrier_pll.f_center = 0e3;
+    spec.carrier_pll.f_gain = 2.5e3;
+    spec.carrier_pll.phase_error_gain = 8.0f/PI;
+    spec.carrier_pll.block_size = pll_block_size;
+    spec.carrier_pll_filter.butterworth_cutoff = 5e3;
+    spec.carrier_pll_filter.integrator_gain = 1000.0f;
+    spec.ted_pll.f_gain = 30e3;
+    spec.ted_pll.f_offset = 0e3;
+    spec.ted_pll.phase_error_gain = 1.0f;
+    spec.ted_pll_filter.butterworth_cutoff = 60e3;
+    spec.ted_pll_filter.integrator_gain = 250.0f;
+
+    if (is_gardner) {
+        spec.timing_recovery = QAM_Synchroniser_Specification::TimingRecovery::GARDNER;
+        spec.ted_pll.f_gain = 20e3;
+        spec.ted_pll_filter.butterworth_cutoff = 40e3;
+    }
+
+    if (is_squelch) {
+        spec.squelch.is_enabled = true;
+        spec.squelch.threshold_open = squelch_threshold;
+        spec.squelch.threshold_close = squelch_threshold - 3.0f;
+    }
+
+    spec.preamble.is_enabled = is_preamble_seed;
+    spec.carrier_estimator.is_enabled = is_carrier_estimator;
+}
+
+// Parse a comma separated list of frequencies
+bool ParseFrequencies(const char* arg, std::vector<float>& frequencies) {
+    frequencies.clear();
+    const char* curr = arg;
+    while (*curr != 0) {
+        char* end = NULL;
+        const float f = strtof(curr, &end);
+        if (end == curr) {
+            return false;
+        }
+        frequencies.push_back(f);
+        curr = end;
+        if (*curr == ',') {
+            curr++;
+        } else if (*curr != 0) {
+            return false;
+        }
+    }
+    return !frequencies.empty();
+}
+
 int main(int argc, char **argv) {
     int ds_factor = 2;
     int us_factor = 4;
@@ -47,9 +339,22 @@ int main(int argc, char **argv) {
     // audio stream is symbol_rate / N
     const int audio_packet_sampling_ratio = 5;
     bool is_output_audio = true;
+    bool is_pipelined = false;
+    bool is_mmap = true;
+    bool is_batch = false;
+    const char* payload_filename = NULL;
+    const char* pcm_filename = NULL;
+    std::vector<float> channel_offsets;
+    int nb_threads = 0;
+    int pll_block_size = 1;
+    bool is_gardner = false;
+    bool is_squelch = false;
+    float squelch_threshold = 0.0f;
+    bool is_preamble_seed = false;
+    bool is_carrier_estimator = false;
 
     int opt; 
-    while ((opt = getopt_custom(argc, argv, "f:s:b:D:S:i:g:Ah")) != -1) {
+    while ((opt = getopt_custom(argc, argv, "f:s:b:D:S:i:Mg:APBo:w:c:T:p:GQ:CFh")) != -1) {
         switch (opt) {
         case 'f':
             Fsample = (float)(atof(optarg));
@@ -89,6 +394,9 @@ int main(int argc, char **argv) {
         case 'i':
             filename = optarg;
             break;
+        case 'M':
+            is_mmap = false;
+            break;
         case 'g':
             audio_gain = (int)(atof(optarg));
             if (audio_gain < 0) {
@@ -99,6 +407,51 @@ int main(int argc, char **argv) {
         case 'A':
             is_output_audio = false;
             break;
+        case 'P':
+            is_pipelined = true;
+            break;
+        case 'B':
+            is_batch = true;
+            break;
+        case 'o':
+            payload_filename = optarg;
+            break;
+        case 'w':
+            pcm_filename = optarg;
+            break;
+        case 'c':
+            if (!ParseFrequencies(optarg, channel_offsets)) {
+                fprintf(stderr, "Invalid list of channel frequencies (%s)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'T':
+            nb_threads = (int)(atof(optarg));
+            if (nb_threads <= 0) {
+                fprintf(stderr, "Number of threads must be positive (%d)\n", nb_threads); 
+                return 1;
+            }
+            break;
+        case 'p':
+            pll_block_size = (int)(atof(optarg));
+            if (pll_block_size <= 0) {
+                fprintf(stderr, "Carrier pll update period must be positive (%d)\n", pll_block_size); 
+                return 1;
+            }
+            break;
+        case 'G':
+            is_gardner = true;
+            break;
+        case 'Q':
+            is_squelch = true;
+            squelch_threshold = (float)(atof(optarg));
+            break;
+        case 'C':
+            is_preamble_seed = true;
+            break;
+        case 'F':
+            is_carrier_estimator = true;
+            break;
         case 'h':
         default:
             usage();
@@ -106,21 +459,35 @@ int main(int argc, char **argv) {
         }
     }
 
+    // gardner timing recovery doesn't need an upsampled signal
+    if (is_gardner) {
+        us_factor = 1;
+    }
+
     audio_gain = dsp::clamp(audio_gain, 0, 1000);
+    const float output_gain = (float)audio_gain / 100.0f;
 
-    FILE* fp_in = stdin;
-    if (filename != NULL) {
-        errno_t err = fopen_s(&fp_in, filename, "r");
-        if (err != 0) {
-            fprintf(stderr, "Failed to open file: %s\n", filename);
+    if (is_pipelined && !channel_offsets.empty()) {
+        fprintf(stderr, "Pipelined mode isn't supported with multiple channels (-P with -c)\n");
+        return 1;
+    }
+
+    for (auto f: channel_offsets) {
+        if (std::abs(f) >= Fsample/2.0f) {
+            fprintf(stderr, "Channel frequency must be within the sampling bandwidth (%.2f)\n", f);
             return 1;
         }
     }
 
+    auto rx_reader = CreateRawIQ_Reader(filename, is_mmap);
+    if (rx_reader == nullptr) {
+        fprintf(stderr, "Failed to open file: %s\n", filename);
+        return 1;
+    }
+
 #if defined(_WIN32)
     // NOTE: Windows does extra translation stuff that messes up the file if this isn't done
     // https://docs.microsoft.com/en-us/cpp/c-runtime-library/reference/setmode?view=msvc-170
-    _setmode(_fileno(fp_in), _O_BINARY);
     _setmode(_fileno(stdout), _O_BINARY);
 #endif
 
@@ -128,69 +495,51 @@ int main(int argc, char **argv) {
     const int audio_buffer_size = (int)Faudio;
     const int decoder_block_size = 1024;
 
-    auto app = App(
-        fp_in, demod_block_size, 
-        decoder_block_size, ds_factor, us_factor, 
-        audio_buffer_size, Faudio);
+    if (!channel_offsets.empty()) {
+        auto app = MultiChannelApp(
+            std::move(rx_reader), demod_block_size, 
+            decoder_block_size, ds_factor, us_factor, 
+            audio_buffer_size, Faudio, 
+            channel_offsets, nb_threads);
+        SetupSpecification(app.qam_sync_spec, Fsample, Fsymbol, ds_factor, us_factor, pll_block_size, is_gardner, is_squelch, squelch_threshold, is_preamble_seed, is_carrier_estimator);
 
-    {
-        const float PI = 3.1415f;
-        auto& spec = app.qam_sync_spec;
-        spec.f_sample = Fsample; 
-        spec.f_symbol = Fsymbol;
-        
-        spec.downsampling_filter.M = ds_factor;
-        spec.downsampling_filter.K = 6;
-
-        spec.upsampling_filter.L = us_factor;
-        spec.upsampling_filter.K = 6;
-
-        spec.ac_filter.k = 0.99999f;
-        spec.agc.beta = 0.2f;
-        spec.agc.initial_gain = 0.1f;
-        spec.carrier_pll.f_center = 0e3;
-        spec.carrier_pll.f_gain = 2.5e3;
-        spec.carrier_pll.phase_error_gain = 8.0f/PI;
-        spec.carrier_pll_filter.butterworth_cutoff = 5e3;
-        spec.carrier_pll_filter.integrator_gain = 1000.0f;
-        spec.ted_pll.f_gain = 30e3;
-        spec.ted_pll.f_offset = 0e3;
-        spec.ted_pll.phase_error_gain = 1.0f;
-        spec.ted_pll_filter.butterworth_cutoff = 60e3;
-        spec.ted_pll_filter.integrator_gain = 250.0f;
-    }
+        const int nb_channels = app.GetTotalChannels();
+        for (int i = 0; i < nb_channels; i++) {
+            app.GetFrameHandler(i).is_output_audio = is_output_audio;
+        }
 
-    // Setup audio
-    auto pa_handler = ScopedPaHandler();
-    PaDeviceList pa_devices;
-    PortAudio_Output pa_output;
-    std::unique_ptr<Resampled_PCM_Player> pcm_player;
-    {
-        auto& mixer = pa_output.GetMixer();
-        auto buf = mixer.CreateManagedBuffer(4);
-        auto Fs = pa_output.GetSampleRate();
-        pcm_player = std::make_unique<Resampled_PCM_Player>(buf, Fs);
+        if (is_batch) {
+            std::vector<BatchChannel> channels;
+            for (int i = 0; i < nb_channels; i++) {
+                char label[64];
+                snprintf(label, sizeof(label), "[%d] %.0fHz", i, app.GetChannelOffset(i));
+                channels.push_back({ label, app.GetFrameHandler(i), app.GetAudioFilter(i) });
+            }
+            return RunBatch(app, channels, Fsample, output_gain, payload_filename, pcm_filename);
+        }
 
-        #ifdef _WIN32
-        const auto target_host_api_index = Pa_HostApiTypeIdToHostApiIndex(PORTAUDIO_TARGET_HOST_API_ID);
-        const auto target_device_index = Pa_GetHostApiInfo(target_host_api_index)->defaultOutputDevice;
-        pa_output.Open(target_device_index);
-        #else
-        pa_output.Open(Pa_GetDefaultOutputDevice());
-        #endif
+        for (int i = 1; i < nb_channels; i++) {
+            app.GetFrameHandler(i).is_output_audio = false;
+        }
+        return RunAudio(app, app.GetAudioFilter(0), Faudio, output_gain);
     }
 
-    pa_output.GetMixer().GetOutputGain() = (float)audio_gain / 100.0f;
+    // There is no gui so the demodulator doesn't need to write telemetry
+    const bool is_telemetry = false;
+    auto app = App(
+        std::move(rx_reader), demod_block_size, 
+        decoder_block_size, ds_factor, us_factor, 
+        audio_buffer_size, Faudio, is_telemetry);
+    SetupSpecification(app.qam_sync_spec, Fsample, Fsymbol, ds_factor, us_factor, pll_block_size, is_gardner, is_squelch, squelch_threshold, is_preamble_seed, is_carrier_estimator);
 
     app.GetFrameHandler().is_output_audio = is_output_audio;
+    app.is_pipelined = is_pipelined;
 
-    app.GetAudioFilter().OnOutputBlock().Attach([&pcm_player, Faudio](tcb::span<const Frame<float>> data) {
-        pcm_player->SetInputSampleRate((int)Faudio);
-        pcm_player->ConsumeBuffer(data);
-    });
-    
-    app.BuildDemodulator();
-    app.Run();
+    if (is_batch) {
+        std::vector<BatchChannel> channels;
+        channels.push_back({ "", app.GetFrameHandler(), app.GetAudioFilter() });
+        return RunBatch(app, channels, Fsample, output_gain, payload_filename, pcm_filename);
+    }
 
-    return 0;
+    return RunAudio(app, app.GetAudioFilter(), Faudio, output_gain);
 }
@@ -0,0 +1,1371 @@
+// Benchmark the dsp kernels, filters, demodulator and decoder
+// Each benchmark is run over a set of block sizes and we report throughput as
+// - samples/s: Number of samples processed per second
+// - ns/sample: Average time to process a single sample
+// Results can also be written out as json so we can track regressions between releases
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include <complex>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <functional>
+
+#include "dsp/simd/simd_config.h"
+#include "dsp/simd/f32_cum_mul.h"
+#include "dsp/simd/c32_f32_cum_mul.h"
+#include "dsp/simd/c8_f32_cum_mul.h"
+#include "dsp/simd/c8_to_c32.h"
+#include "dsp/simd/c32_mul.h"
+#include "dsp/simd/apply_harmonic_pll.h"
+#include "dsp/simd/c32_slice_square.h"
+#include "dsp/simd/c32_conj_cum_mul.h"
+#include "dsp/simd/c32_ac_couple.h"
+#include "dsp/simd/c32_gain_ramp.h"
+
+#include "dsp/fir_filter.h"
+#include "dsp/fft_fir_filter.h"
+#include "dsp/iir_filter.h"
+#include "dsp/biquad_filter.h"
+#include "dsp/agc.h"
+#include "dsp/polyphase_filter.h"
+#include "dsp/filter_designer.h"
+#include "dsp/calculate_fft.h"
+#include "dsp/channeliser.h"
+#include "dsp/pfb_channeliser.h"
+
+#include "demodulator/qam_sync.h"
+#include "demodulator/qam_sync_buffers.h"
+#include "constellation/constellation.h"
+
+#include "decoder/frame_decoder.h"
+#include "decoder/viterbi_decoder.h"
+#include "decoder/phil_karn_viterbi_decoder.h"
+#include "decoder/convolutional_encoder.h"
+#include "decoder/additive_scrambler.h"
+#include "decoder/crc8.h"
+
+#include "utility/aligned_vector.h"
+#include "utility/lru_cache.h"
+#include "utility/getopt/getopt.h"
+
+// Same parameters as our transmitter
+constexpr uint8_t CONV_POLY[CODE_RATE] = { 0b111, 0b101 };
+constexpr uint32_t PREAMBLE_CODE = 0b11111001101011111100110101101101;
+constexpr uint16_t SCRAMBLER_CODE = 0b1000010101011001;
+constexpr uint8_t CRC8_POLY = 0xD5;
+
+// Prevent the compiler from optimising away our benchmarks
+static volatile float bench_sink = 0.0f;
+// Benchmarks on a fixed input check their output before they are timed
+static int total_failed_checks = 0;
+
+void usage() {
+    fprintf(stderr,
+        "receiver_bench, measures the throughput of the receiver's dsp and decoder\n\n"
+        "\t[-b block size (default: 256,1024,4096,16384)]\n"
+        "\t    Can be provided multiple times\n"
+        "\t[-t minimum time per benchmark in seconds (default: 0.25)]\n"
+        "\t[-f only run benchmarks whose name contains this string (default: None)]\n"
+        "\t[-j json output filename (default: None)]\n"
+        "\t    If '-' is provided then stdout is used\n"
+        "\t[-l list benchmarks]\n"
+        "\t[-c run self checks against reference implementations then exit]\n"
+        "\t[-h (show usage)]\n"
+    );
+}
+
+// A benchmark creates its state for a given block size outside of the timed region
+// It returns a function which processes a single block
+struct Benchmark {
+    std::string name;
+    const char* unit;
+    std::function<std::function<void()>(const int block_size)> create;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    std::string unit;
+    int block_size;
+    int64_t iterations;
+    double seconds;
+    double samples_per_second;
+    double ns_per_sample;
+};
+
+BenchmarkResult RunBenchmark(const Benchmark& bench, const int block_size, const double min_time);
+std::vector<Benchmark> CreateBenchmarks();
+void WriteJSON(FILE* fp, const std::vector<BenchmarkResult>& results);
+const char* GetSIMDName();
+// return the number of failed checks
+int RunSelfChecks();
+
+int main(int argc, char** argv) {
+    std::vector<int> block_sizes;
+    double min_time = 0.25;
+    const char* filter = NULL;
+    const char* json_filename = NULL;
+    bool is_list = false;
+    bool is_self_check = false;
+
+    int opt;
+    while ((opt = getopt_custom(argc, argv, "b:t:f:j:lch")) != -1) {
+        switch (opt) {
+        case 'b':
+            {
+                const int block_size = (int)(atof(optarg));
+                if (block_size <= 0) {
+                    fprintf(stderr, "Block size must be positive (%d)\n", block_size);
+                    return 1;
+                }
+                block_sizes.push_back(block_size);
+            }
+            break;
+        case 't':
+            min_time = atof(optarg);
+            if (min_time <= 0) {
+                fprintf(stderr, "Benchmark time must be positive (%.2f)\n", min_time);
+                return 1;
+            }
+            break;
+        case 'f':
+            filter = optarg;
+            break;
+        case 'j':
+            json_filename = optarg;
+            break;
+        case 'l':
+            is_list = true;
+            break;
+        case 'c':
+            is_self_check = true;
+            break;
+        case 'h':
+        default:
+            usage();
+            return 0;
+        }
+    }
+
+    if (is_self_check) {
+        const int total_failed = RunSelfChecks();
+        return (total_failed > 0) ? 1 : 0;
+    }
+
+    if (block_sizes.empty()) {
+        block_sizes = { 256, 1024, 4096, 16384 };
+    }
+
+    const auto benchmarks = CreateBenchmarks();
+    if (is_list) {
+        for (auto& bench: benchmarks) {
+            fprintf(stdout, "%s\n", bench.name.c_str());
+        }
+        return 0;
+    }
+
+    FILE* fp_json = NULL;
+    if (json_filename != NULL) {
+        if (strncmp(json_filename, "-", 2) == 0) {
+            fp_json = stdout;
+        } else {
+            fp_json = fopen(json_filename, "w");
+            if (fp_json == NULL) {
+                fprintf(stderr, "Failed to open file: %s\n", json_filename);
+                return 1;
+            }
+        }
+    }
+
+    // NOTE: If json is written to stdout then the table is only written to stderr
+    FILE* fp_table = (fp_json == stdout) ? stderr : stdout;
+    fprintf(fp_table, "simd=%s\n", GetSIMDName());
+    fprintf(fp_table, "%-40s %10s %12s %16s %12s\n", "name", "block", "iterations", "samples/s", "ns/sample");
+
+    std::vector<BenchmarkResult> results;
+    for (auto& bench: benchmarks) {
+        if ((filter != NULL) && (strstr(bench.name.c_str(), filter) == NULL)) {
+            continue;
+        }
+        for (const int block_size: block_sizes) {
+            auto res = RunBenchmark(bench, block_size, min_time);
+            fprintf(fp_table, "%-40s %10d %12lld %16.4e %12.3f\n",
+                res.name.c_str(), res.block_size, (long long)res.iterations,
+                res.samples_per_second, res.ns_per_sample);
+            fflush(fp_table);
+            results.push_back(std::move(res));
+        }
+    }
+
+    if (fp_json != NULL) {
+        WriteJSON(fp_json, results);
+        if (fp_json != stdout) {
+            fclose(fp_json);
+        }
+    }
+
+    if (total_failed_checks > 0) {
+        fprintf(stderr, "%d benchmarks failed their output check\n", total_failed_checks);
+        return 1;
+    }
+    return 0;
+}
+
+BenchmarkResult RunBenchmark(const Benchmark& bench, const int block_size, const double min_time) {
+    using clock = std::chrono::steady_clock;
+    auto process_block = bench.create(block_size);
+
+    // warm up caches and branch predictors
+    process_block();
+
+    // NOTE: We only check the time every few blocks so that small blocks aren't dominated by the clock
+    int64_t iterations = 0;
+    int64_t iterations_per_check = 1;
+    double elapsed = 0.0;
+    const auto t_start = clock::now();
+    while (elapsed < min_time) {
+        for (int64_t i = 0; i < iterations_per_check; i++) {
+            process_block();
+        }
+        iterations += iterations_per_check;
+        elapsed = std::chrono::duration<double>(clock::now() - t_start).count();
+        if (elapsed < (min_time*0.01)) {
+            iterations_per_check *= 2;
+        }
+    }
+
+    const double total_samples = (double)iterations * (double)block_size;
+
+    BenchmarkResult res;
+    res.name = bench.name;
+    res.unit = bench.unit;
+    res.block_size = block_size;
+    res.iterations = iterations;
+    res.seconds = elapsed;
+    res.samples_per_second = total_samples / elapsed;
+    res.ns_per_sample = (elapsed * 1e9) / total_samples;
+    return res;
+}
+
+void WriteJSON(FILE* fp, const std::vector<BenchmarkResult>& results) {
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"simd\": \"%s\",\n", GetSIMDName());
+    fprintf(fp, "  \"benchmarks\": [\n");
+    const int N = (int)results.size();
+    for (int i = 0; i < N; i++) {
+        auto& res = results[i];
+        fprintf(fp,
+            "    {\"name\": \"%s\", \"unit\": \"%s\", \"block_size\": %d, \"iterations\": %lld, "
+            "\"seconds\": %.6f, \"samples_per_second\": %.6e, \"ns_per_sample\": %.6f}%s\n",
+            res.name.c_str(), res.unit.c_str(), res.block_size, (long long)res.iterations,
+            res.seconds, res.samples_per_second, res.ns_per_sample,
+            (i == (N-1)) ? "" : ",");
+    }
+    fprintf(fp, "  ]\n");
+    fprintf(fp, "}\n");
+}
+
+const char* GetSIMDName() {
+    #if defined(_DSP_AVX2) && defined(_DSP_FMA)
+    return "avx2+fma";
+    #elif defined(_DSP_AVX2)
+    return "avx2";
+    #elif defined(_DSP_SSSE3)
+    return "ssse3";
+    #else
+    return "scalar";
+    #endif
+}
+
+// Generate a stream of encoded frames in the same format as our transmitter
+// preamble + scrambled(fec(length + payload + crc8 + trellis terminator))
+class TestSignal
+{
+public:
+    int nb_frames;
+    std::vector<uint8_t> encoded_bytes;     // fec output without preamble or scrambling
+    std::vector<uint8_t> frame_bytes;       // what is transmitted
+    std::vector<std::complex<float>> symbols;
+    std::vector<std::complex<uint8_t>> raw_iq;
+public:
+    TestSignal(ConstellationSpecification& constellation, const int _nb_frames, const int payload_size, const int samples_per_symbol)
+    : nb_frames(_nb_frames)
+    {
+        auto enc = ConvolutionalEncoder(CONV_POLY);
+        auto scrambler = AdditiveScrambler(SCRAMBLER_CODE);
+        auto crc8_calc = CRC8_Calculator(CRC8_POLY);
+
+        // pseudorandom payload
+        uint32_t lcg = 0x12345678;
+        std::vector<uint8_t> payload(payload_size);
+
+        for (int i = 0; i < nb_frames; i++) {
+            for (auto& x: payload) {
+                lcg = lcg*1664525u + 1013904223u;
+                x = (uint8_t)(lcg >> 24);
+            }
+
+            enc.reset();
+            scrambler.reset();
+            push_big_endian(frame_bytes, PREAMBLE_CODE);
+
+            const size_t offset = frame_bytes.size();
+            auto push_encoded = [this, &enc](uint8_t x) {
+                const uint16_t y = enc.consume_byte(x);
+                push_big_endian(encoded_bytes, y);
+                push_big_endian(frame_bytes, y);
+            };
+
+            const uint16_t length = (uint16_t)payload_size;
+            auto length_addr = reinterpret_cast<const uint8_t*>(&length);
+            for (int j = 0; j < (int)sizeof(length); j++) {
+                push_encoded(length_addr[j]);
+            }
+            for (auto& x: payload) {
+                push_encoded(x);
+            }
+            push_encoded(crc8_calc.process(payload.data(), payload_size));
+            push_encoded(0x00);
+
+            for (size_t j = offset; j < frame_bytes.size(); j++) {
+                frame_bytes[j] = scrambler.process(frame_bytes[j]);
+            }
+        }
+
+        // 16QAM with 2 symbols per byte
+        // NOTE: The constellation is indexed by position along each axis
+        static const uint8_t gray_code[4] = {0b00, 0b01, 0b11, 0b10};
+        auto* C = constellation.GetSymbols();
+        for (auto x: frame_bytes) {
+            for (int shift = 4; shift >= 0; shift -= 4) {
+                const uint8_t I = gray_code[(x >> (shift+2)) & 0b11];
+                const uint8_t Q = gray_code[(x >> shift) & 0b11];
+                symbols.push_back(C[I*4 + Q]);
+                const auto IQ = std::complex<uint8_t>(I*64 + 32, Q*64 + 32);
+                for (int k = 0; k < samples_per_symbol; k++) {
+                    raw_iq.push_back(IQ);
+                }
+            }
+        }
+    }
+private:
+    template <typename T>
+    static void push_big_endian(std::vector<uint8_t>& x, T y) {
+        auto y_addr = reinterpret_cast<const uint8_t*>(&y);
+        const int N = (int)sizeof(y);
+        for (int i = 0; i < N; i++) {
+            x.push_back(y_addr[N-1-i]);
+        }
+    }
+};
+
+// Count the payloads decoded from a stream of symbols in a window which starts a while after the first one
+// This lets the loops lock on and settle before we check that every frame after that is decoded
+// NOTE: The window is offset by half a frame so a slipped symbol doesn't move a frame across its edges
+class PayloadCounter
+{
+private:
+    FrameDecoder decoder;
+    const int64_t window_offset;
+    const int64_t window_length;
+    int64_t window_start = -1;
+    int64_t total_symbols = 0;
+    int total_payloads = 0;
+public:
+    PayloadCounter(ConstellationSpecification& constellation, const int frame_length, const int nb_settle_frames, const int nb_frames)
+    : decoder(1024, constellation, PREAMBLE_CODE, SCRAMBLER_CODE, CONV_POLY, CRC8_POLY),
+      window_offset((int64_t)frame_length*nb_settle_frames - frame_length/2),
+      window_length((int64_t)frame_length*nb_frames) {}
+
+    void Process(tcb::span<const std::complex<float>> x) {
+        for (const auto& ev: decoder.ProcessBlock(x)) {
+            if (ev.result != FrameDecoder::ProcessResult::PAYLOAD_OK) {
+                continue;
+            }
+            const int64_t position = total_symbols + (int64_t)ev.symbol_index;
+            if (window_start < 0) {
+                window_start = position + window_offset;
+            } else if ((position > window_start) && (position <= (window_start + window_length))) {
+                total_payloads++;
+            }
+        }
+        total_symbols += (int64_t)x.size();
+    }
+
+    bool IsFinished() const { return (window_start >= 0) && (total_symbols > (window_start + window_length)); }
+    int GetTotalPayloads() const { return total_payloads; }
+};
+
+static void CheckPayloads(const std::string& name, const int block_size, const int total_payloads, const int expected) {
+    if (total_payloads == expected) {
+        return;
+    }
+    fprintf(stderr, "Check failed for %s with block size %d: decoded %d payloads but expected %d\n", 
+        name.c_str(), block_size, total_payloads, expected);
+    total_failed_checks++;
+}
+
+// Copy the next block of the looped signal
+template <typename T>
+class LoopedReader
+{
+private:
+    const std::vector<T>& x;
+    size_t index = 0;
+public:
+    LoopedReader(const std::vector<T>& _x): x(_x) {}
+    void Read(T* y, const int N) {
+        for (int i = 0; i < N; i++) {
+            y[i] = x[index];
+            index = (index+1) % x.size();
+        }
+    }
+};
+
+template <typename T>
+static void FillRandom(T* x, const int N, uint32_t seed) {
+    for (int i = 0; i < N; i++) {
+        seed = seed*1664525u + 1013904223u;
+        const float I = (float)(seed >> 8) / (float)(1 << 24) - 0.5f;
+        seed = seed*1664525u + 1013904223u;
+        const float Q = (float)(seed >> 8) / (float)(1 << 24) - 0.5f;
+        if constexpr(std::is_same<T, float>::value) {
+            x[i] = I;
+        } else {
+            x[i] = T(I, Q);
+        }
+    }
+}
+
+// Benchmark a cumulative multiply kernel over a block
+#define BENCH_CUM_MUL(NAME, KERNEL, X_TYPE)                         \
+Benchmark { NAME, "samples", [](const int N) {                      \
+    auto x0 = std::make_shared<AlignedVector<X_TYPE>>(N);           \
+    auto x1 = std::make_shared<AlignedVector<float>>(N);            \
+    FillRandom(x0->data(), N, 1);                                   \
+    FillRandom(x1->data(), N, 2);                                   \
+    return [x0, x1, N]() {                                          \
+        const auto y = KERNEL(x0->data(), x1->data(), N);           \
+        bench_sink = bench_sink + std::abs(y);                      \
+    };                                                              \
+}}
+
+#define BENCH_C8_CUM_MUL(NAME, KERNEL)                              \
+Benchmark { NAME, "samples", [](const int N) {                      \
+    auto x0 = std::make_shared<AlignedVector<std::complex<uint8_t>>>(N); \
+    auto x1 = std::make_shared<AlignedVector<float>>(N);            \
+    for (int i = 0; i < N; i++) {                                   \
+        (*x0)[i] = std::complex<uint8_t>(i & 0xFF, (i*7) & 0xFF);   \
+    }                                                               \
+    FillRandom(x1->data(), N, 2);                                   \
+    return [x0, x1, N]() {                                          \
+        const auto y = KERNEL(x0->data(), x1->data(), N);           \
+        bench_sink = bench_sink + std::abs(y);                      \
+    };                                                              \
+}}
+
+#define BENCH_HARMONIC_PLL(NAME, KERNEL)                            \
+Benchmark { NAME, "samples", [](const int N) {                      \
+    auto dt = std::make_shared<AlignedVector<float>>(N);            \
+    auto x = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    auto y = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    for (int i = 0; i < N; i++) {                                   \
+        (*dt)[i] = (float)i * 1e-6f;                                \
+    }                                                               \
+    FillRandom(x->data(), N, 1);                                    \
+    return [dt, x, y, N]() {                                        \
+        KERNEL(dt->data(), x->data(), y->data(), N, 2e3f, 0.1f);    \
+        bench_sink = bench_sink + y->data()[N-1].real();            \
+    };                                                              \
+}}
+
+// Elementwise complex multiply using the register level kernels
+static void c32_mul_block_scalar(const std::complex<float>* x0, const std::complex<float>* x1, std::complex<float>* y, const int N) {
+    for (int i = 0; i < N; i++) {
+        y[i] = x0[i] * x1[i];
+    }
+}
+
+#if defined(_DSP_SSSE3)
+static void c32_mul_block_ssse3(const std::complex<float>* x0, const std::complex<float>* x1, std::complex<float>* y, const int N) {
+    constexpr int K = 2;
+    const int M = N/K;
+    for (int i = 0; i < M; i++) {
+        __m128 a0 = _mm_load_ps(reinterpret_cast<const float*>(&x0[i*K]));
+        __m128 a1 = _mm_load_ps(reinterpret_cast<const float*>(&x1[i*K]));
+        _mm_store_ps(reinterpret_cast<float*>(&y[i*K]), c32_mul_ssse3(a0, a1));
+    }
+    const int N_vector = M*K;
+    c32_mul_block_scalar(&x0[N_vector], &x1[N_vector], &y[N_vector], N-N_vector);
+}
+#endif
+
+#if defined(_DSP_AVX2)
+static void c32_mul_block_avx2(const std::complex<float>* x0, const std::complex<float>* x1, std::complex<float>* y, const int N) {
+    constexpr int K = 4;
+    const int M = N/K;
+    for (int i = 0; i < M; i++) {
+        __m256 a0 = _mm256_load_ps(reinterpret_cast<const float*>(&x0[i*K]));
+        __m256 a1 = _mm256_load_ps(reinterpret_cast<const float*>(&x1[i*K]));
+        _mm256_store_ps(reinterpret_cast<float*>(&y[i*K]), c32_mul_avx2(a0, a1));
+    }
+    const int N_vector = M*K;
+    c32_mul_block_scalar(&x0[N_vector], &x1[N_vector], &y[N_vector], N-N_vector);
+}
+#endif
+
+#define BENCH_C32_MUL(NAME, KERNEL)                                 \
+Benchmark { NAME, "samples", [](const int N) {                      \
+    auto x0 = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    auto x1 = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    auto y = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    FillRandom(x0->data(), N, 1);                                   \
+    FillRandom(x1->data(), N, 2);                                   \
+    return [x0, x1, y, N]() {                                       \
+        KERNEL(x0->data(), x1->data(), y->data(), N);               \
+        bench_sink = bench_sink + y->data()[N-1].real();            \
+    };                                                              \
+}}
+
+#define BENCH_C8_TO_C32(NAME, KERNEL)                               \
+Benchmark { NAME, "samples", [](const int N) {                      \
+    auto x = std::make_shared<AlignedVector<std::complex<uint8_t>>>(N); \
+    auto y = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    for (int i = 0; i < N; i++) {                                   \
+        (*x)[i] = std::complex<uint8_t>(i & 0xFF, (i*7) & 0xFF);    \
+    }                                                               \
+    return [x, y, N]() {                                            \
+        KERNEL(x->data(), y->data(), N);                            \
+        bench_sink = bench_sink + y->data()[N-1].real();            \
+    };                                                              \
+}}
+
+// Slice noisy 16QAM symbols using the gray code lookup of a square constellation
+#define BENCH_C32_SLICE_SQUARE(NAME, KERNEL)                        \
+Benchmark { NAME, "symbols", [](const int N) {                      \
+    constexpr int L = 4;                                            \
+    const uint8_t lut[L*L] = {                                      \
+        0b0000, 0b0001, 0b0011, 0b0010,                             \
+        0b0100, 0b0101, 0b0111, 0b0110,                             \
+        0b1100, 0b1101, 0b1111, 0b1110,                             \
+        0b1000, 0b1001, 0b1011, 0b1010,                             \
+    };                                                              \
+    auto x = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    auto y = std::make_shared<AlignedVector<uint8_t>>(N);           \
+    FillRandom(x->data(), N, 1);                                    \
+    return [x, y, N, lut]() {                                       \
+        KERNEL(x->data(), y->data(), N, 1.5f, L, lut);              \
+        bench_sink = bench_sink + (float)y->data()[N-1];            \
+    };                                                              \
+}}
+
+// Correlate a sliding window against a fixed waveform like the preamble correlator
+#define BENCH_C32_CONJ_CUM_MUL(NAME, KERNEL)                        \
+Benchmark { NAME, "samples", [](const int N) {                      \
+    constexpr int W = 64;                                           \
+    auto x = std::make_shared<AlignedVector<std::complex<float>>>(N+W); \
+    auto w = std::make_shared<AlignedVector<std::complex<float>>>(W); \
+    FillRandom(x->data(), N+W, 1);                                  \
+    FillRandom(w->data(), W, 2);                                    \
+    return [x, w, N]() {                                            \
+        auto y = std::complex<float>(0,0);                          \
+        for (int i = 0; i < N; i++) {                               \
+            y += KERNEL(&x->data()[i], w->data(), W);               \
+        }                                                           \
+        bench_sink = bench_sink + y.real();                         \
+    };                                                              \
+}}
+
+#define BENCH_C32_AC_COUPLE(NAME, KERNEL)                           \
+Benchmark { NAME, "samples", [](const int N) {                      \
+    auto x = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    auto y = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    FillRandom(x->data(), N, 1);                                    \
+    return [x, y, N]() {                                            \
+        auto x_prev = std::complex<float>(0,0);                     \
+        auto y_prev = std::complex<float>(0,0);                     \
+        KERNEL(x->data(), y->data(), N, 0.9999f, x_prev, y_prev);   \
+        bench_sink = bench_sink + y_prev.real();                    \
+    };                                                              \
+}}
+
+#define BENCH_C32_GAIN_RAMP(NAME, KERNEL)                           \
+Benchmark { NAME, "samples", [](const int N) {                      \
+    auto x = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    auto y = std::make_shared<AlignedVector<std::complex<float>>>(N); \
+    FillRandom(x->data(), N, 1);                                    \
+    return [x, y, N]() {                                            \
+        KERNEL(x->data(), y->data(), N, 0.5f, 1e-4f);               \
+        bench_sink = bench_sink + y->data()[N-1].real();            \
+    };                                                              \
+}}
+
+// Benchmark the add-compare-select kernels of the viterbi decoder with soft decision bits
+#define BENCH_VITERBI_BLK(NAME, KERNEL)                             \
+Benchmark { NAME, "bits", [](const int N) {                         \
+    struct State {                                                  \
+        vitdec_t* vitdec;                                           \
+        std::vector<int16_t> syms;                                  \
+        State(const int N): syms(N*CODE_RATE) {                     \
+            vitdec = create_viterbi(CONV_POLY, N, 127, -127);       \
+            uint32_t lcg = 1;                                       \
+            for (auto& x: syms) {                                   \
+                lcg = lcg*1664525u + 1013904223u;                   \
+                x = (int16_t)((int)(lcg >> 24) - 128);              \
+            }                                                       \
+        }                                                           \
+        ~State() { delete_viterbi(vitdec); }                        \
+    };                                                              \
+    auto state = std::make_shared<State>(N);                        \
+    return [state, N]() {                                           \
+        init_viterbi(state->vitdec, 0);                             \
+        KERNEL(state->vitdec, state->syms.data(), N);               \
+        bench_sink = bench_sink + (float)get_error_viterbi(state->vitdec, 0); \
+    };                                                              \
+}}
+
+std::vector<Benchmark> CreateBenchmarks() {
+    std::vector<Benchmark> benchmarks;
+
+    // simd kernels
+    benchmarks.push_back(BENCH_CUM_MUL("kernel/f32_cum_mul/scalar", f32_cum_mul_scalar, float));
+    #if defined(_DSP_SSSE3)
+    benchmarks.push_back(BENCH_CUM_MUL("kernel/f32_cum_mul/ssse3", f32_cum_mul_ssse3, float));
+    #endif
+    #if defined(_DSP_AVX2)
+    benchmarks.push_back(BENCH_CUM_MUL("kernel/f32_cum_mul/avx2", f32_cum_mul_avx2, float));
+    #endif
+
+    benchmarks.push_back(BENCH_CUM_MUL("kernel/c32_f32_cum_mul/scalar", c32_f32_cum_mul_scalar, std::complex<float>));
+    #if defined(_DSP_SSSE3)
+    benchmarks.push_back(BENCH_CUM_MUL("kernel/c32_f32_cum_mul/ssse3", c32_f32_cum_mul_ssse3, std::complex<float>));
+    #endif
+    #if defined(_DSP_AVX2)
+    benchmarks.push_back(BENCH_CUM_MUL("kernel/c32_f32_cum_mul/avx2", c32_f32_cum_mul_avx2, std::complex<float>));
+    #endif
+
+    benchmarks.push_back(BENCH_C8_CUM_MUL("kernel/c8_f32_cum_mul/scalar", c8_f32_cum_mul_scalar));
+    #if defined(_DSP_SSSE3)
+    benchmarks.push_back(BENCH_C8_CUM_MUL("kernel/c8_f32_cum_mul/ssse3", c8_f32_cum_mul_ssse3));
+    #endif
+    #if defined(_DSP_AVX2)
+    benchmarks.push_back(BENCH_C8_CUM_MUL("kernel/c8_f32_cum_mul/avx2", c8_f32_cum_mul_avx2));
+    #endif
+
+    benchmarks.push_back(BENCH_C8_TO_C32("kernel/c8_to_c32/scalar", c8_to_c32_scalar));
+    #if defined(_DSP_SSSE3)
+    benchmarks.push_back(BENCH_C8_TO_C32("kernel/c8_to_c32/ssse3", c8_to_c32_ssse3));
+    #endif
+    #if defined(_DSP_AVX2)
+    benchmarks.push_back(BENCH_C8_TO_C32("kernel/c8_to_c32/avx2", c8_to_c32_avx2));
+    #endif
+
+    benchmarks.push_back(BENCH_C32_MUL("kernel/c32_mul/scalar", c32_mul_block_scalar));
+    #if defined(_DSP_SSSE3)
+    benchmarks.push_back(BENCH_C32_MUL("kernel/c32_mul/ssse3", c32_mul_block_ssse3));
+    #endif
+    #if defined(_DSP_AVX2)
+    benchmarks.push_back(BENCH_C32_MUL("kernel/c32_mul/avx2", c32_mul_block_avx2));
+    #endif
+
+    benchmarks.push_back(BENCH_HARMONIC_PLL("kernel/apply_harmonic_pll/scalar", apply_harmonic_pll_scalar));
+    #if defined(_DSP_SSSE3)
+    benchmarks.push_back(BENCH_HARMONIC_PLL("kernel/apply_harmonic_pll/ssse3", apply_harmonic_pll_ssse3));
+    #endif
+    #if defined(_DSP_AVX2)
+    benchmarks.push_back(BENCH_HARMONIC_PLL("kernel/apply_harmonic_pll/avx2", apply_harmonic_pll_avx2));
+    #endif
+
+    benchmarks.push_back(BENCH_C32_SLICE_SQUARE("kernel/c32_slice_square/scalar", c32_slice_square_scalar));
+    #if defined(_DSP_SSSE3)
+    benchmarks.push_back(BENCH_C32_SLICE_SQUARE("kernel/c32_slice_square/ssse3", c32_slice_square_ssse3));
+    #endif
+    #if defined(_DSP_AVX2)
+    benchmarks.push_back(BENCH_C32_SLICE_SQUARE("kernel/c32_slice_square/avx2", c32_slice_square_avx2));
+    #endif
+
+    benchmarks.push_back(BENCH_C32_CONJ_CUM_MUL("kernel/c32_conj_cum_mul/W=64/scalar", c32_conj_cum_mul_scalar));
+    #if defined(_DSP_SSSE3)
+    benchmarks.push_back(BENCH_C32_CONJ_CUM_MUL("kernel/c32_conj_cum_mul/W=64/ssse3", c32_conj_cum_mul_ssse3));
+    #endif
+    #if defined(_DSP_AVX2)
+    benchmarks.push_back(BENCH_C32_CONJ_CUM_MUL("kernel/c32_conj_cum_mul/W=64/avx2", c32_conj_cum_mul_avx2));
+    #endif
+
+    benchmarks.push_back(BENCH_C32_AC_COUPLE("kernel/c32_ac_couple/scalar", c32_ac_couple_scalar));
+    #if defined(_DSP_SSSE3)
+    benchmarks.push_back(BENCH_C32_AC_COUPLE("kernel/c32_ac_couple/ssse3", c32_ac_couple_ssse3));
+    #endif
+    #if defined(_DSP_AVX2)
+    benchmarks.push_back(BENCH_C32_AC_COUPLE("kernel/c32_ac_couple/avx2", c32_ac_couple_avx2));
+    #endif
+
+    benchmarks.push_back(BENCH_C32_GAIN_RAMP("kernel/c32_gain_ramp/scalar", c32_gain_ramp_scalar));
+    #if defined(_DSP_SSSE3)
+    benchmarks.push_back(BENCH_C32_GAIN_RAMP("kernel/c32_gain_ramp/ssse3", c32_gain_ramp_ssse3));
+    #endif
+    #if defined(_DSP_AVX2)
+    benchmarks.push_back(BENCH_C32_GAIN_RAMP("kernel/c32_gain_ramp/avx2", c32_gain_ramp_avx2));
+    #endif
+
+    // filters
+    // Direct form against overlap-save to find FFT_FIR_CROSSOVER_TAPS
+    for (const int K: { 16, 32, 64, 128, 256 }) {
+        const auto K_str = std::to_string(K);
+        benchmarks.push_back({ "filter/fir/c32/K=" + K_str, "samples", [K](const int N) {
+            auto filter = std::make_shared<FIR_Filter<std::complex<float>>>(K);
+            create_fir_lpf(filter->get_b(), K, 0.2f);
+            auto x = std::make_shared<AlignedVector<std::complex<float>>>(N);
+            auto y = std::make_shared<AlignedVector<std::complex<float>>>(N);
+            FillRandom(x->data(), N, 1);
+            return [filter, x, y, N]() {
+                filter->process(x->data(), y->data(), N);
+                bench_sink = bench_sink + y->data()[N-1].real();
+            };
+        }});
+
+        benchmarks.push_back({ "filter/fft_fir/c32/K=" + K_str, "samples", [K](const int N) {
+            auto filter = std::make_shared<FFT_FIR_Filter<std::complex<float>>>(K);
+            create_fir_lpf(filter->get_b(), K, 0.2f);
+            auto x = std::make_shared<AlignedVector<std::complex<float>>>(N);
+            auto y = std::make_shared<AlignedVector<std::complex<float>>>(N);
+            FillRandom(x->data(), N, 1);
+            return [filter, x, y, N]() {
+                filter->process(x->data(), y->data(), N);
+                bench_sink = bench_sink + y->data()[N-1].real();
+            };
+        }});
+    }
+
+    benchmarks.push_back({ "filter/polyphase_downsampler/c32/M=2,K=6", "samples", [](const int N) {
+        constexpr int M = 2, K = 6;
+        auto filter = std::make_shared<PolyphaseDownsampler<std::complex<float>>>(M, K);
+        create_fir_lpf(filter->get_b(), filter->get_K(), 0.4f);
+        auto x = std::make_shared<AlignedVector<std::complex<float>>>(N*M);
+        auto y = std::make_shared<AlignedVector<std::complex<float>>>(N);
+        FillRandom(x->data(), N*M, 1);
+        // NOTE: Throughput is measured at the input sample rate
+        return [filter, x, y, N, M]() {
+            filter->process(x->data(), y->data(), N/M);
+            bench_sink = bench_sink + y->data()[0].real();
+        };
+    }});
+
+    benchmarks.push_back({ "filter/polyphase_downsampler/c8/M=2,K=6", "samples", [](const int N) {
+        constexpr int M = 2, K = 6;
+        const auto x0 = std::complex<uint8_t>(128, 128);
+        auto filter = std::make_shared<PolyphaseDownsampler<std::complex<float>, std::complex<uint8_t>>>(M, K, x0);
+        create_fir_lpf(filter->get_b(), filter->get_K(), 0.4f);
+        auto x = std::make_shared<AlignedVector<std::complex<uint8_t>>>(N);
+        auto y = std::make_shared<AlignedVector<std::complex<float>>>(N);
+        for (int i = 0; i < N; i++) {
+            (*x)[i] = std::complex<uint8_t>(i & 0xFF, (i*7) & 0xFF);
+        }
+        return [filter, x, y, N, M]() {
+            filter->process(x->data(), y->data(), N/M);
+            bench_sink = bench_sink + y->data()[0].real();
+        };
+    }});
+
+    benchmarks.push_back({ "filter/polyphase_upsampler/c32/L=4,K=6", "samples", [](const int N) {
+        constexpr int L = 4, K = 6;
+        std::vector<float> b(L*K);
+        create_fir_lpf(b.data(), L*K, 0.2f);
+        auto filter = std::make_shared<PolyphaseUpsampler<std::complex<float>>>(b.data(), L, K);
+        auto x = std::make_shared<AlignedVector<std::complex<float>>>(N);
+        auto y = std::make_shared<AlignedVector<std::complex<float>>>(N*L);
+        FillRandom(x->data(), N, 1);
+        // NOTE: Throughput is measured at the input sample rate
+        return [filter, x, y, N]() {
+            filter->process(x->data(), y->data(), N);
+            bench_sink = bench_sink + y->data()[0].real();
+        };
+    }});
+
+    benchmarks.push_back({ "filter/fft/c32/N=256", "samples", [](const int N) {
+        constexpr int N_fft = 256;
+        auto x = std::make_shared<AlignedVector<std::complex<float>>>(N);
+        FillRandom(x->data(), N, 1);
+        return [x, N]() {
+            auto block = tcb::span(x->data(), N);
+            for (int i = 0; (i+N_fft) <= N; i += N_fft) {
+                auto y = block.subspan(i, N_fft);
+                CalculateFFT(y, y);
+            }
+            bench_sink = bench_sink + x->data()[0].real();
+        };
+    }});
+
+    benchmarks.push_back({ "filter/fft/f32/N=256", "samples", [](const int N) {
+        constexpr int N_fft = 256;
+        auto x = std::make_shared<AlignedVector<float>>(N);
+        auto y = std::make_shared<AlignedVector<std::complex<float>>>(N_fft/2+1);
+        FillRandom(x->data(), N, 1);
+        return [x, y, N]() {
+            auto& plan = GetRealFFTPlan(N_fft);
+            for (int i = 0; (i+N_fft) <= N; i += N_fft) {
+                plan.Forward(&x->data()[i], y->data());
+            }
+            bench_sink = bench_sink + y->data()[0].real();
+        };
+    }});
+
+    // NOTE: Both channelisers extract 8 channels spaced Fs/8 apart and decimated by 4 with 48 tap filters
+    //       Throughput is measured at the wideband sample rate
+    benchmarks.push_back({ "filter/channeliser/nco/8_channels", "samples", [](const int N) {
+        constexpr int D = 4, K = 12, TOTAL_CHANNELS = 8;
+        std::vector<std::shared_ptr<NCO_Channeliser>> channelisers;
+        for (int i = 0; i < TOTAL_CHANNELS; i++) {
+            const float f = (float)(i - TOTAL_CHANNELS/2) / (float)TOTAL_CHANNELS;
+            channelisers.push_back(std::make_shared<NCO_Channeliser>(f, D, K, 1.0f/(float)TOTAL_CHANNELS, N/D));
+        }
+        auto x = std::make_shared<AlignedVector<std::complex<float>>>(N);
+        auto y = std::make_shared<AlignedVector<std::complex<float>>>(N/D);
+        FillRandom(x->data(), N, 1);
+        return [channelisers, x, y, N, D]() {
+            for (auto& channeliser: channelisers) {
+                channeliser->process(x->data(), y->data(), N/D);
+            }
+            bench_sink = bench_sink + y->data()[0].real();
+        };
+    }});
+
+    benchmarks.push_back({ "filter/channeliser/pfb/8_channels", "samples", [](const int N) {
+        constexpr int M = 8, D = 4, K = 6;
+        auto channeliser = std::make_shared<PFB_Channeliser>(M, D, K, 1.0f/(float)M, N/D);
+        auto x = std::make_shared<AlignedVector<std::complex<float>>>(N);
+        auto y = std::make_shared<AlignedVector<std::complex<float>>>(M*(N/D));
+        auto y_channels = std::make_shared<std::vector<std::complex<float>*>>(M);
+        for (int i = 0; i < M; i++) {
+            (*y_channels)[i] = &y->data()[i*(N/D)];
+        }
+        FillRandom(x->data(), N, 1);
+        return [channeliser, x, y, y_channels, N, D]() {
+            channeliser->process(x->data(), y_channels->data(), N/D);
+            bench_sink = bench_sink + y->data()[0].real();
+        };
+    }});
+
+    benchmarks.push_back({ "filter/iir/c32/ac_coupling", "samples", [](const int N) {
+        auto filter = std::make_shared<IIR_Filter<std::complex<float>>>(TOTAL_TAPS_IIR_AC_COUPLE);
+        create_iir_ac_filter(filter->get_b(), filter->get_a(), 0.9999f);
+        auto x = std::make_shared<AlignedVector<std::complex<float>>>(N);
+        auto y = std::make_shared<AlignedVector<std::complex<float>>>(N);
+        FillRandom(x->data(), N, 1);
+        return [filter, x, y, N]() {
+            filter->process(x->data(), y->data(), N);
+            bench_sink = bench_sink + y->data()[N-1].real();
+        };
+    }});
+
+    // Gain updated once per block against once every 256 samples
+    for (const int B: { 0, 256 }) {
+        benchmarks.push_back({ "filter/agc/c32/B=" + std::to_string(B), "samples", [B](const int N) {
+            auto filter = std::make_shared<AGC_Filter<std::complex<float>>>();
+            filter->block_size = B;
+            auto x = std::make_shared<AlignedVector<std::complex<float>>>(N);
+            auto y = std::make_shared<AlignedVector<std::complex<float>>>(N);
+            FillRandom(x->data(), N, 1);
+            return [filter, x, y, N]() {
+                filter->process(x->data(), y->data(), N);
+                bench_sink = bench_sink + y->data()[N-1].real();
+            };
+        }});
+    }
+
+    benchmarks.push_back({ "filter/iir/f32/notch", "samples", [](const int N) {
+        auto filter = std::make_shared<IIR_Filter<float>>(TOTAL_TAPS_IIR_SECOND_ORDER_NOTCH_FILTER);
+        create_iir_notch_filter(filter->get_b(), filter->get_a(), 0.01f, 0.9999f);
+        auto x = std::make_shared<AlignedVector<float>>(N);
+        auto y = std::make_shared<AlignedVector<float>>(N);
+        FillRandom(x->data(), N, 1);
+        return [filter, x, y, N]() {
+            filter->process(x->data(), y->data(), N);
+            bench_sink = bench_sink + y->data()[N-1];
+        };
+    }});
+
+    // Channels are filtered together across the simd lanes, e.g. the loop filters of several demodulators
+    // Each sample has C channels which pass through S sections
+    for (const auto& [C, S]: { std::pair{1,1}, std::pair{2,1}, std::pair{8,2}, std::pair{16,2} }) {
+        const auto name = "filter/biquad/f32/C=" + std::to_string(C) + ",S=" + std::to_string(S);
+        benchmarks.push_back({ name, "samples", [C=C, S=S](const int N) {
+            float b[TOTAL_TAPS_IIR_SECOND_ORDER_NOTCH_FILTER];
+            float a[TOTAL_TAPS_IIR_SECOND_ORDER_NOTCH_FILTER];
+            create_iir_notch_filter(b, a, 0.01f, 0.9999f);
+            auto filter = std::make_shared<Biquad_Filter_Bank>(C, S);
+            for (int s = 0; s < S; s++) {
+                filter->set_section(s, create_biquad_section(b, a, TOTAL_TAPS_IIR_SECOND_ORDER_NOTCH_FILTER));
+            }
+            auto x = std::make_shared<AlignedVector<float>>(N*C);
+            auto y = std::make_shared<AlignedVector<float>>(N*C);
+            FillRandom(x->data(), N*C, 1);
+            return [filter, x, y, N]() {
+                filter->process(x->data(), y->data(), N);
+                bench_sink = bench_sink + y->data()[N-1];
+            };
+        }});
+    }
+
+    // demodulator
+    // Table driven carrier oscillator with and without interpolation
+    for (const bool is_interpolated: { false, true }) {
+        const std::string name = is_interpolated ? "interpolated" : "truncated";
+        benchmarks.push_back({ "demod/pll_mixer/update/" + name, "samples", [is_interpolated](const int N) {
+            auto mixer = std::make_shared<PLL_mixer>();
+            mixer->Ts = 1.0f/500e3f;
+            mixer->fcenter = 1.234e3f;
+            mixer->nco = std::make_unique<NCO_Table>(90.0f, is_interpolated);
+            auto y = std::make_shared<AlignedVector<std::complex<float>>>(N);
+            return [mixer, y, N]() {
+                auto* y0 = y->data();
+                for (int i = 0; i < N; i++) {
+                    y0[i] = mixer->update();
+                }
+                bench_sink = bench_sink + y0[N-1].real();
+            };
+        }});
+    }
+
+    // NOTE: Uses the same specification as read_data
+    // Carrier pll updated every sample against once per sub-block with a vectorised oscillator
+    // Zero crossing timing recovery at 4x upsampling against gardner timing recovery without upsampling
+    // Buffers with telemetry for the gui against the headless layout
+    struct DemodConfig {
+        const char* name;
+        int pll_block_size;
+        bool is_gardner;
+        bool is_telemetry;
+        bool is_squelch;
+        bool is_idle;
+        bool is_preamble;
+    };
+    // Squelch on a carrier measures the cost of the power detector
+    // Squelch on an idle channel of noise measures how much work is skipped
+    // Preamble correlator seeding the loops measures the cost of the matched filter
+    const DemodConfig demod_configs[] = {
+        { "pll_block=1", 1, false, true, false, false, false },
+        { "pll_block=4", 4, false, true, false, false, false },
+        { "gardner", 1, true, true, false, false, false },
+        { "pll_block=1/no_telemetry", 1, false, false, false, false, false },
+        { "gardner/no_telemetry", 1, true, false, false, false, false },
+        { "pll_block=1/no_telemetry/squelch", 1, false, false, true, false, false },
+        { "pll_block=1/no_telemetry/idle", 1, false, false, false, true, false },
+        { "pll_block=1/no_telemetry/squelch/idle", 1, false, false, true, true, false },
+        { "pll_block=1/no_telemetry/preamble", 1, false, false, false, false, true },
+    };
+    for (const auto& config: demod_configs) {
+        const auto name = std::string("demod/qam_sync/process_block/") + config.name;
+        benchmarks.push_back({ name, "samples", [config, name](const int N) {
+            const float PI = 3.1415f;
+            QAM_Synchroniser_Specification spec;
+            spec.f_sample = 1e6;
+            spec.f_symbol = 200e3;
+            spec.downsampling_filter.M = 2;
+            spec.downsampling_filter.K = 6;
+            spec.upsampling_filter.L = 4;
+            spec.upsampling_filter.K = 6;
+            spec.ac_filter.k = 0.99999f;
+            spec.agc.beta = 0.2f;
+            spec.agc.initial_gain = 0.1f;
+            spec.carrier_pll.f_center = 0e3;
+            spec.carrier_pll.f_gain = 2.5e3;
+            spec.carrier_pll.phase_error_gain = 8.0f/PI;
+            spec.carrier_pll.block_size = config.pll_block_size;
+            spec.carrier_pll_filter.butterworth_cutoff = 5e3;
+            spec.carrier_pll_filter.integrator_gain = 1000.0f;
+            spec.ted_pll.f_gain = 30e3;
+            spec.ted_pll.f_offset = 0e3;
+            spec.ted_pll.phase_error_gain = 1.0f;
+            spec.ted_pll_filter.butterworth_cutoff = 60e3;
+            spec.ted_pll_filter.integrator_gain = 250.0f;
+            if (config.is_gardner) {
+                spec.timing_recovery = QAM_Synchroniser_Specification::TimingRecovery::GARDNER;
+                spec.upsampling_filter.L = 1;
+                spec.ted_pll.f_gain = 20e3;
+                spec.ted_pll_filter.butterworth_cutoff = 40e3;
+            }
+            spec.squelch.is_enabled = config.is_squelch;
+            spec.squelch.threshold_open = -20.0f;
+            spec.squelch.threshold_close = -23.0f;
+            spec.preamble.is_enabled = config.is_preamble;
+
+            const int M = spec.downsampling_filter.M;
+            const int L = spec.upsampling_filter.L;
+            const int samples_per_symbol = (int)(spec.f_sample/spec.f_symbol);
+
+            struct State {
+                SquareConstellation constellation;
+                TestSignal signal;
+                LoopedReader<std::complex<uint8_t>> reader;
+                QAM_Synchroniser_Buffer buffers;
+                QAM_Synchroniser demod;
+                State(QAM_Synchroniser_Specification& spec, const int block_size, const int M, const int L, const int samples_per_symbol, const bool is_telemetry)
+                : constellation(4),
+                  signal(constellation, 16, 100, samples_per_symbol),
+                  reader(signal.raw_iq),
+                  buffers(block_size, M, L, is_telemetry),
+                  demod(spec, constellation) {}
+            };
+
+            // NOTE: Block size is given at the input sample rate
+            auto state = std::make_shared<State>(spec, N/M, M, L, samples_per_symbol, config.is_telemetry);
+            // replace the carrier with low level noise around the zero level
+            if (config.is_idle) {
+                uint32_t lcg = 0x12345678;
+                for (auto& x: state->signal.raw_iq) {
+                    lcg = lcg*1664525u + 1013904223u;
+                    x = std::complex<uint8_t>(126 + ((lcg >> 24) & 0b11), 126 + ((lcg >> 16) & 0b11));
+                }
+            }
+
+            // Once settled every frame of the next two passes of the looped input should be decoded
+            // An idle channel shouldn't decode anything
+            // NOTE: The agc and loops adapt per block so a large block takes more passes to settle
+            {
+                constexpr int TOTAL_PASSES = 2;
+                constexpr int MAX_LOCK_BLOCKS = 32;
+                constexpr int MIN_SETTLE_BLOCKS = 8;
+                auto& buffers = state->buffers;
+                const int nb_frames = state->signal.nb_frames;
+                const int frame_length = (int)state->signal.symbols.size() / nb_frames;
+                const int frame_samples = (int)state->signal.raw_iq.size() / nb_frames;
+                const int nb_settle_frames = std::max(nb_frames, (MIN_SETTLE_BLOCKS*buffers.GetInputSize()) / frame_samples);
+                auto counter = PayloadCounter(state->constellation, frame_length, nb_settle_frames, TOTAL_PASSES*nb_frames);
+                const int64_t max_samples = 
+                    (int64_t)(MAX_LOCK_BLOCKS+MIN_SETTLE_BLOCKS)*buffers.GetInputSize() + 
+                    (int64_t)(TOTAL_PASSES+2)*(int64_t)state->signal.raw_iq.size();
+                int64_t total_samples = 0;
+                while (!counter.IsFinished() && (total_samples < max_samples)) {
+                    state->reader.Read(buffers.GetInputBuffer().data(), buffers.GetInputSize());
+                    const int nb_symbols = state->demod.ProcessBlock(buffers);
+                    counter.Process(buffers.y_out.first(nb_symbols));
+                    total_samples += buffers.GetInputSize();
+                }
+                const int expected = config.is_idle ? 0 : TOTAL_PASSES*nb_frames;
+                CheckPayloads(name, N, counter.GetTotalPayloads(), expected);
+            }
+
+            return [state]() {
+                auto& buffers = state->buffers;
+                state->reader.Read(buffers.GetInputBuffer().data(), buffers.GetInputSize());
+                const int nb_symbols = state->demod.ProcessBlock(buffers);
+                bench_sink = bench_sink + (float)nb_symbols;
+            };
+        }});
+    }
+
+    // decoder
+    benchmarks.push_back({ "decoder/frame_decoder/process", "symbols", [](const int N) {
+        struct State {
+            SquareConstellation constellation;
+            TestSignal signal;
+            LoopedReader<std::complex<float>> reader;
+            std::vector<std::complex<float>> symbols;
+            FrameDecoder decoder;
+            State(const int block_size)
+            : constellation(4),
+              signal(constellation, 16, 100, 1),
+              reader(signal.symbols),
+              symbols(block_size),
+              decoder(1024, constellation, PREAMBLE_CODE, SCRAMBLER_CODE, CONV_POLY, CRC8_POLY) {}
+        };
+
+        auto state = std::make_shared<State>(N);
+        // Every frame of the fixed input should be decoded
+        // NOTE: The decoder starts partway through a frame so the first pass isn't counted
+        {
+            int total_payloads = 0;
+            for (int pass = 0; pass < 2; pass++) {
+                total_payloads = 0;
+                for (auto& IQ: state->signal.symbols) {
+                    const auto res = state->decoder.process(IQ);
+                    total_payloads += (res == FrameDecoder::ProcessResult::PAYLOAD_OK);
+                }
+            }
+            CheckPayloads("decoder/frame_decoder/process", N, total_payloads, state->signal.nb_frames);
+        }
+        return [state, N]() {
+            state->reader.Read(state->symbols.data(), N);
+            int total_payloads = 0;
+            for (auto& IQ: state->symbols) {
+                const auto res = state->decoder.process(IQ);
+                total_payloads += (res == FrameDecoder::ProcessResult::PAYLOAD_OK);
+            }
+            bench_sink = bench_sink + (float)total_payloads;
+        };
+    }});
+
+    benchmarks.push_back({ "decoder/frame_decoder/process_block", "symbols", [](const int N) {
+        struct State {
+            SquareConstellation constellation;
+            TestSignal signal;
+            LoopedReader<std::complex<float>> reader;
+            std::vector<std::complex<float>> symbols;
+            FrameDecoder decoder;
+            State(const int block_size)
+            : constellation(4),
+              signal(constellation, 16, 100, 1),
+              reader(signal.symbols),
+              symbols(block_size),
+              decoder(1024, constellation, PREAMBLE_CODE, SCRAMBLER_CODE, CONV_POLY, CRC8_POLY) {}
+        };
+
+        auto state = std::make_shared<State>(N);
+        // Every frame of the fixed input should be decoded
+        // NOTE: The decoder starts partway through a frame so the first pass isn't counted
+        {
+            auto symbols = tcb::span<const std::complex<float>>(state->signal.symbols);
+            int total_payloads = 0;
+            for (int pass = 0; pass < 2; pass++) {
+                total_payloads = 0;
+                for (size_t i = 0; i < symbols.size(); i += (size_t)N) {
+                    const auto block = symbols.subspan(i, std::min((size_t)N, symbols.size()-i));
+                    for (const auto& ev: state->decoder.ProcessBlock(block)) {
+                        total_payloads += (ev.result == FrameDecoder::ProcessResult::PAYLOAD_OK);
+                    }
+                }
+            }
+            CheckPayloads("decoder/frame_decoder/process_block", N, total_payloads, state->signal.nb_frames);
+        }
+        return [state, N]() {
+            state->reader.Read(state->symbols.data(), N);
+            const auto events = state->decoder.ProcessBlock(state->symbols);
+            bench_sink = bench_sink + (float)events.size();
+        };
+    }});
+
+    benchmarks.push_back(BENCH_VITERBI_BLK("decoder/viterbi/update_blk/scalar", update_viterbi_blk_scalar));
+    #if defined(VITDEC_SSE2)
+    benchmarks.push_back(BENCH_VITERBI_BLK("decoder/viterbi/update_blk/sse2", update_viterbi_blk_sse2));
+    #endif
+    #if defined(VITDEC_AVX2)
+    benchmarks.push_back(BENCH_VITERBI_BLK("decoder/viterbi/update_blk/avx2", update_viterbi_blk_avx2));
+    #endif
+
+    benchmarks.push_back({ "decoder/viterbi/update", "bits", [](const int N) {
+        // NOTE: Block size is given as the number of decoded bits
+        //       Each decoded bit takes CODE_RATE encoded bits
+        const int nb_encoded_bytes = std::max(1, (N*CODE_RATE)/8);
+        const int nb_decoded_bits = (nb_encoded_bytes*8)/CODE_RATE;
+        struct State {
+            SquareConstellation constellation;
+            TestSignal signal;
+            LoopedReader<uint8_t> reader;
+            std::vector<uint8_t> encoded_bytes;
+            ViterbiDecoder vitdec;
+            State(const int nb_encoded_bytes, const int nb_decoded_bits)
+            : constellation(4),
+              signal(constellation, 16, 100, 1),
+              reader(signal.encoded_bytes),
+              encoded_bytes(nb_encoded_bytes),
+              vitdec(CONV_POLY, nb_decoded_bits) {}
+        };
+
+        auto state = std::make_shared<State>(nb_encoded_bytes, nb_decoded_bits);
+        return [state, nb_encoded_bytes]() {
+            state->reader.Read(state->encoded_bytes.data(), nb_encoded_bytes);
+            // decoder only has enough space for a single block
+            state->vitdec.Reset();
+            state->vitdec.Update(state->encoded_bytes);
+            bench_sink = bench_sink + (float)state->vitdec.GetPathError();
+        };
+    }});
+
+    return benchmarks;
+}
+
+// Self checks compare the fast implementations against direct ones
+// Errors are relative to the rms of the reference so each size has the same tolerance
+constexpr double SELF_CHECK_FFT_TOLERANCE = 1e-5;
+
+static bool ReportCheck(const char* name, const int N, const double error, const double tolerance) {
+    const bool is_pass = error <= tolerance;
+    fprintf(stdout, "%-40s %8d %12.3e %s\n", name, N, error, is_pass ? "pass" : "FAIL");
+    return is_pass;
+}
+
+// y[k] = sum x[n] e^(-+j2pi.k.n/N) in double precision
+static void ReferenceDFT(const std::complex<float>* x, std::complex<double>* y, const int N, const bool is_inverse) {
+    const double sign = is_inverse ? 1.0 : -1.0;
+    for (int k = 0; k < N; k++) {
+        std::complex<double> acc = 0.0;
+        for (int n = 0; n < N; n++) {
+            const int64_t kn = ((int64_t)k*(int64_t)n) % (int64_t)N;
+            const double phase = sign*2.0*M_PI*(double)kn/(double)N;
+            acc += std::complex<double>(x[n]) * std::complex<double>(std::cos(phase), std::sin(phase));
+        }
+        y[k] = acc;
+    }
+}
+
+template <typename T>
+static double GetRelativeError(const T* y, const std::complex<double>* y_ref, const int N) {
+    double error = 0.0;
+    double power = 0.0;
+    for (int i = 0; i < N; i++) {
+        error += std::norm(std::complex<double>(y[i]) - y_ref[i]);
+        power += std::norm(y_ref[i]);
+    }
+    return std::sqrt(error / std::max(power, 1e-30));
+}
+
+static int CheckComplexFFT(const int N) {
+    int total_failed = 0;
+    AlignedVector<std::complex<float>> x(N);
+    AlignedVector<std::complex<float>> x_copy(N);
+    AlignedVector<std::complex<float>> y(N);
+    std::vector<std::complex<double>> y_ref(N);
+    FillRandom(x.data(), N, (uint32_t)N);
+    for (int i = 0; i < N; i++) {
+        x_copy[i] = x[i];
+    }
+
+    for (const bool is_inverse: { false, true }) {
+        ReferenceDFT(x.data(), y_ref.data(), N, is_inverse);
+        auto transform = is_inverse ? CalculateIFFT : CalculateFFT;
+
+        transform(tcb::span(x.data(), N), tcb::span(y.data(), N));
+        double error = GetRelativeError(y.data(), y_ref.data(), N);
+        // out of place transforms shouldn't modify their input
+        for (int i = 0; i < N; i++) {
+            if (x[i] != x_copy[i]) {
+                error = INFINITY;
+            }
+        }
+        total_failed += ReportCheck(is_inverse ? "fft/c32/inverse" : "fft/c32/forward", N, error, SELF_CHECK_FFT_TOLERANCE) ? 0 : 1;
+
+        for (int i = 0; i < N; i++) {
+            y[i] = x[i];
+        }
+        transform(tcb::span(y.data(), N), tcb::span(y.data(), N));
+        error = GetRelativeError(y.data(), y_ref.data(), N);
+        total_failed += ReportCheck(is_inverse ? "fft/c32/inverse/in_place" : "fft/c32/forward/in_place", N, error, SELF_CHECK_FFT_TOLERANCE) ? 0 : 1;
+    }
+    return total_failed;
+}
+
+// Real transforms are checked against the complex reference
+// The inverse isn't scaled by 1/N so it should return N*x
+static int CheckRealFFT(const int N) {
+    int total_failed = 0;
+    const int M = N/2+1;
+    AlignedVector<float> x(N);
+    AlignedVector<std::complex<float>> x_complex(N);
+    AlignedVector<std::complex<float>> X(M);
+    // in place buffers hold N real samples or N/2+1 bins
+    AlignedVector<std::complex<float>> z(M);
+    AlignedVector<float> y(N);
+    std::vector<std::complex<double>> X_ref(N);
+    std::vector<std::complex<double>> y_ref(N);
+    FillRandom(x.data(), N, (uint32_t)N);
+    for (int i = 0; i < N; i++) {
+        x_complex[i] = x[i];
+        y_ref[i] = (double)N * (double)x[i];
+    }
+    ReferenceDFT(x_complex.data(), X_ref.data(), N, false);
+
+    CalculateRealFFT(tcb::span(x.data(), N), tcb::span(X.data(), M));
+    double error = GetRelativeError(X.data(), X_ref.data(), M);
+    total_failed += ReportCheck("fft/f32/forward", N, error, SELF_CHECK_FFT_TOLERANCE) ? 0 : 1;
+
+    auto* z_real = reinterpret_cast<float*>(z.data());
+    for (int i = 0; i < N; i++) {
+        z_real[i] = x[i];
+    }
+    CalculateRealFFT(tcb::span(z_real, N), tcb::span(z.data(), M));
+    error = GetRelativeError(z.data(), X_ref.data(), M);
+    total_failed += ReportCheck("fft/f32/forward/in_place", N, error, SELF_CHECK_FFT_TOLERANCE) ? 0 : 1;
+
+    // NOTE: The inverse uses its input as scratch memory
+    for (int i = 0; i < M; i++) {
+        z[i] = X[i];
+    }
+    CalculateRealIFFT(tcb::span(z.data(), M), tcb::span(y.data(), N));
+    error = GetRelativeError(y.data(), y_ref.data(), N);
+    total_failed += ReportCheck("fft/f32/inverse", N, error, SELF_CHECK_FFT_TOLERANCE) ? 0 : 1;
+
+    for (int i = 0; i < M; i++) {
+        z[i] = X[i];
+    }
+    CalculateRealIFFT(tcb::span(z.data(), M), tcb::span(z_real, N));
+    error = GetRelativeError(z_real, y_ref.data(), N);
+    total_failed += ReportCheck("fft/f32/inverse/in_place", N, error, SELF_CHECK_FFT_TOLERANCE) ? 0 : 1;
+    return total_failed;
+}
+
+// Least recently used entries are evicted once there are more than max_size
+static int CheckLRUCache() {
+    int total_failed = 0;
+    LRU_Cache<int, int> cache(2);
+    cache.emplace(1, 10);
+    cache.emplace(2, 20);
+    // finding 1 makes 2 the least recently used
+    const int* v1 = cache.find(1);
+    cache.emplace(3, 30);
+    int errors = 0;
+    errors += ((v1 == NULL) || (*v1 != 10)) ? 1 : 0;
+    errors += (cache.find(2) != NULL) ? 1 : 0;
+    errors += (cache.find(1) != v1) ? 1 : 0;
+    errors += ((cache.find(3) == NULL) || (*cache.find(3) != 30)) ? 1 : 0;
+    errors += (std::distance(cache.begin(), cache.end()) != 2) ? 1 : 0;
+    total_failed += ReportCheck("lru_cache/evict_lru", 2, (double)errors, 0.0) ? 0 : 1;
+
+    // shrinking keeps the most recently used entries
+    cache.set_max_size(1);
+    errors = 0;
+    errors += (cache.find(1) != NULL) ? 1 : 0;
+    errors += (cache.find(3) == NULL) ? 1 : 0;
+    errors += (std::distance(cache.begin(), cache.end()) != 1) ? 1 : 0;
+    total_failed += ReportCheck("lru_cache/set_max_size", 1, (double)errors, 0.0) ? 0 : 1;
+    return total_failed;
+}
+
+// Cached plans are reused for the same length
+// After being evicted by other lengths a rebuilt plan should still be correct
+static int CheckFFTPlanCache(const int N) {
+    int total_failed = 0;
+    const int errors = 
+        ((&GetFFTPlan(N) != &GetFFTPlan(N)) ? 1 : 0) + 
+        ((&GetRealFFTPlan(N) != &GetRealFFTPlan(N)) ? 1 : 0);
+    total_failed += ReportCheck("fft/plan_cache/reuse", N, (double)errors, 0.0) ? 0 : 1;
+
+    for (int i = 1; i <= FFT_PLAN_CACHE_SIZE; i++) {
+        GetFFTPlan(N+2*i);
+        GetRealFFTPlan(N+2*i);
+    }
+    total_failed += CheckComplexFFT(N);
+    total_failed += CheckRealFFT(N);
+    return total_failed;
+}
+
+int RunSelfChecks() {
+    fprintf(stdout, "simd=%s\n", GetSIMDName());
+    fprintf(stdout, "%-40s %8s %12s %s\n", "name", "N", "error", "result");
+
+    int total_failed = 0;
+    // Powers of 2 use the radix-4 stages with a radix-2 stage when log2(N) is odd
+    // Other lengths go through Bluestein's algorithm
+    const int fft_sizes[] = { 1, 2, 4, 8, 32, 256, 2048, 3, 5, 6, 12, 100, 243, 1000, 1536 };
+    for (const int N: fft_sizes) {
+        total_failed += CheckComplexFFT(N);
+    }
+    const int real_fft_sizes[] = { 2, 4, 8, 64, 512, 6, 10, 24, 100, 1000, 1536 };
+    for (const int N: real_fft_sizes) {
+        total_failed += CheckRealFFT(N);
+    }
+
+    total_failed += CheckLRUCache();
+    total_failed += CheckFFTPlanCache(64);
+    total_failed += CheckFFTPlanCache(100);
+
+    fprintf(stdout, "%d checks failed\n", total_failed);
+    return total_failed;
+}
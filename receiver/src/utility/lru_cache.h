@@ -39,9 +39,9 @@ public:
     T& insert(K key, T&& val) {
         auto res = cache.find(key);
         if (res == cache.end()) {
-            remove_lru();
             lru_list.push_front({key, val});
             res = cache.insert({key, lru_list.begin()}).first; 
+            remove_lru();
         }
         auto it = res->second;
         promote(it);
@@ -52,13 +52,14 @@ public:
     T& emplace(K key, U&& ... args) {
         auto res = cache.find(key);
         if (res == cache.end()) {
-            remove_lru();
             // std::pair has the following constructor signature
             lru_list.emplace_front(
                 std::piecewise_construct, 
                 std::forward_as_tuple(key), 
                 std::forward_as_tuple(std::forward<U>(args)...));
             res = cache.insert({key, lru_list.begin()}).first; 
+            // the new entry is at the front so it is kept as long as max_size > 0
+            remove_lru();
         }
         auto it = res->second;
         promote(it);
@@ -75,7 +76,7 @@ public:
 private:
     // cull list elements past max size
     void remove_lru(void) {
-        if (lru_list.size() <= max_size) {
+        if (lru_list.size() <= (size_t)max_size) {
             return;
         }
 
@@ -6,6 +6,7 @@
 #include <chrono>
 #include <thread>
 #include <mutex>
+#include <string.h>
 
 // Crossplatform pretty function
 #ifdef _MSC_VER
@@ -46,6 +47,13 @@ public:
         profile_trace_t trace;
     };
     typedef std::unordered_map<uint64_t, TraceLog> profile_trace_logger_t;
+    // Total time spent in each named timer since the thread started
+    struct StageTotal {
+        int stack_index = 0;
+        int count = 0;
+        int64_t total_micros = 0;
+    };
+    typedef std::vector<std::pair<const char*, StageTotal>> profile_totals_t;
 private:
     const char* label = "";
     uint64_t data = 0;
@@ -65,8 +73,12 @@ private:
     // in profiling each of these possible variations
     profile_trace_logger_t profiler_logger;
 
+    // Kept in order of first appearance
+    profile_totals_t stage_totals;
+
     std::mutex mutex_prev_results;
     std::mutex mutex_profiler_logger;
+    std::mutex mutex_stage_totals;
 public:
     InstrumentorThread() {
         results.reserve(200);
@@ -81,6 +93,7 @@ public:
     }
 
     void WriteProfile(ProfileResult&& res, int result_index) {
+        UpdateTotals(res);
         results[result_index] = res;
         PopStackIndex();
     }
@@ -89,6 +102,8 @@ public:
     auto& GetPrevTraceMutex() { return mutex_prev_results; }
     auto& GetTraceLogs() { return profiler_logger; }
     auto& GetTraceLogsMutex() { return mutex_profiler_logger; }
+    auto& GetStageTotals() { return stage_totals; }
+    auto& GetStageTotalsMutex() { return mutex_stage_totals; }
 
     const char* GetLabel() const { return label; }
     void SetLabel(const char* _label) { label = _label; }
@@ -110,6 +125,23 @@ private:
 
         return stack_index;
     }
+    void UpdateTotals(const ProfileResult& res) {
+        auto lock = std::scoped_lock(mutex_stage_totals);
+        // NOTE: Identical string literals in different translation units can have different addresses
+        //       So we only use the pointer as a fast path before comparing the contents
+        auto it = stage_totals.begin();
+        for (; it != stage_totals.end(); it++) {
+            if ((it->first == res.name) || (strcmp(it->first, res.name) == 0)) break;
+        }
+        if (it == stage_totals.end()) {
+            stage_totals.push_back({res.name, {}});
+            it = stage_totals.end()-1;
+        }
+        auto& total = it->second;
+        total.stack_index = res.stack_index;
+        total.count++;
+        total.total_micros += (res.end - res.start);
+    }
     void UpdateResults() {
         if (is_trace_logging) {
             auto lock = std::scoped_lock(mutex_profiler_logger);
@@ -153,6 +185,8 @@ class Instrumentor
 private:
     std::unordered_map<std::thread::id, InstrumentorThread> threads;
     std::vector<std::pair<std::thread::id, InstrumentorThread&>> threads_ref_list;
+    // threads register themselves concurrently on their first timer
+    std::mutex mutex_threads;
     int64_t base_dt;
 private:
     Instrumentor()
@@ -162,6 +196,7 @@ private:
     }
 public:
     InstrumentorThread& GetInstrumentorThread(std::thread::id id) {
+        auto lock = std::scoped_lock(mutex_threads);
         auto res = threads.find(id);
         if (res == threads.end()) {
             // threads.emplace(id);
@@ -171,12 +206,22 @@ public:
         }
         return res->second;
     }
+    // The entry of the calling thread is cached so that only its first lookup takes the lock
+    // NOTE: Entries of an unordered_map aren't moved when it rehashes
     InstrumentorThread& GetInstrumentorThread(void) {
-        return GetInstrumentorThread(std::this_thread::get_id());
+        thread_local InstrumentorThread* thread = NULL;
+        if (thread == NULL) {
+            thread = &GetInstrumentorThread(std::this_thread::get_id());
+        }
+        return *thread;
     }
+    // Hold GetThreadsMutex() while reading the list since other threads can still register
     auto& GetThreadsList() {
         return threads_ref_list;
     }
+    auto& GetThreadsMutex() {
+        return mutex_threads;
+    }
     const auto& GetBase() {
         return base_dt;
     }
@@ -203,7 +248,7 @@ public:
     : name(_name), is_stopped(false)
     {
         thread_id = std::this_thread::get_id();
-        auto& thread = Instrumentor::Get().GetInstrumentorThread(thread_id);
+        auto& thread = Instrumentor::Get().GetInstrumentorThread();
         thread_ptr = &thread;
         auto res = thread_ptr->PushStackIndex();
         stack_index = res.first;
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Bounded single producer single consumer queue of preallocated slots
+// The producer acquires a free slot, fills it and then releases it to the consumer
+// The consumer acquires a filled slot, reads it and then releases it back to the producer
+// Slots are never moved or copied, so large buffers can be passed between threads without allocation
+// The Try* calls are lock free, while the blocking acquires spin briefly and then sleep until a slot is released
+// NOTE: Only one thread can be the producer and only one thread can be the consumer
+template <typename T>
+class SPSC_Queue
+{
+private:
+    std::vector<std::unique_ptr<T>> slots;
+    const size_t nb_slots;
+    // Indices are monotonic and wrap around the slot count when accessing
+    // We keep them on separate cache lines so producer and consumer don't false share
+    alignas(64) std::atomic<size_t> wr_index;
+    alignas(64) std::atomic<size_t> rd_index;
+    alignas(64) std::atomic<bool> is_closed;
+    // Blocking acquires sleep here once they have spun for a while
+    // Releases only take the lock when a thread has registered itself as waiting
+    alignas(64) std::atomic<int> nb_waiters;
+    std::mutex mutex_wait;
+    std::condition_variable cv_wait;
+    // Number of times a blocking acquire polls before going to sleep
+    static constexpr int MAX_SPIN_COUNT = 64;
+public:
+    // Construct each slot in place using the provided arguments
+    template <typename ... U>
+    SPSC_Queue(const size_t _nb_slots, U&& ... args)
+    : nb_slots(_nb_slots)
+    {
+        slots.reserve(nb_slots);
+        for (size_t i = 0; i < nb_slots; i++) {
+            slots.push_back(std::make_unique<T>(args...));
+        }
+        wr_index = 0;
+        rd_index = 0;
+        is_closed = false;
+        nb_waiters = 0;
+    }
+    SPSC_Queue(SPSC_Queue&) = delete;
+    SPSC_Queue(SPSC_Queue&&) = delete;
+    SPSC_Queue& operator=(SPSC_Queue&) = delete;
+    SPSC_Queue& operator=(SPSC_Queue&&) = delete;
+
+    size_t Capacity() const { return nb_slots; }
+    size_t Size() const {
+        return wr_index.load(std::memory_order_acquire) - rd_index.load(std::memory_order_acquire);
+    }
+    auto& GetSlots() { return slots; }
+
+    // Producer: return NULL if the queue is full
+    T* TryAcquireWrite() {
+        const size_t wr = wr_index.load(std::memory_order_relaxed);
+        const size_t rd = rd_index.load(std::memory_order_acquire);
+        if ((wr-rd) >= nb_slots) {
+            return NULL;
+        }
+        return slots[wr % nb_slots].get();
+    }
+    // Producer: publish the slot returned by TryAcquireWrite()
+    void ReleaseWrite() {
+        // NOTE: Sequentially consistent so that this is ordered with the load of nb_waiters
+        wr_index.fetch_add(1, std::memory_order_seq_cst);
+        NotifyWaiters();
+    }
+
+    // Consumer: return NULL if the queue is empty
+    T* TryAcquireRead() {
+        const size_t rd = rd_index.load(std::memory_order_relaxed);
+        const size_t wr = wr_index.load(std::memory_order_acquire);
+        if (rd == wr) {
+            return NULL;
+        }
+        return slots[rd % nb_slots].get();
+    }
+    // Consumer: return the slot returned by TryAcquireRead() back to the producer
+    void ReleaseRead() {
+        rd_index.fetch_add(1, std::memory_order_seq_cst);
+        NotifyWaiters();
+    }
+
+    // Wait until we get a slot or the queue is closed
+    T* AcquireWrite() {
+        return Acquire([this]() { return TryAcquireWrite(); });
+    }
+
+    // Wait until we get a slot, or the queue is closed and fully drained
+    T* AcquireRead() {
+        auto* slot = Acquire([this]() { return TryAcquireRead(); });
+        if (slot == NULL) {
+            // Producer may have published a slot right before closing
+            return TryAcquireRead();
+        }
+        return slot;
+    }
+
+    // Signal that no more slots will be produced or consumed
+    void Close() {
+        is_closed.store(true, std::memory_order_seq_cst);
+        NotifyWaiters();
+    }
+    bool IsClosed() const { return is_closed.load(std::memory_order_acquire); }
+    void Reset() {
+        wr_index = 0;
+        rd_index = 0;
+        is_closed = false;
+    }
+private:
+    // Yield for a bounded number of polls since the other side is usually only a moment away
+    // Then sleep so that a stalled pipeline doesn't burn a core
+    template <typename F>
+    T* Acquire(F&& try_acquire) {
+        for (int i = 0; i < MAX_SPIN_COUNT; i++) {
+            auto* slot = try_acquire();
+            if (slot != NULL) {
+                return slot;
+            }
+            if (is_closed.load(std::memory_order_acquire)) {
+                return NULL;
+            }
+            std::this_thread::yield();
+        }
+
+        T* slot = NULL;
+        // NOTE: Registering before checking the indices means a release either sees us waiting
+        //       or happened early enough for us to see its slot, so the wakeup can't be lost
+        nb_waiters.fetch_add(1, std::memory_order_seq_cst);
+        {
+            auto lock = std::unique_lock(mutex_wait);
+            cv_wait.wait(lock, [this, &slot, &try_acquire]() {
+                slot = try_acquire();
+                return (slot != NULL) || is_closed.load(std::memory_order_seq_cst);
+            });
+        }
+        nb_waiters.fetch_sub(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    void NotifyWaiters() {
+        if (nb_waiters.load(std::memory_order_seq_cst) == 0) {
+            return;
+        }
+        // Taking the lock means the waiter is either before its check or already asleep
+        {
+            auto lock = std::scoped_lock(mutex_wait);
+        }
+        cv_wait.notify_all();
+    }
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads which run the iterations of a parallel for loop
+// The calling thread also runs iterations while it waits for the loop to finish
+// NOTE: This is intended for a small number of long running tasks, e.g. one per receiver channel
+class ThreadPool
+{
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable cv_start;
+    std::condition_variable cv_done;
+    const std::function<void(int)>* task = NULL;
+    int nb_tasks = 0;
+    int next_task = 0;
+    int nb_finished = 0;
+    bool is_running = true;
+public:
+    // nb_threads = number of worker threads not including the calling thread
+    ThreadPool(const int nb_threads) {
+        threads.reserve(nb_threads);
+        for (int i = 0; i < nb_threads; i++) {
+            threads.emplace_back([this]() {
+                auto lock = std::unique_lock(mutex);
+                while (true) {
+                    cv_start.wait(lock, [this]() {
+                        return !is_running || (next_task < nb_tasks);
+                    });
+                    if (!is_running) {
+                        return;
+                    }
+                    RunTask(lock);
+                }
+            });
+        }
+    }
+    ~ThreadPool() {
+        {
+            auto lock = std::scoped_lock(mutex);
+            is_running = false;
+        }
+        cv_start.notify_all();
+        for (auto& thread: threads) {
+            thread.join();
+        }
+    }
+    // Run fn(i) for i = [0,N) and wait until all of them are finished
+    void ParallelFor(const int N, const std::function<void(int)>& fn) {
+        auto lock = std::unique_lock(mutex);
+        task = &fn;
+        nb_tasks = N;
+        next_task = 0;
+        nb_finished = 0;
+        cv_start.notify_all();
+
+        while (next_task < nb_tasks) {
+            RunTask(lock);
+        }
+        cv_done.wait(lock, [this]() {
+            return nb_finished == nb_tasks;
+        });
+
+        task = NULL;
+        nb_tasks = 0;
+        next_task = 0;
+    }
+    int GetTotalThreads() const { return (int)threads.size(); }
+private:
+    // Claim the next task and run it without holding the lock
+    void RunTask(std::unique_lock<std::mutex>& lock) {
+        const int i = next_task++;
+        auto& fn = *task;
+        lock.unlock();
+        fn(i);
+        lock.lock();
+        nb_finished++;
+        if (nb_finished == nb_tasks) {
+            cv_done.notify_all();
+        }
+    }
+};
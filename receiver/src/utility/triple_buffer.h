@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+// Lock free triple buffer for passing the latest value from one producer to one consumer
+// The producer fills its back slot and swaps it with the middle slot
+// The consumer swaps its front slot with the middle slot if a newer one was published
+// Neither side ever waits and each side owns its slot exclusively so reads never tear
+// Values the consumer didn't get to in time are overwritten by newer ones
+// NOTE: Only one thread can be the producer and only one thread can be the consumer
+template <typename T>
+class TripleBuffer
+{
+private:
+    // state = [dirty bit][middle index : 2 bits]
+    static constexpr uint8_t DIRTY_BIT = 0b100;
+    static constexpr uint8_t INDEX_MASK = 0b011;
+    std::unique_ptr<T> slots[3];
+    alignas(64) std::atomic<uint8_t> state;
+    // owned by the producer
+    alignas(64) uint8_t back_index;
+    // owned by the consumer
+    alignas(64) uint8_t front_index;
+public:
+    // Construct each slot in place using the provided arguments
+    template <typename ... U>
+    TripleBuffer(U&& ... args) {
+        for (int i = 0; i < 3; i++) {
+            slots[i] = std::make_unique<T>(args...);
+        }
+        front_index = 0;
+        state = 1;
+        back_index = 2;
+    }
+    TripleBuffer(TripleBuffer&) = delete;
+    TripleBuffer(TripleBuffer&&) = delete;
+    TripleBuffer& operator=(TripleBuffer&) = delete;
+    TripleBuffer& operator=(TripleBuffer&&) = delete;
+
+    // Producer: slot to fill
+    T& GetBack() { return *slots[back_index]; }
+    // Producer: make the back slot the newest value
+    void Publish() {
+        const uint8_t prev = state.exchange(back_index | DIRTY_BIT, std::memory_order_acq_rel);
+        back_index = prev & INDEX_MASK;
+    }
+
+    // Consumer: return true if a newer value was swapped into the front slot
+    bool Update() {
+        if ((state.load(std::memory_order_relaxed) & DIRTY_BIT) == 0) {
+            return false;
+        }
+        const uint8_t prev = state.exchange(front_index, std::memory_order_acq_rel);
+        front_index = prev & INDEX_MASK;
+        return true;
+    }
+    // Consumer: latest value acquired by Update()
+    const T& GetFront() const { return *slots[front_index]; }
+};
@@ -36,9 +36,11 @@ struct Renderer {
     struct AppRenderState {
         QAM_Synchroniser_Specification original_qam_sync_spec;
         int shared_block_size;
-        QAM_Synchroniser_Buffer* render_buffer;
+        // stop taking new telemetry frames so the current one can be inspected
+        bool is_frozen;
         ImPlotRange xrange_audio_buffer;
         ImPlotRange xrange_dsp_buffers;
+        ImPlotRange yrange_raw_buffer;          // raw unsigned 8bit IQ
         ImPlotRange yrange_input_buffer;        // baseband input
         ImPlotRange yrange_ds_input_buffer;     // AGC normalises to -1...+1
     } app_render_state;
@@ -52,9 +54,10 @@ struct Renderer {
             const double audio_block_size = (double)app.GetAudioFilter().GetOutputBufferSize();
             s.original_qam_sync_spec = app.qam_sync_spec;
             s.shared_block_size = shared_block_size;
-            s.render_buffer = &(app.GetActiveBuffer());
+            s.is_frozen = false;
             s.xrange_audio_buffer = {0, audio_block_size};
             s.xrange_dsp_buffers = {0, (double)shared_block_size};
+            s.yrange_raw_buffer = {0, 256};
             s.yrange_input_buffer = {-128, 128};
             s.yrange_ds_input_buffer = {-1.25, 1.25};
         }
@@ -149,19 +152,15 @@ int main(int argc, char** argv)
     }
 
     // app startup
-    FILE* fp_in = stdin;
-    if (rd_filename != NULL) {
-        errno_t err = fopen_s(&fp_in, rd_filename, "r");
-        if (err != 0) {
-            LOG_MESSAGE("Failed to open file for reading\n");
-            return 1;
-        }
+    auto rx_reader = CreateRawIQ_Reader(rd_filename);
+    if (rx_reader == nullptr) {
+        LOG_MESSAGE("Failed to open file for reading\n");
+        return 1;
     }
 
 #if defined(_WIN32)
     // NOTE: Windows does extra translation stuff that messes up the file if this isn't done
     // https://docs.microsoft.com/en-us/cpp/c-runtime-library/reference/setmode?view=msvc-170
-    _setmode(_fileno(fp_in), _O_BINARY);
     _setmode(_fileno(stdout), _O_BINARY);
 #endif
 
@@ -170,7 +169,7 @@ int main(int argc, char** argv)
     const int decoder_buffer_size = 1024;
 
     auto app = App(
-        fp_in, demod_block_size, 
+        std::move(rx_reader), demod_block_size, 
         decoder_buffer_size, ds_factor, us_factor, 
         audio_buffer_size, Faudio);
 
@@ -237,7 +236,6 @@ int main(int argc, char** argv)
     const auto rv = RenderAll(renderer);
     app.Stop();
     demod_thread.join();
-    fclose(fp_in);
 
     return rv;
 }
@@ -439,15 +437,29 @@ int RenderAll(Renderer& renderer) {
 }
 
 void RenderApp(App& app, Renderer::AppRenderState& state) {
-    // swap between live and snapshot buffer
-    auto* active_buffer = &(app.GetActiveBuffer());
-    auto* snapshot_buffer = &(app.GetSnapshotBuffer());
+    // telemetry is published by the demodulator thread without waiting for us
+    auto& telemetry = app.GetTelemetry();
+    if (!state.is_frozen) {
+        telemetry.Update();
+    }
+    const auto& frame = telemetry.GetFrame();
 
     auto get_xscale = [&state](const int N) -> double {
         const double x = (double)state.shared_block_size / (double)N;
         return x;
     };
 
+    // [min,max] pairs are drawn as one line which fills in the envelope of each bucket
+    auto plot_trace = [&get_xscale](const char* label, const MinMax_Trace& trace) {
+        const int N = trace.GetTotalPoints();
+        ImPlot::PlotLine(label, trace.data.data(), N, get_xscale(N));
+    };
+    // a bucket is triggered if any sample in it was triggered
+    auto plot_trigger = [&get_xscale](const char* label, const MinMax_Trace& trace) {
+        const int N = trace.GetTotalBuckets();
+        ImPlot::PlotStems(label, &trace.data[1], N, 0.0, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
+    };
+
     ImGui::Begin("PCM 16Bit Buffer");
     if (ImPlot::BeginPlot("##Audio buffer")) {
         auto& audio_filter = app.GetAudioFilter();
@@ -464,15 +476,13 @@ void RenderApp(App& app, Renderer::AppRenderState& state) {
     ImGui::End();
 
     if (ImGui::Begin("Controls")) {
-        const bool is_rendering_snapshot = (state.render_buffer == snapshot_buffer);
-        if (!is_rendering_snapshot) {
+        if (!state.is_frozen) {
             if (ImGui::Button("Snapshot")) {
-                app.controls.snapshot = true;
-                state.render_buffer = snapshot_buffer;
+                state.is_frozen = true;
             }
         } else {
             if (ImGui::Button("Resume")) {
-                state.render_buffer = active_buffer;
+                state.is_frozen = false;
             }
         }
 
@@ -507,16 +517,14 @@ void RenderApp(App& app, Renderer::AppRenderState& state) {
         ImPlot::SetupAxisLimits(ImAxis_Y1, -2, 2, ImPlotCond_Once);
         const float marker_size = 3.0f;
         {
-            const auto buf = state.render_buffer->y_sym_out;
-            const int N = (int)buf.size();
-            auto* data = reinterpret_cast<float*>(buf.data());
+            const int N = frame.total_symbols;
+            auto* data = reinterpret_cast<const float*>(frame.y_out.data());
             ImPlot::SetNextMarkerStyle(0, marker_size);
             ImPlot::PlotScatter("IQ demod", &data[0], &data[1], N, 0, 0, 2*sizeof(float));
         }
         {
-            const auto buf = state.render_buffer->x_pll_out;
-            const int N = (int)buf.size();
-            auto* data = reinterpret_cast<float*>(buf.data());
+            const int N = frame.total_pll_points;
+            auto* data = reinterpret_cast<const float*>(frame.x_pll_out.data());
             ImPlot::HideNextItem(true, ImPlotCond_Once);
             ImPlot::SetNextMarkerStyle(0, marker_size);
             ImPlot::PlotScatter("IQ raw", &data[0], &data[1], N, 0, 0, 2*sizeof(float));
@@ -527,86 +535,61 @@ void RenderApp(App& app, Renderer::AppRenderState& state) {
 
     ImGui::Begin("Symbol out");
     if (ImPlot::BeginPlot("Symbol out")) {
-        auto buf = state.render_buffer->y_sym_out;
-        const int N = (int)buf.size();
-        auto* data = reinterpret_cast<float*>(buf.data());
         ImPlot::SetupAxisLinks(ImAxis_X1, &state.xrange_dsp_buffers.Min, &state.xrange_dsp_buffers.Max);
         ImPlot::SetupAxisLinks(ImAxis_Y1, &state.yrange_ds_input_buffer.Min, &state.yrange_ds_input_buffer.Max);
-        ImPlot::PlotLine("I", &data[0], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
-        ImPlot::PlotLine("Q", &data[1], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
+        plot_trace("I", frame.y_sym_out_I);
+        plot_trace("Q", frame.y_sym_out_Q);
         ImPlot::EndPlot();
     }
     if (ImPlot::BeginPlot("PLL out")) {
-        auto buf = state.render_buffer->x_pll_out;
-        const int N = (int)buf.size();
-        auto* data = reinterpret_cast<float*>(buf.data());
         ImPlot::SetupAxisLinks(ImAxis_X1, &state.xrange_dsp_buffers.Min, &state.xrange_dsp_buffers.Max);
         ImPlot::SetupAxisLinks(ImAxis_Y1, &state.yrange_ds_input_buffer.Min, &state.yrange_ds_input_buffer.Max);
-        ImPlot::PlotLine("I", &data[0], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
-        ImPlot::PlotLine("Q", &data[1], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
+        plot_trace("I", frame.x_pll_out_I);
+        plot_trace("Q", frame.x_pll_out_Q);
         ImPlot::EndPlot();
     }
     if (ImPlot::BeginPlot("Upsampled")) {
-        auto buf = state.render_buffer->x_upsampled;
-        const int N = (int)buf.size();
-        auto* data = reinterpret_cast<float*>(buf.data());
         ImPlot::SetupAxisLinks(ImAxis_X1, &state.xrange_dsp_buffers.Min, &state.xrange_dsp_buffers.Max);
         ImPlot::SetupAxisLinks(ImAxis_Y1, &state.yrange_ds_input_buffer.Min, &state.yrange_ds_input_buffer.Max);
-        ImPlot::PlotLine("I", &data[0], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
-        ImPlot::PlotLine("Q", &data[1], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
+        plot_trace("I", frame.x_upsampled_I);
+        plot_trace("Q", frame.x_upsampled_Q);
         ImPlot::EndPlot();
     }
     ImGui::End();
 
     ImGui::Begin("Raw signals");
     if (ImPlot::BeginPlot("Raw Signal")) {
-        auto buf = state.render_buffer->x_in;
-        const int N = (int)buf.size();
-        auto* data = reinterpret_cast<float*>(buf.data());
         ImPlot::SetupAxisLinks(ImAxis_X1, &state.xrange_dsp_buffers.Min, &state.xrange_dsp_buffers.Max);
-        ImPlot::SetupAxisLinks(ImAxis_Y1, &state.yrange_input_buffer.Min, &state.yrange_input_buffer.Max);
-        ImPlot::PlotLine("I", &data[0], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
-        ImPlot::PlotLine("Q", &data[1], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
+        ImPlot::SetupAxisLinks(ImAxis_Y1, &state.yrange_raw_buffer.Min, &state.yrange_raw_buffer.Max);
+        plot_trace("I", frame.x_raw_I);
+        plot_trace("Q", frame.x_raw_Q);
         ImPlot::EndPlot();
     }
     if (ImPlot::BeginPlot("Downsampled signal")) {
-        auto buf = state.render_buffer->x_downsampled;
-        const int N = (int)buf.size();
-        auto* data = reinterpret_cast<float*>(buf.data());
         ImPlot::SetupAxisLinks(ImAxis_X1, &state.xrange_dsp_buffers.Min, &state.xrange_dsp_buffers.Max);
         ImPlot::SetupAxisLinks(ImAxis_Y1, &state.yrange_input_buffer.Min, &state.yrange_input_buffer.Max);
-        ImPlot::PlotLine("I", &data[0], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
-        ImPlot::PlotLine("Q", &data[1], N, get_xscale(N), 0.0, 0, 0, 2*sizeof(float));
+        plot_trace("I", frame.x_downsampled_I);
+        plot_trace("Q", frame.x_downsampled_Q);
         ImPlot::EndPlot();
     }
     ImGui::End();
 
     ImGui::Begin("Errors");
     if (ImPlot::BeginPlot("##Errors")) {
-        auto buf0 = state.render_buffer->error_pll;
-        auto buf1 = state.render_buffer->error_ted;
-        const int N0 = (int)buf0.size();
-        const int N1 = (int)buf1.size();
         ImPlot::SetupAxisLinks(ImAxis_X1, &state.xrange_dsp_buffers.Min, &state.xrange_dsp_buffers.Max);
-        ImPlot::PlotLine("PLL error", buf0.data(), N0, get_xscale(N0));
-        ImPlot::PlotLine("TED error", buf1.data(), N1, get_xscale(N1));
+        plot_trace("PLL error", frame.error_pll);
+        plot_trace("TED error", frame.error_ted);
         ImPlot::EndPlot();
     }
     ImGui::End();
 
     ImGui::Begin("Triggers");
     if (ImPlot::BeginPlot("##Triggers")) {
-        auto buf0 = state.render_buffer->trig_zero_crossing;
-        auto buf1 = state.render_buffer->trig_ted_clock;
-        auto buf2 = state.render_buffer->trig_integrator_dump;
-        const int N0 = (int)buf0.size();
-        const int N1 = (int)buf1.size();
-        const int N2 = (int)buf2.size();
         ImPlot::SetupAxisLinks(ImAxis_X1, &state.xrange_dsp_buffers.Min, &state.xrange_dsp_buffers.Max);
         ImPlot::SetupAxisLimits(ImAxis_Y1, -0.2, 1.5, ImPlotCond_Once);
-        ImPlot::PlotStems("Zero crossing", (uint8_t*)buf0.data(), N0, 0.0f, get_xscale(N0));
-        ImPlot::PlotStems("Ramp oscillator", (uint8_t*)buf1.data(), N1, 0.0f, get_xscale(N1));
-        ImPlot::PlotStems("Integrate+dump", (uint8_t*)buf2.data(), N2, 0.0f, get_xscale(N2));
+        plot_trigger("Zero crossing", frame.trig_zero_crossing);
+        plot_trigger("Ramp oscillator", frame.trig_ted_clock);
+        plot_trigger("Integrate+dump", frame.trig_integrator_dump);
         ImPlot::EndPlot();
     }
     ImGui::End();
@@ -617,11 +600,16 @@ void RenderApp(App& app, Renderer::AppRenderState& state) {
         const float A = 100e3;
         const float B = 10e3;
         const float C = 10e3;
+        ImGui::Checkbox("Squelch", &spec.squelch.is_enabled);
+        ImGui::SliderFloat("Squelch open (dB)", &spec.squelch.threshold_open, -80.0f, 0.0f);
+        ImGui::SliderFloat("Squelch close (dB)", &spec.squelch.threshold_close, -80.0f, spec.squelch.threshold_open);
         ImGui::SliderInt("Downsampling filter size", &spec.downsampling_filter.K, 2, 20);
         ImGui::SliderInt("Upsampling filter size", &spec.upsampling_filter.K, 2, 20);
         ImGui::SliderFloat("AC Filter", &spec.ac_filter.k, 0.9999f, 1.0f);
         ImGui::SliderFloat("AGC beta", &spec.agc.beta, 0.0f, 1.0f);
+        ImGui::SliderInt("AGC block size", &spec.agc.block_size, 0, 4096);
         ImGui::SliderFloat("Carrier PLL Fcenter", &spec.carrier_pll.f_center, -B, B);
+        ImGui::Checkbox("Carrier offset estimator", &spec.carrier_estimator.is_enabled);
         ImGui::SliderFloat("Carrier PLL Fgain", &spec.carrier_pll.f_gain, 0e3, A);
         ImGui::SliderFloat("Carrier PLL Filter Cutoff", &spec.carrier_pll_filter.butterworth_cutoff, 0e3, A);
         ImGui::SliderFloat("Carrier PLL Filter Integrator", &spec.carrier_pll_filter.integrator_gain, 0e3, C);
@@ -682,8 +670,8 @@ void RenderPortAudioControls(PaDeviceList& device_list, PortAudio_Output& audio_
 
     bool is_muted = (volume_gain == 0.0f);
     const float max_gain = is_overgain ? 6.0f : 2.0f;
-    if (!is_overgain) {
-        volume_gain = (volume_gain > max_gain) ? max_gain : volume_gain;
+    if (!is_overgain && (volume_gain > max_gain)) {
+        volume_gain = max_gain;
     }
 
     ImGui::PushItemWidth(-1.0f);
@@ -717,4 +705,7 @@ void RenderPortAudioControls(PaDeviceList& device_list, PortAudio_Output& audio_
     if (ImGui::Button(is_overgain ? "Normal gain" : "Boost gain")) {
         is_overgain = !is_overgain;
     }
+
+    ImGui::Text("Underruns: %llu", (unsigned long long)mixer.GetTotalUnderruns());
+    ImGui::Text("Overruns: %llu", (unsigned long long)mixer.GetTotalOverruns());
 }
\ No newline at end of file